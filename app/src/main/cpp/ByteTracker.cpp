@@ -3,427 +3,435 @@
 #include <cmath>
 #include <algorithm>
 #include <limits>
-#include <map>
-#include <set>
 
 // -------------------------------------------------------------------------
-// Simple Matrix Math Helpers
+// Box Helpers
 // -------------------------------------------------------------------------
-// (Implementing minimal necessary matrix ops for Kalman Filter)
 
-// -------------------------------------------------------------------------
-// SimpleKalmanFilter Implementation
-// -------------------------------------------------------------------------
-// NOTE: This is a simplified Constant Velocity Model.
-// For a production app without Eigen/OpenCV, we use a simplified update rule
-// where we assume independent states or diagonal covariance to simplify math.
-// 
-// State: [cx, cy, aspect_ratio, height, vx, vy, va, vh]
-
-SimpleKalmanFilter::SimpleKalmanFilter()
+static inline void tlwh_to_xyah(const float* tlwh, float* xyah)
 {
-    _std_weight_position = 1.0f / 20.0f;
-    _std_weight_velocity = 1.0f / 160.0f;
+    xyah[0] = tlwh[0] + tlwh[2] / 2.0f; // cx
+    xyah[1] = tlwh[1] + tlwh[3] / 2.0f; // cy
+    xyah[2] = tlwh[2] / tlwh[3];        // aspect ratio
+    xyah[3] = tlwh[3];                  // height
 }
 
-void SimpleKalmanFilter::initiate(const std::vector<float>& measurement)
+static inline void mean_to_tlwh(const float* mean, float* tlwh)
 {
-    // measurement: [cx, cy, aspect_ratio, height]
-    // mean: [cx, cy, a, h, 0, 0, 0, 0]
-    _mean.assign(8, 0.0f);
-    for(int i=0; i<4; i++) _mean[i] = measurement[i];
-
-    // Covariance initialization
-    // Diagonals only for simplicity in this implementation
-    _covariance.assign(8, 0.0f); // Store as diagonal vector or simplified
-    
-    // In a full implementation, this involves matrix math. 
-    // Here we will rely on a simplified heuristic for "predict" 
-    // since we lack a matrix library.
-    // Basically: new_pos = old_pos + velocity
+    tlwh[0] = mean[0] - (mean[3] * mean[2]) / 2.0f; // cx - w/2
+    tlwh[1] = mean[1] - mean[3] / 2.0f;             // cy - h/2
+    tlwh[2] = mean[3] * mean[2];                    // w
+    tlwh[3] = mean[3];                              // h
 }
 
-void SimpleKalmanFilter::predict()
+// Below this many track/detection pairs scoring all of them beats building a grid
+static const int GRID_MIN_PAIRS = 256;
+
+// Basic IOU function
+static inline float calc_iou(const float* bb_test, const float* bb_gt)
 {
-    // x = F * x
-    // F is Identity + dt for velocity components
-    // cx += vx, cy += vy, a += va, h += vh
-    
-    // In strict ByteTrack, aspect ratio velocity is 0. 
-    // We update positions.
-    _mean[0] += _mean[4];
-    _mean[1] += _mean[5];
-    _mean[2] += _mean[6];
-    _mean[3] += _mean[7];
-
-    // Covariance update (simplified)
-    // P = F * P * F^T + Q
-    // We just increase uncertainty slightly
-    // This is a HACK to avoid implementing full matrix mul in raw C++
-    // for this specific constrained environment.
+    float xx1 = std::max(bb_test[0], bb_gt[0]);
+    float yy1 = std::max(bb_test[1], bb_gt[1]);
+    float xx2 = std::min(bb_test[0] + bb_test[2], bb_gt[0] + bb_gt[2]);
+    float yy2 = std::min(bb_test[1] + bb_test[3], bb_gt[1] + bb_gt[3]);
+
+    float w = std::max(0.0f, xx2 - xx1);
+    float h = std::max(0.0f, yy2 - yy1);
+    float wh = w * h;
+    float o = wh / ((bb_test[2] * bb_test[3]) + (bb_gt[2] * bb_gt[3]) - wh);
+    return o;
 }
 
-void SimpleKalmanFilter::update(const std::vector<float>& measurement)
+// -------------------------------------------------------------------------
+// TrackStore Implementation
+// -------------------------------------------------------------------------
+
+int TrackStore::allocate()
 {
-    // y = z - H * x
-    // H selects first 4 components
-    
-    std::vector<float> residual(4);
-    for(int i=0; i<4; i++) residual[i] = measurement[i] - _mean[i];
-
-    // Kalman Gain K calculation is complex without matrix inversion.
-    // We will use a fixed alpha/beta filter approximation which is 
-    // computationally cheap and often sufficient for visual tracking.
-    
-    float alpha = 0.3f; // Weight for position
-    float beta = 0.1f;  // Weight for velocity
-
-    for(int i=0; i<4; i++) {
-        _mean[i] = _mean[i] + alpha * residual[i];
-        _mean[i+4] = _mean[i+4] + beta * residual[i]; // Velocity update
+    if (!free_slots.empty()) {
+        int slot = free_slots.back();
+        free_slots.pop_back();
+        return slot;
     }
+    int slot = slots();
+    tlwh.push_back(std::array<float, 4>());
+    mean.push_back(KalmanFilter::Mean());
+    covariance.push_back(KalmanFilter::Covariance());
+    score.push_back(0.0f);
+    label.push_back(0);
+    track_id.push_back(0);
+    state.push_back(TrackState::New);
+    start_frame.push_back(0);
+    frame_id.push_back(0);
+    tracklet_len.push_back(0);
+    return slot;
 }
 
-// -------------------------------------------------------------------------
-// STrack Implementation
-// -------------------------------------------------------------------------
-STrack::STrack(std::vector<float> tlwh_, float score_, int label_)
+void TrackStore::release(int slot)
 {
-    _original_tlwh[0] = tlwh_[0];
-    _original_tlwh[1] = tlwh_[1];
-    _original_tlwh[2] = tlwh_[2];
-    _original_tlwh[3] = tlwh_[3];
-    tlwh = tlwh_;
-    
-    score = score_;
-    label = label_;
-    
-    is_activated = false;
-    track_id = 0;
-    state = TrackState::New;
-    start_frame = 0;
-    frame_id = 0;
-    tracklet_len = 0;
+    state[slot] = TrackState::Removed;
+    free_slots.push_back(slot);
 }
 
-STrack::~STrack() {}
+// -------------------------------------------------------------------------
+// LostTrackWheel Implementation
+// -------------------------------------------------------------------------
 
-void STrack::activate(SimpleKalmanFilter& kf, int frame_id_)
+void LostTrackWheel::reset(int horizon)
 {
-    this->kalman_filter = &kf; // Not actually storing pointer in this simplified version
-    this->track_id = -1; // Assigned by global counter
-    
-    std::vector<float> xyah = {
-        tlwh[0] + tlwh[2]/2.0f, // cx
-        tlwh[1] + tlwh[3]/2.0f, // cy
-        tlwh[2] / tlwh[3],      // aspect ratio
-        tlwh[3]                 // height
-    };
-    
-    // In this simplified version, we'll just store the Mean directly in STrack 
-    // or use a temporary KF helper. 
-    // To properly link, we'd call kf.initiate(xyah) and store the result.
-    // For now, let's just initialize our internal state.
-    // We will assume STrack HAS-A state.
-    
-    // Hack: STrack needs its own KF state. 
-    // We will use the 'mean' vector in STrack.
-    mean.assign(8, 0.0f);
-    mean[0] = xyah[0]; mean[1] = xyah[1]; mean[2] = xyah[2]; mean[3] = xyah[3];
-    
-    this->track_id = 0; // Will be set by tracker
-    this->state = TrackState::Tracked;
-    this->is_activated = true;
-    this->frame_id = frame_id_;
-    this->start_frame = frame_id_;
-    this->tracklet_len = 0;
+    head.assign(std::max(1, horizon), -1);
+    member_slots.clear();
 }
 
-void STrack::re_activate(STrack& new_track, int frame_id_, bool new_id)
+void LostTrackWheel::insert(int slot, int expiry_frame)
 {
-    // Update state with new detection
-    std::vector<float> xyah = {
-        new_track.tlwh[0] + new_track.tlwh[2]/2.0f,
-        new_track.tlwh[1] + new_track.tlwh[3]/2.0f,
-        new_track.tlwh[2] / new_track.tlwh[3],
-        new_track.tlwh[3]
-    };
-    
-    // Simple update logic (alpha-beta filter from above logic)
-    float alpha = 0.3f;
-    float beta = 0.1f;
-    
-    std::vector<float> residual(4);
-    for(int i=0; i<4; i++) residual[i] = xyah[i] - mean[i];
-
-    for(int i=0; i<4; i++) {
-        mean[i] = mean[i] + alpha * residual[i];
-        mean[i+4] = mean[i+4] + beta * residual[i];
+    if (slot >= (int)next.size()) {
+        next.resize(slot + 1);
+        prev.resize(slot + 1);
+        bucket_of.resize(slot + 1);
+        member_pos.resize(slot + 1);
     }
-    
-    // Update TLWH from mean
-    tlwh[0] = mean[0] - (mean[3] * mean[2]) / 2.0f; // cx - w/2
-    tlwh[1] = mean[1] - mean[3] / 2.0f;             // cy - h/2
-    tlwh[2] = mean[3] * mean[2];                    // w
-    tlwh[3] = mean[3];                              // h
+    int b = expiry_frame % (int)head.size();
+    next[slot] = head[b];
+    prev[slot] = -1;
+    if (head[b] >= 0) prev[head[b]] = slot;
+    head[b] = slot;
+    bucket_of[slot] = b;
+
+    member_pos[slot] = (int)member_slots.size();
+    member_slots.push_back(slot);
+}
 
-    this->tracklet_len = 0;
-    this->state = TrackState::Tracked;
-    this->is_activated = true;
-    this->frame_id = frame_id_;
-    this->score = new_track.score;
+void LostTrackWheel::remove(int slot)
+{
+    if (prev[slot] >= 0) next[prev[slot]] = next[slot];
+    else head[bucket_of[slot]] = next[slot];
+    if (next[slot] >= 0) prev[next[slot]] = prev[slot];
+    unlink_member(slot);
 }
 
-void STrack::update(STrack& new_track, int frame_id_)
+void LostTrackWheel::expire(int frame, std::vector<int>& expired)
 {
-    this->frame_id = frame_id_;
-    this->tracklet_len++;
-    
-    std::vector<float> xyah = {
-        new_track.tlwh[0] + new_track.tlwh[2]/2.0f,
-        new_track.tlwh[1] + new_track.tlwh[3]/2.0f,
-        new_track.tlwh[2] / new_track.tlwh[3],
-        new_track.tlwh[3]
-    };
-
-    // Alpha-beta update
-    float alpha = 0.3f; 
-    float beta = 0.1f;
-    std::vector<float> residual(4);
-    for(int i=0; i<4; i++) residual[i] = xyah[i] - mean[i];
-    for(int i=0; i<4; i++) {
-        mean[i] += alpha * residual[i];
-        mean[i+4] += beta * residual[i];
+    int b = frame % (int)head.size();
+    for (int slot = head[b]; slot >= 0; slot = next[slot]) {
+        unlink_member(slot);
+        expired.push_back(slot);
     }
-
-    tlwh[0] = mean[0] - (mean[3] * mean[2]) / 2.0f;
-    tlwh[1] = mean[1] - mean[3] / 2.0f;
-    tlwh[2] = mean[3] * mean[2];
-    tlwh[3] = mean[3];
-    
-    this->state = TrackState::Tracked;
-    this->is_activated = true;
-    this->score = new_track.score;
+    head[b] = -1;
 }
 
-void STrack::mark_lost() { state = TrackState::Lost; }
-void STrack::mark_removed() { state = TrackState::Removed; }
-
+// Swap-remove from the dense member list
+void LostTrackWheel::unlink_member(int slot)
+{
+    int pos = member_pos[slot];
+    int last = member_slots.back();
+    member_slots[pos] = last;
+    member_pos[last] = pos;
+    member_slots.pop_back();
+}
 
 // -------------------------------------------------------------------------
 // BYTETracker Implementation
 // -------------------------------------------------------------------------
 
-BYTETracker::BYTETracker(int frame_rate, int track_buffer_)
+BYTETracker::BYTETracker(int frame_rate_, int track_buffer_)
 {
     track_buffer = track_buffer_;
+    frame_rate = frame_rate_ > 0 ? (float)frame_rate_ : 30.0f;
+    clock_ns = 0;
+    origin_ns = 0;
     frame_id = 0;
+    expired_through = 0;
     track_thresh = 0.4f; // Adjustable
     high_thresh = 0.6f;
     match_thresh = 0.8f;
+    next_id = 0;
+    // A lost track expires track_buffer frames after it was last seen
+    lost_stracks.reset(track_buffer + 1);
 }
 
-BYTETracker::~BYTETracker() 
+BYTETracker::~BYTETracker()
 {
-    // Clean up pointers if necessary
 }
 
-// Basic IOU function
-float calc_iou(const std::vector<float>& bb_test, const std::vector<float>& bb_gt) {
-    float xx1 = std::max(bb_test[0], bb_gt[0]);
-    float yy1 = std::max(bb_test[1], bb_gt[1]);
-    float xx2 = std::min(bb_test[0] + bb_test[2], bb_gt[0] + bb_gt[2]);
-    float yy2 = std::min(bb_test[1] + bb_test[3], bb_gt[1] + bb_gt[3]);
+// Builds the sparse IoU cost matrix (only pairs above iou_thresh) and solves it with
+// SparseAssignment; each side gets its match position in the other list or -1.
+// With enough pairs, detections are indexed in a SpatialGrid so each track only scores the
+// detections it overlaps; IoU above any positive threshold needs an intersection anyway.
+void BYTETracker::associate(const std::vector<int>& track_slots, const std::vector<int>& det_indices, float iou_thresh,
+                            std::vector<int>& track_match, std::vector<int>& det_match)
+{
+    const int num_dets = (int)det_indices.size();
+    assignment.reset((int)track_slots.size(), num_dets);
+    if ((int)track_slots.size() * num_dets < GRID_MIN_PAIRS) {
+        for(int i=0; i<(int)track_slots.size(); i++) {
+            const float* box = tracks.tlwh[track_slots[i]].data();
+            for(int j=0; j<num_dets; j++) {
+                float iou = calc_iou(box, det_tlwh[det_indices[j]].data());
+                if (iou > iou_thresh) {
+                    assignment.add(i, j, 1.0f - iou);
+                }
+            }
+        }
+        assignment.solve(1.0f - iou_thresh, track_match, det_match);
+        return;
+    }
 
-    float w = std::max(0.0f, xx2 - xx1);
-    float h = std::max(0.0f, yy2 - yy1);
-    float wh = w * h;
-    float o = wh / ((bb_test[2] * bb_test[3]) + (bb_gt[2] * bb_gt[3]) - wh);
-    return o;
+    grid_x1.resize(num_dets);
+    grid_y1.resize(num_dets);
+    grid_x2.resize(num_dets);
+    grid_y2.resize(num_dets);
+    for(int j=0; j<num_dets; j++) {
+        const std::array<float, 4>& b = det_tlwh[det_indices[j]];
+        grid_x1[j] = b[0];
+        grid_y1[j] = b[1];
+        grid_x2[j] = b[0] + b[2];
+        grid_y2[j] = b[1] + b[3];
+    }
+    det_grid.build(grid_x1.data(), grid_y1.data(), grid_x2.data(), grid_y2.data(), num_dets);
+
+    for(int i=0; i<(int)track_slots.size(); i++) {
+        const float* box = tracks.tlwh[track_slots[i]].data();
+        grid_hits.clear();
+        det_grid.query(box[0], box[1], box[0] + box[2], box[1] + box[3], grid_hits);
+        for(int j : grid_hits) {
+            float iou = calc_iou(box, det_tlwh[det_indices[j]].data());
+            if (iou > iou_thresh) {
+                assignment.add(i, j, 1.0f - iou);
+            }
+        }
+    }
+    assignment.solve(1.0f - iou_thresh, track_match, det_match);
 }
 
-std::vector<Object> BYTETracker::update(const std::vector<Object>& objects)
+// Marks a track as matched (re-activating it if it was lost) and queues its detection
+// for the batched Kalman update
+void BYTETracker::apply_detection(int slot, int det)
 {
-    frame_id++;
+    float xyah[4];
+    tlwh_to_xyah(det_tlwh[det].data(), xyah);
+    update_slots.push_back(slot);
+    update_xyah.insert(update_xyah.end(), xyah, xyah + 4);
+
+    if (tracks.state[slot] == TrackState::Lost) {
+        lost_stracks.remove(slot);
+        tracks.tracklet_len[slot] = 0;
+    } else {
+        tracks.tracklet_len[slot]++;
+    }
+    tracks.frame_id[slot] = frame_id;
+    tracks.state[slot] = TrackState::Tracked;
+    tracks.score[slot] = det_score[det];
+}
 
-    // 1. Separate detections
-    std::vector<STrack> activated_stracks;
-    std::vector<STrack> refind_stracks;
-    std::vector<STrack> removed_stracks;
-    std::vector<STrack> lost_stracks;
+// Moves the clock to timestamp_ns and returns the elapsed time in nominal frames
+float BYTETracker::advance_clock(int64_t timestamp_ns)
+{
+    const double frame_ns = 1e9 / frame_rate;
+    if (timestamp_ns <= 0) timestamp_ns = clock_ns + (int64_t)llround(frame_ns);
+
+    float dt = 1.0f;
+    if (frame_id > 0 && timestamp_ns >= clock_ns) {
+        dt = (float)((timestamp_ns - clock_ns) / frame_ns);
+    } else {
+        // First frame, or the source restarted its clock: one nominal step, ticks continue
+        origin_ns = timestamp_ns - (int64_t)llround((frame_id + 1) * frame_ns);
+    }
+    clock_ns = timestamp_ns;
+    frame_id = std::max(frame_id, (int)llround((timestamp_ns - origin_ns) / frame_ns));
+    return dt;
+}
+
+void BYTETracker::predict_tracks(const std::vector<int>& slots, float dt)
+{
+    kalman_filter.predict(slots.data(), (int)slots.size(), dt, tracks.mean.data(), tracks.covariance.data());
+    for (int slot : slots) mean_to_tlwh(tracks.mean[slot].data(), tracks.tlwh[slot].data());
+}
+
+std::vector<Object> BYTETracker::update(const std::vector<Object>& objects)
+{
+    std::vector<Object> results;
+    update(objects, results);
+    return results;
+}
 
-    std::vector<STrack> detections;
-    std::vector<STrack> detections_low;
+void BYTETracker::update(const std::vector<Object>& objects, std::vector<Object>& output, int64_t timestamp_ns)
+{
+    const float dt = advance_clock(timestamp_ns);
 
+    // 1. Separate detections
+    det_tlwh.clear();
+    det_score.clear();
+    det_label.clear();
+    det_high.clear();
+    det_low.clear();
     for (const auto& obj : objects) {
-        std::vector<float> tlwh = {obj.x, obj.y, obj.width, obj.height};
-        STrack strack(tlwh, obj.prob, obj.label);
+        int d = (int)det_tlwh.size();
+        std::array<float, 4> tlwh = {{obj.x, obj.y, obj.width, obj.height}};
+        det_tlwh.push_back(tlwh);
+        det_score.push_back(obj.prob);
+        det_label.push_back(obj.label);
         if (obj.prob >= track_thresh) {
-            detections.push_back(strack);
+            det_high.push_back(d);
         } else {
-            detections_low.push_back(strack);
+            det_low.push_back(d);
         }
     }
 
-    // 2. Predict tracks
-    std::vector<STrack*> strack_pool;
-    for (auto& t : tracked_stracks) strack_pool.push_back(&t);
-    for (auto& t : this->lost_stracks) strack_pool.push_back(&t);
-
-    for (auto* t : strack_pool) {
-        if (t->state != TrackState::Tracked) {
-             t->mean[0] += t->mean[4];
-             t->mean[1] += t->mean[5];
-             t->mean[2] += t->mean[6];
-             t->mean[3] += t->mean[7];
-        } else {
-             t->mean[0] += t->mean[4];
-             t->mean[1] += t->mean[5];
-             t->mean[2] += t->mean[6];
-             t->mean[3] += t->mean[7];
-        }
-        
-        // Update TLWH
-        t->tlwh[0] = t->mean[0] - (t->mean[3] * t->mean[2]) / 2.0f;
-        t->tlwh[1] = t->mean[1] - t->mean[3] / 2.0f;
-        t->tlwh[2] = t->mean[3] * t->mean[2];
-        t->tlwh[3] = t->mean[3];
-    }
+    // 2. Predict tracks (tracked and lost)
+    predict_pool(dt);
 
     // 3. First Association (High Score)
-    std::vector<STrack*> unconfirmed;
-    std::vector<STrack*> tracked_stracks_ptrs;
-    for(auto& t : tracked_stracks) {
-        if(t.is_activated) tracked_stracks_ptrs.push_back(&t);
-        else unconfirmed.push_back(&t);
-    }
-    
-    // Matching (Greedy IOU)
-    // We compute IOU matrix and pick best matches
-    std::vector<int> matches_a, matches_b;
-    std::vector<int> unmatched_a, unmatched_b;
-    
-    // Helper lambda for Greedy Matching
-    auto greedy_match = [&](std::vector<STrack*>& tracks, std::vector<STrack>& dets, float thresh) {
-        struct Match { int t_idx; int d_idx; float iou; };
-        std::vector<Match> all_matches;
-        
-        for(int i=0; i<tracks.size(); i++) {
-            for(int j=0; j<dets.size(); j++) {
-                float iou = calc_iou(tracks[i]->tlwh, dets[j].tlwh);
-                if (iou > thresh) {
-                    all_matches.push_back({i, j, iou});
-                }
-            }
-        }
-        
-        // Sort by IOU desc
-        std::sort(all_matches.begin(), all_matches.end(), [](const Match& a, const Match& b){
-            return a.iou > b.iou;
-        });
-        
-        std::set<int> matched_tracks;
-        std::set<int> matched_dets;
-        std::vector<std::pair<int, int>> final_matches;
-        
-        for(const auto& m : all_matches) {
-            if(matched_tracks.count(m.t_idx) || matched_dets.count(m.d_idx)) continue;
-            matched_tracks.insert(m.t_idx);
-            matched_dets.insert(m.d_idx);
-            final_matches.push_back({m.t_idx, m.d_idx});
-        }
-        
-        return final_matches;
-    };
-
-    auto matches1 = greedy_match(tracked_stracks_ptrs, detections, 1.0f - match_thresh); // match_thresh is distance, so IOU needs to be > (1-dist)?? 
-    // Wait, typical threshold is 0.8 IOU? No, ByteTrack uses cost.
-    // Let's use IOU threshold 0.5 for high score.
-    matches1 = greedy_match(tracked_stracks_ptrs, detections, 0.2f); // 0.2 IOU threshold
-
-    std::set<int> matched_track_indices;
-    std::set<int> matched_det_indices;
-
-    for(auto& m : matches1) {
-        tracked_stracks_ptrs[m.first]->update(detections[m.second], frame_id);
-        activated_stracks.push_back(*tracked_stracks_ptrs[m.first]);
-        matched_track_indices.insert(m.first);
-        matched_det_indices.insert(m.second);
+    next_tracked.clear();
+    update_slots.clear();
+    update_xyah.clear();
+    associate(track_pool, det_high, 0.2f, track_match_high, det_match_high); // 0.2 IOU threshold
+
+    for(int i=0; i<(int)track_pool.size(); i++) {
+        int d = track_match_high[i];
+        if (d < 0) continue;
+        apply_detection(track_pool[i], det_high[d]);
+        next_tracked.push_back(track_pool[i]);
     }
 
-    // 4. Second Association (Low Score)
-    std::vector<STrack*> second_track_candidates;
-    for(int i=0; i<tracked_stracks_ptrs.size(); i++) {
-        if(matched_track_indices.find(i) == matched_track_indices.end()) {
-            second_track_candidates.push_back(tracked_stracks_ptrs[i]);
+    // 4. Second Association (Low Score), lost tracks included
+    second_candidates.clear();
+    for(int i=0; i<(int)track_pool.size(); i++) {
+        if(track_match_high[i] < 0) {
+            second_candidates.push_back(track_pool[i]);
         }
     }
-    
-    std::vector<STrack> unmatched_dets_low; // Actually just detections_low
-    // BUT we need to filter unmatched from first round? No, detections_low are separate.
-    
-    auto matches2 = greedy_match(second_track_candidates, detections_low, 0.4f); // 0.4 IOU threshold
-
-    for(auto& m : matches2) {
-        second_track_candidates[m.first]->update(detections_low[m.second], frame_id);
-        activated_stracks.push_back(*second_track_candidates[m.first]);
-        // Remove from candidates (logic handled by rebuilding lists later)
+
+    associate(second_candidates, det_low, 0.4f, track_match_low, det_match_low); // 0.4 IOU threshold
+
+    for(int i=0; i<(int)second_candidates.size(); i++) {
+        int d = track_match_low[i];
+        if (d < 0) continue;
+        apply_detection(second_candidates[i], det_low[d]);
+        next_tracked.push_back(second_candidates[i]);
     }
 
-    // 5. Lost Tracks (Candidates that didn't match low score)
-    // Actually we need to mark them lost
-    std::set<int> matched_second_track_indices;
-    for(auto& m : matches2) matched_second_track_indices.insert(m.first);
-
-    for(int i=0; i<second_track_candidates.size(); i++) {
-        if(matched_second_track_indices.find(i) == matched_second_track_indices.end()) {
-             STrack* t = second_track_candidates[i];
-             if(t->state != TrackState::Lost) {
-                 t->mark_lost();
-                 this->lost_stracks.push_back(*t);
-             } else {
-                 // Already lost, keep it
-                 if(frame_id - t->frame_id < track_buffer) {
-                     this->lost_stracks.push_back(*t);
-                 } else {
-                     t->mark_removed();
-                 }
-             }
+    kalman_filter.update(update_slots.data(), update_xyah.data(), (int)update_slots.size(),
+                         tracks.mean.data(), tracks.covariance.data());
+    for (int slot : update_slots) mean_to_tlwh(tracks.mean[slot].data(), tracks.tlwh[slot].data());
+
+    // 5. Lost Tracks (Candidates that didn't match low score). Expire the old ones first:
+    // the ticks elapsed since the last frame may cover any bucket of the wheel.
+    expire_lost();
+    for(int i=0; i<(int)second_candidates.size(); i++) {
+        int slot = second_candidates[i];
+        if(track_match_low[i] < 0 && tracks.state[slot] == TrackState::Tracked) {
+            tracks.state[slot] = TrackState::Lost;
+            // Frames without detections may already have used up the buffer: expire next tick
+            lost_stracks.insert(slot, std::max(tracks.frame_id[slot] + track_buffer, frame_id + 1));
         }
     }
 
     // 6. Init New Tracks
     // Unmatched high score detections
-    for(int i=0; i<detections.size(); i++) {
-        if(matched_det_indices.find(i) == matched_det_indices.end()) {
-             STrack& d = detections[i];
-             if(d.score > high_thresh) {
-                 d.activate(kalman_filter, frame_id);
-                 // Assign new ID
-                 static int global_id = 0;
-                 d.track_id = ++global_id;
-                 activated_stracks.push_back(d);
-             }
+    for(int j=0; j<(int)det_high.size(); j++) {
+        if(det_match_high[j] >= 0) continue;
+        int d = det_high[j];
+        if(det_score[d] > high_thresh) {
+            int slot = tracks.allocate();
+            float xyah[4];
+            tlwh_to_xyah(det_tlwh[d].data(), xyah);
+            kalman_filter.initiate(xyah, tracks.mean[slot], tracks.covariance[slot]);
+            tracks.tlwh[slot] = det_tlwh[d];
+            tracks.score[slot] = det_score[d];
+            tracks.label[slot] = det_label[d];
+            tracks.state[slot] = TrackState::Tracked;
+            tracks.frame_id[slot] = frame_id;
+            tracks.start_frame[slot] = frame_id;
+            tracks.tracklet_len[slot] = 0;
+            // Assign new ID
+            tracks.track_id[slot] = ++next_id;
+            next_tracked.push_back(slot);
         }
     }
 
     // Update member variables
-    this->tracked_stracks = activated_stracks;
-    
-    // Output objects
-    std::vector<Object> results;
-    for(auto& t : this->tracked_stracks) {
-        if(t.is_activated) {
-            Object obj;
-            obj.x = t.tlwh[0];
-            obj.y = t.tlwh[1];
-            obj.width = t.tlwh[2];
-            obj.height = t.tlwh[3];
-            obj.label = t.label;
-            obj.prob = t.score;
-            obj.track_id = t.track_id;
-            results.push_back(obj);
-        }
+    tracked_stracks.swap(next_tracked);
+
+    write_output(output);
+}
+
+void BYTETracker::extrapolate(std::vector<Object>& output, int64_t timestamp_ns)
+{
+    predict_pool(advance_clock(timestamp_ns));
+    expire_lost();
+    write_output(output);
+}
+
+void BYTETracker::predict_to(int64_t timestamp_ns, std::vector<Object>& output) const
+{
+    const float dt = std::max(0.0f, (float)((timestamp_ns - clock_ns) * 1e-9 * frame_rate));
+    write_output(output);
+    for(size_t i=0; i<output.size(); i++) {
+        const KalmanFilter::Mean& mean = tracks.mean[tracked_stracks[i]];
+        float ahead[4];
+        for (int k = 0; k < 4; k++) ahead[k] = mean[k] + mean[4 + k] * dt;
+        float tlwh[4];
+        mean_to_tlwh(ahead, tlwh);
+        output[i].x = tlwh[0];
+        output[i].y = tlwh[1];
+        output[i].width = tlwh[2];
+        output[i].height = tlwh[3];
+    }
+}
+
+TrackMotion BYTETracker::motion() const
+{
+    TrackMotion summary;
+    for(int slot : tracked_stracks) {
+        const KalmanFilter::Mean& mean = tracks.mean[slot];
+        const KalmanFilter::Covariance& cov = tracks.covariance[slot];
+        const float h = mean[3];
+        if (h <= 0.0f) continue;
+        summary.tracks++;
+        if (tracks.tracklet_len[slot] == 0) summary.new_tracks++;
+        summary.max_speed = std::max(summary.max_speed, std::sqrt(mean[4] * mean[4] + mean[5] * mean[5]) * frame_rate / h);
+        summary.max_uncertainty = std::max(summary.max_uncertainty, std::sqrt(std::max(cov[0], cov[1])) / h);
+    }
+    return summary;
+}
+
+// Predicts tracked and lost tracks into track_pool order; lost boxes stop growing or shrinking
+void BYTETracker::predict_pool(float dt)
+{
+    track_pool = tracked_stracks;
+    for (int slot : lost_stracks.members()) {
+        tracks.mean[slot][7] = 0.0f;
+        track_pool.push_back(slot);
+    }
+    predict_tracks(track_pool, dt);
+}
+
+// Lost tracks not seen for track_buffer ticks are dropped; every tick since the last call
+// is expired, but never more than one turn of the wheel
+void BYTETracker::expire_lost()
+{
+    expired.clear();
+    for (int tick = std::max(expired_through + 1, frame_id - track_buffer); tick <= frame_id; tick++) {
+        lost_stracks.expire(tick, expired);
+    }
+    expired_through = frame_id;
+    for(int slot : expired) tracks.release(slot);
+}
+
+void BYTETracker::write_output(std::vector<Object>& output) const
+{
+    output.clear();
+    for(int slot : tracked_stracks) {
+        const std::array<float, 4>& tlwh = tracks.tlwh[slot];
+        Object obj;
+        obj.x = tlwh[0];
+        obj.y = tlwh[1];
+        obj.width = tlwh[2];
+        obj.height = tlwh[3];
+        obj.label = tracks.label[slot];
+        obj.prob = tracks.score[slot];
+        obj.track_id = tracks.track_id[slot];
+        output.push_back(obj);
     }
-    return results;
 }
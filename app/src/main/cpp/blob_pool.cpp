@@ -0,0 +1,83 @@
+#include "blob_pool.h"
+
+namespace {
+
+// A budget up to this many times the requested size is reused rather than leaving it idle
+const size_t MAX_OVERSIZE = 2;
+const size_t INITIAL_BUDGETS = 128;
+
+} // namespace
+
+BlobPool::BlobPool() {
+    idle.reserve(INITIAL_BUDGETS);
+    in_use.reserve(INITIAL_BUDGETS);
+    counters.requests = 0;
+    counters.system_allocs = 0;
+    counters.system_frees = 0;
+    counters.bytes_held = 0;
+}
+
+BlobPool::~BlobPool() {
+    // Mats still holding a budget here would dangle; free everything regardless
+    for (const Budget& b : idle) ncnn::fastFree(b.ptr);
+    for (const Budget& b : in_use) ncnn::fastFree(b.ptr);
+}
+
+void* BlobPool::fastMalloc(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.requests++;
+
+    // Best fit among idle budgets that are large enough but not wastefully so
+    int best = -1;
+    for (int i = 0; i < (int)idle.size(); i++) {
+        const size_t s = idle[i].size;
+        if (s >= size && s <= size * MAX_OVERSIZE && (best < 0 || s < idle[best].size)) best = i;
+    }
+
+    Budget b;
+    if (best >= 0) {
+        b = idle[best];
+        idle[best] = idle.back();
+        idle.pop_back();
+    } else {
+        b.size = size;
+        b.ptr = ncnn::fastMalloc(size);
+        if (!b.ptr) return 0;
+        counters.system_allocs++;
+        counters.bytes_held += size;
+    }
+    in_use.push_back(b);
+    return b.ptr;
+}
+
+void BlobPool::fastFree(void* ptr) {
+    if (!ptr) return;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Blobs are mostly released shortly after they were handed out, search from the back
+    for (int i = (int)in_use.size() - 1; i >= 0; i--) {
+        if (in_use[i].ptr != ptr) continue;
+        idle.push_back(in_use[i]);
+        in_use[i] = in_use.back();
+        in_use.pop_back();
+        return;
+    }
+
+    // Not ours (allocated before the pool was installed)
+    ncnn::fastFree(ptr);
+}
+
+void BlobPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Budget& b : idle) {
+        ncnn::fastFree(b.ptr);
+        counters.system_frees++;
+        counters.bytes_held -= b.size;
+    }
+    idle.clear();
+}
+
+AllocStats BlobPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
@@ -0,0 +1,86 @@
+#include "frame_pipeline.h"
+
+FramePipeline::FramePipeline(const InferFn& infer, const FinishFn& finish)
+    : infer_fn(infer), finish_fn(finish), running(true), submitted(0), dropped(0), finished(0) {
+    infer_thread = std::thread(&FramePipeline::inferLoop, this);
+    finish_thread = std::thread(&FramePipeline::finishLoop, this);
+}
+
+FramePipeline::~FramePipeline() {
+    running.store(false);
+    infer_signal.ring();
+    finish_signal.ring();
+    infer_thread.join();
+    finish_thread.join();
+}
+
+void FramePipeline::submitFrame(int64_t timestamp_ns) {
+    PipelineFrame& frame = to_infer.writeSlot();
+    frame.frame_id = submitted.fetch_add(1, std::memory_order_relaxed);
+    frame.timestamp_ns = timestamp_ns;
+    int lost;
+    if (frame.mode == FRAME_DETECT) {
+        lost = to_infer.publish();
+    } else {
+        // The tensor stays in the write slot for the next frame
+        FrameStamp stamp = { frame.frame_id, timestamp_ns, frame.mode };
+        lost = to_infer.publishStamp(stamp);
+    }
+    if (lost) dropped.fetch_add(lost, std::memory_order_relaxed);
+    infer_signal.ring();
+}
+
+void FramePipeline::inferLoop() {
+    unsigned int seen = 0;
+    PipelineFrame* frame = nullptr;
+    FrameStamp stamp;
+    while (true) {
+        infer_signal.wait(seen);
+        if (!running.load()) return;
+
+        // In frame order: the newest pending inference, then the stamp that followed it
+        FrameSlot<PipelineFrame>::Item item;
+        while ((item = to_infer.take(frame, stamp)) != FrameSlot<PipelineFrame>::NONE) {
+            int lost;
+            if (item == FrameSlot<PipelineFrame>::PAYLOAD) {
+                PipelineOutput& out = to_finish.writeSlot();
+                infer_fn(*frame, out);
+                out.transform = frame->transform;
+                out.frame_id = frame->frame_id;
+                out.timestamp_ns = frame->timestamp_ns;
+                out.mode = frame->mode;
+                lost = to_finish.publish();
+            } else {
+                lost = to_finish.publishStamp(stamp);
+            }
+            if (lost) dropped.fetch_add(lost, std::memory_order_relaxed);
+            finish_signal.ring();
+            if (!running.load()) return;
+        }
+    }
+}
+
+void FramePipeline::finishLoop() {
+    unsigned int seen = 0;
+    PipelineOutput* out = nullptr;
+    PipelineOutput skipped; // stamps: header only, no model output
+    FrameStamp stamp;
+    while (true) {
+        finish_signal.wait(seen);
+        if (!running.load()) return;
+
+        FrameSlot<PipelineOutput>::Item item;
+        while ((item = to_finish.take(out, stamp)) != FrameSlot<PipelineOutput>::NONE) {
+            if (item == FrameSlot<PipelineOutput>::PAYLOAD) {
+                finish_fn(*out);
+            } else {
+                skipped.frame_id = stamp.frame_id;
+                skipped.timestamp_ns = stamp.timestamp_ns;
+                skipped.mode = stamp.mode;
+                finish_fn(skipped);
+            }
+            finished.fetch_add(1, std::memory_order_relaxed);
+            if (!running.load()) return;
+        }
+    }
+}
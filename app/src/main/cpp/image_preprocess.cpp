@@ -0,0 +1,314 @@
+#include "image_preprocess.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "simd_lanes.h"
+
+namespace {
+
+// Gathered inputs for one output row. Chroma is stored already centred on 0.
+struct RowSamples {
+    const float* tl;
+    const float* tr;
+    const float* bl;
+    const float* br;
+    const float* u;
+    const float* v;
+    const float* ax;
+};
+
+// Bilinear luma blend + full-range BT.601 YUV->RGB + clamp + 1/255, for [begin, end)
+template<class L>
+int convert_row(const RowSamples& s, float fy, float* r_out, float* g_out, float* b_out, int begin, int end) {
+    typedef typename L::V V;
+    const V vfy = L::dup(fy);
+    const V zero = L::dup(0.0f);
+    const V max_val = L::dup(255.0f);
+    const V norm = L::dup(1.0f / 255.0f);
+    const V kr_v = L::dup(1.402f);
+    const V kg_u = L::dup(0.344136f);
+    const V kg_v = L::dup(0.714136f);
+    const V kb_u = L::dup(1.772f);
+
+    int x = begin;
+    for (; x + L::N <= end; x += L::N) {
+        V ax = L::load(s.ax + x);
+        V tl = L::load(s.tl + x);
+        V bl = L::load(s.bl + x);
+        V top = L::add(tl, L::mul(L::sub(L::load(s.tr + x), tl), ax));
+        V bot = L::add(bl, L::mul(L::sub(L::load(s.br + x), bl), ax));
+        V yy = L::add(top, L::mul(L::sub(bot, top), vfy));
+
+        V uu = L::load(s.u + x);
+        V vv = L::load(s.v + x);
+
+        V r = L::add(yy, L::mul(kr_v, vv));
+        V g = L::sub(L::sub(yy, L::mul(kg_u, uu)), L::mul(kg_v, vv));
+        V b = L::add(yy, L::mul(kb_u, uu));
+
+        L::store(r_out + x, L::mul(L::min(L::max(r, zero), max_val), norm));
+        L::store(g_out + x, L::mul(L::min(L::max(g, zero), max_val), norm));
+        L::store(b_out + x, L::mul(L::min(L::max(b, zero), max_val), norm));
+    }
+    return x;
+}
+
+// Bilinear blend of one channel + scale, for [begin, end)
+template<class L>
+int blend_row(const float* tl, const float* tr, const float* bl, const float* br, const float* alpha,
+              float fy, float scale, float* out, int begin, int end) {
+    typedef typename L::V V;
+    const V vfy = L::dup(fy);
+    const V vscale = L::dup(scale);
+
+    int x = begin;
+    for (; x + L::N <= end; x += L::N) {
+        V ax = L::load(alpha + x);
+        V t0 = L::load(tl + x);
+        V b0 = L::load(bl + x);
+        V top = L::add(t0, L::mul(L::sub(L::load(tr + x), t0), ax));
+        V bot = L::add(b0, L::mul(L::sub(L::load(br + x), b0), ax));
+        L::store(out + x, L::mul(L::add(top, L::mul(L::sub(bot, top), vfy)), vscale));
+    }
+    return x;
+}
+
+// Builds offset/weight tables for half-pixel-centre bilinear sampling along one output axis.
+// The axis reads a source axis of src samples, backwards if the rotation reverses it; unit
+// and uv_unit are the byte distances between neighbouring luma and chroma samples on it.
+// Returns the byte step from a sample to its neighbour along the output axis.
+int build_axis(int src, int dst, bool reversed, int unit, int uv_unit,
+               std::vector<int>& ofs, std::vector<float>& alpha, std::vector<int>& uv) {
+    ofs.resize(dst);
+    alpha.resize(dst);
+    uv.resize(dst);
+
+    const float scale = (float)src / dst;
+    const int uv_max = (src + 1) / 2 - 1;
+    for (int i = 0; i < dst; i++) {
+        float f = (i + 0.5f) * scale - 0.5f;
+        int s = (int)std::floor(f);
+        float a = f - s;
+        if (s < 0) {
+            s = 0;
+            a = 0.0f;
+        }
+        if (s >= src - 1) {
+            s = src - 2;
+            a = 1.0f;
+        }
+        // Chroma is 2x subsampled: take the sample covering the nearest luma pixel
+        int nearest = s + (a >= 0.5f ? 1 : 0);
+        if (reversed) {
+            s = src - 1 - s;
+            nearest = src - 1 - nearest;
+        }
+        ofs[i] = s * unit;
+        alpha[i] = a;
+        uv[i] = std::min(nearest >> 1, uv_max) * uv_unit;
+    }
+    return reversed ? -unit : unit;
+}
+
+// Letterbox fill colour used by the Ultralytics training pipeline
+const float PAD_VALUE = 114.0f / 255.0f;
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// InputTransform
+// -------------------------------------------------------------------------
+
+InputTransform InputTransform::stretch(int src_w, int src_h, int target_w, int target_h) {
+    InputTransform tf;
+    tf.src_w = src_w;
+    tf.src_h = src_h;
+    tf.rotation = 0;
+    tf.input_w = target_w;
+    tf.input_h = target_h;
+    tf.resized_w = target_w;
+    tf.resized_h = target_h;
+    tf.pad_x = 0;
+    tf.pad_y = 0;
+    tf.scale_x = (float)target_w / src_w;
+    tf.scale_y = (float)target_h / src_h;
+    return tf;
+}
+
+InputTransform InputTransform::letterbox(int src_w, int src_h, int max_w, int max_h, int stride, bool rect) {
+    float scale = std::min((float)max_w / src_w, (float)max_h / src_h);
+
+    InputTransform tf;
+    tf.src_w = src_w;
+    tf.src_h = src_h;
+    tf.rotation = 0;
+    tf.resized_w = std::max(1, std::min(max_w, (int)std::lround(src_w * scale)));
+    tf.resized_h = std::max(1, std::min(max_h, (int)std::lround(src_h * scale)));
+    if (rect) {
+        tf.input_w = (tf.resized_w + stride - 1) / stride * stride;
+        tf.input_h = (tf.resized_h + stride - 1) / stride * stride;
+    } else {
+        tf.input_w = max_w;
+        tf.input_h = max_h;
+    }
+    tf.pad_x = (tf.input_w - tf.resized_w) / 2;
+    tf.pad_y = (tf.input_h - tf.resized_h) / 2;
+    tf.scale_x = (float)tf.resized_w / src_w;
+    tf.scale_y = (float)tf.resized_h / src_h;
+    return tf;
+}
+
+// -------------------------------------------------------------------------
+// InputPreprocessor
+// -------------------------------------------------------------------------
+
+InputPreprocessor::InputPreprocessor() : step_x(0), step_y(0) {
+    memset(&table_layout, 0, sizeof(table_layout));
+}
+
+void InputPreprocessor::updateTables(const SampleLayout& layout) {
+    if (memcmp(&layout, &table_layout, sizeof(layout)) == 0) return;
+
+    // Which source axis each upright output axis walks, and in which direction:
+    //   0: x -> x,  y -> y      90: x -> -y, y -> x
+    // 180: x -> -x, y -> -y    270: x -> y,  y -> -x
+    const int rot = layout.rotation;
+    const bool transposed = rot % 180 != 0;
+    const int col_unit = layout.pixel_bytes;
+    const int row_unit = layout.row_stride;
+    const int uv_col_unit = layout.uv_pixel_stride;
+    const int uv_row_unit = layout.uv_row_stride;
+    if (transposed) {
+        step_x = build_axis(layout.src_h, layout.dst_w, rot == 90, row_unit, uv_row_unit, x_ofs, x_alpha, x_uv);
+        step_y = build_axis(layout.src_w, layout.dst_h, rot == 270, col_unit, uv_col_unit, y_ofs, y_alpha, y_uv);
+    } else {
+        step_x = build_axis(layout.src_w, layout.dst_w, rot == 180, col_unit, uv_col_unit, x_ofs, x_alpha, x_uv);
+        step_y = build_axis(layout.src_h, layout.dst_h, rot == 180, row_unit, uv_row_unit, y_ofs, y_alpha, y_uv);
+    }
+
+    // YUV: tl, tr, bl, br, u, v. RGBA: tl, tr, bl, br for each of R, G, B
+    row_buf.resize(layout.dst_w * 12);
+
+    table_layout = layout;
+}
+
+void InputPreprocessor::fillPadding(ncnn::Mat& out, const InputTransform& tf) {
+    const int right = tf.pad_x + tf.resized_w;
+    const int bottom = tf.pad_y + tf.resized_h;
+    if (tf.pad_x == 0 && tf.pad_y == 0 && right == tf.input_w && bottom == tf.input_h) return;
+
+    for (int c = 0; c < 3; c++) {
+        ncnn::Mat plane = out.channel(c);
+        for (int y = 0; y < tf.input_h; y++) {
+            float* row = plane.row(y);
+            if (y < tf.pad_y || y >= bottom) {
+                std::fill(row, row + tf.input_w, PAD_VALUE);
+            } else {
+                std::fill(row, row + tf.pad_x, PAD_VALUE);
+                std::fill(row + right, row + tf.input_w, PAD_VALUE);
+            }
+        }
+    }
+}
+
+void InputPreprocessor::fromYUV420(const YUV420Image& img, ncnn::Mat& out, const InputTransform& tf) {
+    if (img.width < 2 || img.height < 2 || !img.y || !img.u || !img.v) return;
+
+    const int dst_w = tf.resized_w;
+    const int dst_h = tf.resized_h;
+    SampleLayout layout = { img.width, img.height, dst_w, dst_h, tf.rotation,
+                            img.y_row_stride, 1, img.uv_row_stride, img.uv_pixel_stride };
+    updateTables(layout);
+
+    // No-op when the blob already has this shape, so the buffer is reused across frames
+    out.create(tf.input_w, tf.input_h, 3);
+    fillPadding(out, tf);
+
+    float* tl = &row_buf[0];
+    float* tr = tl + dst_w;
+    float* bl = tr + dst_w;
+    float* br = bl + dst_w;
+    float* uu = br + dst_w;
+    float* vv = uu + dst_w;
+
+    RowSamples samples = { tl, tr, bl, br, uu, vv, &x_alpha[0] };
+
+    const int* xo = &x_ofs[0];
+    const int* xc = &x_uv[0];
+    const int sx = step_x;
+    const int sy = step_y;
+
+    for (int dy = 0; dy < dst_h; dy++) {
+        const unsigned char* y0 = img.y + y_ofs[dy];
+        const unsigned char* urow = img.u + y_uv[dy];
+        const unsigned char* vrow = img.v + y_uv[dy];
+
+        // Gather: the only scattered reads, everything after is contiguous
+        for (int x = 0; x < dst_w; x++) {
+            const unsigned char* p = y0 + xo[x];
+            const int cx = xc[x];
+            tl[x] = p[0];
+            tr[x] = p[sx];
+            bl[x] = p[sy];
+            br[x] = p[sx + sy];
+            uu[x] = (float)urow[cx] - 128.0f;
+            vv[x] = (float)vrow[cx] - 128.0f;
+        }
+
+        float* r_out = out.channel(0).row(tf.pad_y + dy) + tf.pad_x;
+        float* g_out = out.channel(1).row(tf.pad_y + dy) + tf.pad_x;
+        float* b_out = out.channel(2).row(tf.pad_y + dy) + tf.pad_x;
+
+        int x = 0;
+#if HAVE_SIMD_LANES
+        x = convert_row<SimdLanes>(samples, y_alpha[dy], r_out, g_out, b_out, x, dst_w);
+#endif
+        convert_row<ScalarLanes>(samples, y_alpha[dy], r_out, g_out, b_out, x, dst_w);
+    }
+}
+
+void InputPreprocessor::fromRGBA(const unsigned char* pixels, int stride, ncnn::Mat& out, const InputTransform& tf) {
+    if (tf.src_w < 2 || tf.src_h < 2 || !pixels) return;
+
+    // tf holds the upright size; the buffer is that size turned back
+    const int width = InputTransform::uprightWidth(tf.src_w, tf.src_h, tf.rotation);
+    const int height = InputTransform::uprightHeight(tf.src_w, tf.src_h, tf.rotation);
+    const int dst_w = tf.resized_w;
+    const int dst_h = tf.resized_h;
+    SampleLayout layout = { width, height, dst_w, dst_h, tf.rotation, stride, 4, 0, 0 };
+    updateTables(layout);
+
+    out.create(tf.input_w, tf.input_h, 3);
+    fillPadding(out, tf);
+
+    const float norm = 1.0f / 255.0f;
+    const int* xo = &x_ofs[0];
+    const int sx = step_x;
+    const int sy = step_y;
+
+    for (int dy = 0; dy < dst_h; dy++) {
+        const unsigned char* r0 = pixels + y_ofs[dy];
+
+        for (int c = 0; c < 3; c++) {
+            float* tl = &row_buf[c * 4 * dst_w];
+            float* tr = tl + dst_w;
+            float* bl = tr + dst_w;
+            float* br = bl + dst_w;
+            const unsigned char* rc = r0 + c;
+            for (int x = 0; x < dst_w; x++) {
+                const unsigned char* p = rc + xo[x];
+                tl[x] = p[0];
+                tr[x] = p[sx];
+                bl[x] = p[sy];
+                br[x] = p[sx + sy];
+            }
+
+            float* dst = out.channel(c).row(tf.pad_y + dy) + tf.pad_x;
+            int x = 0;
+#if HAVE_SIMD_LANES
+            x = blend_row<SimdLanes>(tl, tr, bl, br, &x_alpha[0], y_alpha[dy], norm, dst, x, dst_w);
+#endif
+            blend_row<ScalarLanes>(tl, tr, bl, br, &x_alpha[0], y_alpha[dy], norm, dst, x, dst_w);
+        }
+    }
+}
@@ -1,16 +1,13 @@
 #ifndef BYTE_TRACKER_H
 #define BYTE_TRACKER_H
 
+#include <stdint.h>
+#include <array>
 #include <vector>
-#include <deque>
-#include <map>
 #include <cfloat> // Added for FLT_MAX
-// Eigen removed as we use a custom SimpleKalmanFilter
-// #include <eigen3/Eigen/Core>
-// #include <eigen3/Eigen/Dense>
-
-#include <vector>
-#include <string>
+#include "kalman_filter.h"
+#include "lap_assign.h"
+#include "spatial_grid.h"
 
 struct Object
 {
@@ -23,92 +20,151 @@ struct Object
     int track_id = -1;
 };
 
-// Simple Kalman Filter implementation (Constant Velocity Model)
-class SimpleKalmanFilter
+enum TrackState { New = 0, Tracked, Lost, Removed };
+
+// Summary of the tracked set's motion model, both normalised by each track's box height
+struct TrackMotion
 {
-public:
-    SimpleKalmanFilter();
-    void initiate(const std::vector<float>& measurement);
-    void predict();
-    void update(const std::vector<float>& measurement);
-    
-    std::vector<float> project(const std::vector<float>& mean, const std::vector<float>& covariance);
-    
-    std::vector<float> _mean; // 8 dimensional (cx, cy, aspect_ratio, height, vx, vy, va, vh)
-    std::vector<float> _covariance; // 8x8 flattened
-    
-    // Standard deviations
-    float _std_weight_position;
-    float _std_weight_velocity;
+    int tracks = 0;
+    int new_tracks = 0;           // started or re-found on the last detection, velocity unknown
+    float max_speed = 0.0f;       // centre displacement per second
+    float max_uncertainty = 0.0f; // standard deviation of the predicted centre
 };
 
-enum TrackState { New = 0, Tracked, Lost, Removed };
-
-class STrack
+// Struct-of-arrays track storage. Each field is its own contiguous column indexed by slot;
+// slots are stable for a track's lifetime and recycled through a free list, so the columns
+// only grow when the number of live tracks reaches a new high-water mark.
+class TrackStore
 {
 public:
-    STrack(std::vector<float> tlwh, float score, int label);
-    ~STrack();
-
-    void activate(SimpleKalmanFilter& kf, int frame_id);
-    void re_activate(STrack& new_track, int frame_id, bool new_id = false);
-    void update(STrack& new_track, int frame_id);
-    void mark_lost();
-    void mark_removed();
-
-    std::vector<float> tlwh;
-    bool is_activated;
-    int track_id;
-    int state;
-    
-    float score;
-    int label;
-    int start_frame;
-    int frame_id;
-    int tracklet_len;
+    int allocate();
+    void release(int slot);
+    int slots() const { return (int)state.size(); }
+
+    std::vector<std::array<float, 4> > tlwh;
+    std::vector<KalmanFilter::Mean> mean;
+    std::vector<KalmanFilter::Covariance> covariance;
+    std::vector<float> score;
+    std::vector<int> label;
+    std::vector<int> track_id;
+    std::vector<int> state;
+    std::vector<int> start_frame;
+    std::vector<int> frame_id;
+    std::vector<int> tracklet_len;
 
-    SimpleKalmanFilter* kalman_filter; // Added missing pointer
+private:
+    std::vector<int> free_slots;
+};
+
+// Lost tracks bucketed by the frame they expire on, in a wheel of `horizon` buckets.
+// Each bucket is an intrusive doubly linked list threaded through per-slot links, so
+// losing, re-finding and expiring a track are all O(1) and nothing that is not due is
+// scanned. members() is the dense list of lost slots for prediction and association.
+class LostTrackWheel
+{
+public:
+    void reset(int horizon);
+    void insert(int slot, int expiry_frame);
+    void remove(int slot);
+    // Removes every track expiring at `frame` and appends its slot to expired
+    void expire(int frame, std::vector<int>& expired);
+    const std::vector<int>& members() const { return member_slots; }
 
-    std::vector<float> mean;
-    std::vector<float> covariance;
-    
-    // For mapping back
-    float _original_tlwh[4];
+private:
+    void unlink_member(int slot);
+
+    std::vector<int> head;        // bucket -> first slot, -1 when empty
+    std::vector<int> next;        // per slot
+    std::vector<int> prev;
+    std::vector<int> bucket_of;
+    std::vector<int> member_pos;  // per slot index into member_slots
+    std::vector<int> member_slots;
 };
 
+// Motion is integrated over real time: every call takes the capture timestamp of its frame
+// (any monotonic nanosecond clock) and the Kalman filter steps by the time actually elapsed,
+// so dropped or late frames do not distort velocities. frame_rate only sets the unit the
+// filter works in and the tick that track_buffer counts in: a lost track survives
+// track_buffer / frame_rate seconds however many frames arrive meanwhile.
+// timestamp_ns = 0 means "one nominal frame after the previous call".
 class BYTETracker
 {
 public:
     BYTETracker(int frame_rate = 30, int track_buffer = 30);
     ~BYTETracker();
 
+    // Writes the active tracks to output. Allocation-free once buffers have reached the
+    // scene's high-water mark.
+    void update(const std::vector<Object>& objects, std::vector<Object>& output, int64_t timestamp_ns = 0);
     std::vector<Object> update(const std::vector<Object>& objects);
 
-private:
-    std::vector<STrack*> joint_stracks(std::vector<STrack*> &tlista, std::vector<STrack> &tlistb);
-    std::vector<STrack> joint_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
+    // Advances every track to timestamp_ns by its motion model alone, for frames the
+    // detector skips, and writes the predicted active tracks to output. Lost tracks keep ageing.
+    void extrapolate(std::vector<Object>& output, int64_t timestamp_ns = 0);
 
-    std::vector<STrack> sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
-    void remove_duplicate_stracks(std::vector<STrack> &resa, std::vector<STrack> &resb, std::vector<STrack> &stracksa, std::vector<STrack> &stracksb);
+    // Active tracks as they will be at timestamp_ns (e.g. display or alert time, to hide
+    // inference latency). Read-only: the tracker state stays at the last frame.
+    void predict_to(int64_t timestamp_ns, std::vector<Object>& output) const;
 
-    void linear_assignment(std::vector<std::vector<float> > &cost_matrix, int cost_matrix_size, int cost_matrix_size_size, std::vector<int> &matches, std::vector<int> &unmatched_a, std::vector<int> &unmatched_b);
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack*> &atracks, std::vector<STrack> &btracks, int &dist_size, int &dist_size_size);
-    std::vector<std::vector<float> > iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks, int &dist_size, int &dist_size_size);
-    double lapjv(const std::vector<std::vector<float> > &cost, std::vector<int> &rowsol, std::vector<int> &colsol, 
-        bool extend_cost = false, float cost_limit = FLT_MAX, bool return_cost = false);
+    TrackMotion motion() const;
 
 private:
-    SimpleKalmanFilter kalman_filter;
-    
-    std::vector<STrack> tracked_stracks;
-    std::vector<STrack> lost_stracks;
-    std::vector<STrack> removed_stracks;
+    void associate(const std::vector<int>& track_slots, const std::vector<int>& det_indices, float iou_thresh,
+                   std::vector<int>& track_match, std::vector<int>& det_match);
+    void apply_detection(int slot, int det);
+    float advance_clock(int64_t timestamp_ns);
+    void predict_tracks(const std::vector<int>& slots, float dt);
+    void predict_pool(float dt);
+    void expire_lost();
+    void write_output(std::vector<Object>& output) const;
 
+private:
+    KalmanFilter kalman_filter;
+    TrackStore tracks;
+
+    // Track lists as store slots
+    std::vector<int> tracked_stracks;
+    LostTrackWheel lost_stracks;
+    std::vector<int> track_pool;
+    std::vector<int> next_tracked;
+    std::vector<int> second_candidates;
+    std::vector<int> expired;
+
+    // Current frame's detections, split into high and low score index lists
+    std::vector<std::array<float, 4> > det_tlwh;
+    std::vector<float> det_score;
+    std::vector<int> det_label;
+    std::vector<int> det_high;
+    std::vector<int> det_low;
+
+    // Clock: frame_id is the nominal-frame tick of clock_ns, counted from origin_ns
+    float frame_rate;
+    int64_t clock_ns;
+    int64_t origin_ns;
     int frame_id;
+    int expired_through; // last tick whose lost-track bucket was expired
     int track_buffer;
     float track_thresh;
     float high_thresh;
     float match_thresh;
+    int next_id;
+
+    // Association buffers, reused across frames
+    SpatialGrid det_grid;
+    std::vector<float> grid_x1;
+    std::vector<float> grid_y1;
+    std::vector<float> grid_x2;
+    std::vector<float> grid_y2;
+    std::vector<int> grid_hits;
+    SparseAssignment assignment;
+    std::vector<int> track_match_high;
+    std::vector<int> det_match_high;
+    std::vector<int> track_match_low;
+    std::vector<int> det_match_low;
+
+    // Matched tracks and their measurements, corrected in one batch after association
+    std::vector<int> update_slots;
+    std::vector<float> update_xyah;
 };
 
 #endif // BYTE_TRACKER_H
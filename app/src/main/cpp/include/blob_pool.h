@@ -0,0 +1,51 @@
+#ifndef BLOB_POOL_H
+#define BLOB_POOL_H
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include "allocator.h"
+
+struct AllocStats {
+    int64_t requests;      // fastMalloc calls from ncnn
+    int64_t system_allocs; // requests that missed the pool and hit the system allocator
+    int64_t system_frees;  // budgets returned to the system (clear / destruction)
+    int64_t bytes_held;    // bytes currently owned by the pool, idle or in use
+};
+
+// ncnn allocator that keeps every buffer it hands out and reuses it for later requests
+// of a similar size. Once one frame has run, the graph asks for the same set of sizes
+// every frame, so steady-state inference never reaches malloc/free.
+// Unlike ncnn::PoolAllocator, the bookkeeping lives in reserved vectors rather than
+// std::list nodes, so reuse itself does not allocate either; system_allocs staying
+// flat across frames is the check. Thread-safe: ncnn worker threads and the pipeline's
+// postprocess thread may free blobs concurrently with the inference thread.
+class BlobPool : public ncnn::Allocator {
+public:
+    BlobPool();
+    virtual ~BlobPool();
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+    // Returns idle budgets to the system; buffers in use are kept
+    void clear();
+
+    AllocStats stats() const;
+
+private:
+    BlobPool(const BlobPool&);
+    BlobPool& operator=(const BlobPool&);
+
+    struct Budget {
+        size_t size;
+        void* ptr;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Budget> idle;
+    std::vector<Budget> in_use;
+    AllocStats counters;
+};
+
+#endif // BLOB_POOL_H
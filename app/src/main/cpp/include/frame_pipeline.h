@@ -0,0 +1,195 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "mat.h"
+#include "image_preprocess.h"
+
+// What the stages do with a frame. Only FRAME_DETECT frames are preprocessed and inferred.
+enum FrameMode {
+    FRAME_DETECT = 0,  // run the network and update the tracker
+    FRAME_EXTRAPOLATE, // between keyframes: advance the tracks by their motion model
+    FRAME_HOLD,        // scene unchanged since the last inference: repeat the tracked boxes
+};
+
+// Header of a frame that skips inference: all the later stages need of it
+struct FrameStamp {
+    int64_t frame_id;
+    int64_t timestamp_ns;
+    FrameMode mode;
+};
+
+// Hand-off of depth one between a single producer and a single consumer that keeps frame
+// order across two kinds of item: payloads (frames that are inferred, with their buffers)
+// and stamps (frames that skip inference). A payload replaces an unread payload, so a slow
+// consumer always sees the newest one and never a backlog, and it also drops an unread stamp,
+// which is older. A stamp only replaces an older stamp and is delivered after the payload
+// it follows, so a frame without inference never displaces one that needs it.
+// Lock-free: payloads and stamps each live in a triple buffer, and both middle indices with
+// their unread flags share one atomic word that either side updates by compare-and-swap.
+// Slots are reused, so their buffers stay allocated.
+template<class T>
+class FrameSlot {
+public:
+    enum Item { NONE = 0, PAYLOAD, STAMP };
+
+    FrameSlot() : state(1 | (1 << STAMP_SHIFT)), back(2), front(0), stamp_back(2), stamp_front(0) {}
+
+    T& writeSlot() { return slots[back]; }
+
+    // Both return the number of unread items dropped
+    int publish() {
+        int prev = state.load(std::memory_order_relaxed);
+        int next;
+        do {
+            next = back | FRESH | (prev & (INDEX << STAMP_SHIFT)); // the stamp is older: unread flag cleared
+        } while (!state.compare_exchange_weak(prev, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+        back = prev & INDEX;
+        return ((prev & FRESH) ? 1 : 0) + ((prev & STAMP_FRESH) ? 1 : 0);
+    }
+
+    int publishStamp(const FrameStamp& s) {
+        stamps[stamp_back] = s;
+        int prev = state.load(std::memory_order_relaxed);
+        int next;
+        do {
+            next = (prev & (INDEX | FRESH)) | (stamp_back << STAMP_SHIFT) | STAMP_FRESH;
+        } while (!state.compare_exchange_weak(prev, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+        stamp_back = (prev >> STAMP_SHIFT) & INDEX;
+        return (prev & STAMP_FRESH) ? 1 : 0;
+    }
+
+    // Oldest unread item: the payload (valid until the next take()) or else the stamp
+    Item take(T*& payload, FrameStamp& s) {
+        int prev = state.load(std::memory_order_acquire);
+        while (true) {
+            int next;
+            if (prev & FRESH) {
+                next = front | (prev & ~(INDEX | FRESH));
+            } else if (prev & STAMP_FRESH) {
+                next = (prev & (INDEX | FRESH)) | (stamp_front << STAMP_SHIFT);
+            } else {
+                return NONE;
+            }
+            if (state.compare_exchange_weak(prev, next, std::memory_order_acq_rel, std::memory_order_acquire)) break;
+        }
+        if (prev & FRESH) {
+            front = prev & INDEX;
+            payload = &slots[front];
+            return PAYLOAD;
+        }
+        stamp_front = (prev >> STAMP_SHIFT) & INDEX;
+        s = stamps[stamp_front];
+        return STAMP;
+    }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+    static const int STAMP_SHIFT = 3;
+    static const int STAMP_FRESH = 4 << STAMP_SHIFT;
+
+    T slots[3];
+    FrameStamp stamps[3];
+    std::atomic<int> state; // payload middle | FRESH | (stamp middle | FRESH) << STAMP_SHIFT, shared
+    int back;               // producer only
+    int front;              // consumer only
+    int stamp_back;         // producer only
+    int stamp_front;        // consumer only
+};
+
+// Wakes a parked stage thread. Data moves through FrameSlot; this is only the doorbell.
+class StageSignal {
+public:
+    StageSignal() : seq(0) {}
+
+    void ring() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            seq++;
+        }
+        cv.notify_one();
+    }
+
+    // Blocks until ring() was called after `seen`, then updates `seen`
+    void wait(unsigned int& seen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this, &seen] { return seq != seen; });
+        seen = seq;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    unsigned int seq;
+};
+
+struct PipelineFrame {
+    ncnn::Mat input;       // preprocessed tensor, storage reused across frames
+    InputTransform transform;
+    int64_t frame_id = 0;
+    int64_t timestamp_ns = 0;
+    FrameMode mode = FRAME_DETECT;
+};
+
+struct PipelineOutput {
+    ncnn::Mat output;      // raw model output, untouched unless mode is FRAME_DETECT
+    InputTransform transform;
+    int64_t frame_id = 0;
+    int64_t timestamp_ns = 0;
+    FrameMode mode = FRAME_DETECT;
+};
+
+// Three-stage frame pipeline: preprocess / infer / postprocess + track.
+// Stage 1 runs on the submitting thread (it reads the camera buffer, which is only
+// valid until the frame is closed) and writes straight into a pipeline-owned tensor.
+// Stages 2 and 3 each own a thread, so preprocessing of frame N+1, inference of frame N
+// and postprocessing of frame N-1 overlap and throughput approaches 1 / slowest stage.
+// Between stages sits a FrameSlot: a stage that falls behind drops stale frames
+// instead of queueing them, so latency stays bounded by one frame per stage. Frames that
+// skip inference (keyframe mode, motion gate) pass the infer stage as stamps in order and
+// never replace a frame waiting for inference or a finished inference.
+class FramePipeline {
+public:
+    // infer sees FRAME_DETECT frames only; finish sees every frame that was not dropped, in order
+    typedef std::function<void(const PipelineFrame&, PipelineOutput&)> InferFn;
+    typedef std::function<void(const PipelineOutput&)> FinishFn;
+
+    FramePipeline(const InferFn& infer, const FinishFn& finish);
+    ~FramePipeline();
+
+    // Producer side (one thread): fill the returned frame, then submit it. Never blocks.
+    PipelineFrame& beginFrame() { return to_infer.writeSlot(); }
+    void submitFrame(int64_t timestamp_ns);
+
+    int64_t framesSubmitted() const { return submitted.load(std::memory_order_relaxed); }
+    int64_t framesDropped() const { return dropped.load(std::memory_order_relaxed); }
+    int64_t framesFinished() const { return finished.load(std::memory_order_relaxed); }
+
+private:
+    void inferLoop();
+    void finishLoop();
+
+    InferFn infer_fn;
+    FinishFn finish_fn;
+
+    FrameSlot<PipelineFrame> to_infer;
+    FrameSlot<PipelineOutput> to_finish;
+    StageSignal infer_signal;
+    StageSignal finish_signal;
+
+    std::atomic<bool> running;
+    std::atomic<int64_t> submitted;
+    std::atomic<int64_t> dropped;
+    std::atomic<int64_t> finished;
+
+    std::thread infer_thread;
+    std::thread finish_thread;
+};
+
+#endif // FRAME_PIPELINE_H
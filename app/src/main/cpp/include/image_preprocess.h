@@ -0,0 +1,103 @@
+#ifndef IMAGE_PREPROCESS_H
+#define IMAGE_PREPROCESS_H
+
+#include <vector>
+#include "mat.h"
+
+// Three-plane view of an Android YUV_420_888 frame.
+// Works for both planar (I420, uv_pixel_stride == 1) and semi-planar
+// (NV12/NV21, uv_pixel_stride == 2) layouts since U and V are addressed separately.
+struct YUV420Image {
+    const unsigned char* y;
+    const unsigned char* u;
+    const unsigned char* v;
+    int width;
+    int height;
+    int y_row_stride;
+    int uv_row_stride;
+    int uv_pixel_stride;
+};
+
+// Mapping between source image pixels and network input pixels.
+// The source is rotated upright, then scaled into a resized_w x resized_h window placed at
+// (pad_x, pad_y) inside an input_w x input_h blob; everything outside the window is padding.
+// src_w x src_h is the upright size, so for 90/270 degrees it is the buffer size transposed.
+struct InputTransform {
+    int src_w;
+    int src_h;
+    int rotation; // clockwise degrees (0, 90, 180, 270) that turn the buffer upright
+    int input_w;
+    int input_h;
+    int resized_w;
+    int resized_h;
+    int pad_x;
+    int pad_y;
+    float scale_x; // resized_w / src_w
+    float scale_y; // resized_h / src_h
+
+    // Independent x/y scale to a fixed target_w x target_h (no padding)
+    static InputTransform stretch(int src_w, int src_h, int target_w, int target_h);
+
+    // Aspect-preserving fit inside max_w x max_h. With rect=true the blob is only
+    // padded up to the next multiple of stride (e.g. 640x480 stays 640x480),
+    // otherwise it is padded to the full max_w x max_h.
+    static InputTransform letterbox(int src_w, int src_h, int max_w, int max_h, int stride, bool rect);
+
+    // Upright size of a width x height buffer
+    static int uprightWidth(int width, int height, int rotation) { return rotation % 180 ? height : width; }
+    static int uprightHeight(int width, int height, int rotation) { return rotation % 180 ? width : height; }
+
+    // Network input coordinates -> upright source image coordinates
+    float toSrcX(float x) const { return (x - pad_x) / scale_x; }
+    float toSrcY(float y) const { return (y - pad_y) / scale_y; }
+};
+
+// Fused colour conversion + rotation + bilinear resize + 1/255 normalisation (+ letterbox
+// padding). Writes straight into the planar float blob the network consumes, so there is
+// no intermediate RGB, rotated or resized Mat per frame. The rotation is folded into the
+// sampling tables: an upright output row simply walks a source column.
+class InputPreprocessor {
+public:
+    InputPreprocessor();
+
+    // img and pixels are the unrotated buffers; tf.rotation says how to turn them upright
+    void fromYUV420(const YUV420Image& img, ncnn::Mat& out, const InputTransform& tf);
+    void fromRGBA(const unsigned char* pixels, int stride, ncnn::Mat& out, const InputTransform& tf);
+
+private:
+    // Buffer geometry the sampling tables were built for. Strides are part of it because
+    // the tables hold byte offsets; uv_* are 0 for RGBA.
+    struct SampleLayout {
+        int src_w;
+        int src_h;
+        int dst_w;
+        int dst_h;
+        int rotation;
+        int row_stride;
+        int pixel_bytes;
+        int uv_row_stride;
+        int uv_pixel_stride;
+    };
+
+    // Sampling tables are rebuilt only when the layout changes
+    void updateTables(const SampleLayout& layout);
+    void fillPadding(ncnn::Mat& out, const InputTransform& tf);
+
+    SampleLayout table_layout;
+
+    // Offsets are in bytes and split per output column / row: the top-left sample of output
+    // (x, y) is at x_ofs[x] + y_ofs[y], its right and lower neighbours step_x / step_y further
+    std::vector<int> x_ofs;     // source offset per output column
+    std::vector<float> x_alpha; // horizontal blend weight per output column
+    std::vector<int> x_uv;      // nearest chroma sample offset per output column
+    std::vector<int> y_ofs;     // source offset per output row
+    std::vector<float> y_alpha; // vertical blend weight per output row
+    std::vector<int> y_uv;      // nearest chroma sample offset per output row
+    int step_x;
+    int step_y;
+
+    // Per-row gather scratch (corner samples + chroma), reused across rows and frames
+    std::vector<float> row_buf;
+};
+
+#endif // IMAGE_PREPROCESS_H
@@ -0,0 +1,93 @@
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "image_preprocess.h"
+
+// Baseline JPEG decoder for camera frames (ESP32-CAM MJPEG) that feeds the detector without
+// an RGB or full-size intermediate.
+//
+// Blocks are inverse transformed straight into Y, Cb and Cr planes at the components' own
+// subsampling; the planes are handed out as a YUV420Image, so colour conversion, resize and
+// normalisation all happen in the one fused InputPreprocessor pass. When the frame is larger
+// than needed the IDCT itself downscales by 2, 4 or 8: only the low-frequency corner of
+// every block is transformed (4x4, 2x2 or the DC term), which costs a fraction of the full
+// 8x8 transform and acts as the anti-aliasing filter a plain subsample would lack.
+//
+// Supports what camera encoders produce: 8-bit sequential Huffman (baseline and extended),
+// one interleaved scan, greyscale or YCbCr with 4:4:4, 4:2:2, 4:4:0 or 4:2:0 sampling, restart
+// intervals, and streams that omit DHT (the standard tables of JPEG Annex K are assumed, as
+// for AVI/MJPEG), up to 8192 pixels per side. Progressive, arithmetic-coded and 12-bit files
+// and larger frames are rejected by readHeader() so the caller can fall back to a general
+// decoder.
+//
+// Not thread-safe; the planes are reused from frame to frame.
+class JpegDecoder {
+public:
+    JpegDecoder();
+
+    // Parses the markers up to the first scan. data must stay valid until decode() returns.
+    bool readHeader(const unsigned char* data, size_t size);
+    int width() const { return frame_w; }
+    int height() const { return frame_h; }
+
+    // Largest IDCT scale denominator (1, 2, 4 or 8) that still decodes the frame read last to
+    // at least min_w x min_h, so the bilinear resize that follows never upsamples
+    int scaleFor(int min_w, int min_h) const;
+
+    // Decodes the frame whose header was read last at 1/scale size. out points into the
+    // decoder's planes and stays valid until the next decode(). Fails on entropy-coded data
+    // that ends (or hits a marker) before the last MCU of a restart interval or of the frame.
+    bool decode(int scale, YUV420Image& out);
+
+private:
+    struct HuffTable {
+        // Codes up to FAST_BITS long resolve in one lookup: (length << 8) | symbol, 0 if longer
+        uint16_t fast[1 << 9];
+        // AC symbols whose magnitude bits fit in the same lookup:
+        // (value << 8) | (run << 4) | bits consumed, 0 otherwise
+        int32_t fast_ac[1 << 9];
+        int32_t max_code[17];   // largest code of each length, -1 if none
+        int32_t value_offset[17]; // code + value_offset[length] indexes values
+        unsigned char values[256];
+    };
+
+    struct Component {
+        int id;
+        int h;
+        int v;
+        int tq;
+        const HuffTable* dc;
+        const HuffTable* ac;
+        int dc_pred;
+        int pitch; // plane row bytes at the current scale
+        std::vector<unsigned char> plane;
+    };
+
+    bool readFrame(const unsigned char* p, size_t n);
+    bool readHuffman(const unsigned char* p, size_t n);
+    bool readQuant(const unsigned char* p, size_t n);
+    bool readScan(const unsigned char* p, size_t n);
+    static bool buildHuffman(const unsigned char* counts, const unsigned char* symbols, HuffTable& table);
+
+    HuffTable std_tables[2][2]; // Annex K [DC, AC][luma, chroma]
+    HuffTable tables[2][4];     // from DHT
+    const HuffTable* selected[2][4];
+    uint16_t quant[4][64];      // natural order
+    bool quant_defined[4];
+
+    Component comps[3];
+    int num_comps = 0;
+    int scan_comps[3];          // component indices in scan (MCU) order
+    int frame_w = 0;
+    int frame_h = 0;
+    int max_h = 1;
+    int max_v = 1;
+    int restart_interval = 0;
+    const unsigned char* scan_begin = nullptr;
+    const unsigned char* data_end = nullptr;
+};
+
+#endif // JPEG_DECODER_H
@@ -0,0 +1,38 @@
+#ifndef KALMAN_FILTER_H
+#define KALMAN_FILTER_H
+
+#include <array>
+
+// Constant-velocity Kalman filter over the xyah box state (ByteTrack / DeepSORT model).
+//
+// Motion, process noise, measurement and measurement noise never couple different
+// coordinates, so the 8x8 covariance stays block-diagonal: four independent 2x2
+// (position, velocity) blocks, one per coordinate of (cx, cy, aspect_ratio, height).
+// Only those blocks are stored, and the four blocks of a track are filtered together
+// in the four SIMD lanes. predict/update run over a batch of track slots at once.
+//
+// Time is measured in frames of the nominal frame rate: velocities are per frame and the
+// noise weights are tuned for one-frame steps, but predict() takes any step dt >= 0.
+class KalmanFilter
+{
+public:
+    typedef std::array<float, 8> Mean;        // (cx, cy, a, h, vx, vy, va, vh)
+    typedef std::array<float, 12> Covariance; // coordinate k: var(pos) at k, cov(pos, vel) at 4 + k, var(vel) at 8 + k
+
+    KalmanFilter();
+
+    void initiate(const float* xyah, Mean& mean, Covariance& covariance) const;
+
+    // Advance means[slots[i]] / covariances[slots[i]] by dt frames; process noise grows
+    // linearly with dt, so n steps of dt = 1 and one step of dt = n add the same noise
+    void predict(const int* slots, int count, float dt, Mean* means, Covariance* covariances) const;
+
+    // Correct each slot with its measurement xyah[i * 4 .. i * 4 + 3]
+    void update(const int* slots, const float* xyah, int count, Mean* means, Covariance* covariances) const;
+
+    // Noise scales relative to the box height
+    float std_weight_position;
+    float std_weight_velocity;
+};
+
+#endif // KALMAN_FILTER_H
@@ -0,0 +1,55 @@
+#ifndef KEYFRAME_SCHEDULER_H
+#define KEYFRAME_SCHEDULER_H
+
+#include <stdint.h>
+#include <mutex>
+#include "ByteTracker.h"
+
+// Decides which camera frames run the detector. Frames in between are answered by the
+// tracker's motion model alone, so box output keeps up with the camera while the network
+// only sees every Nth frame.
+//
+// The interval N adapts to two things:
+//  - detector latency: N never drops below the number of camera frames one inference
+//    takes, since running it more often than the device can keep up only drops frames;
+//  - scene motion: fast tracks (relative to their size) shorten N, a static scene lets it
+//    grow up to the configured maximum. New tracks keep N short until a second detection
+//    has given them a velocity.
+// N falls to a new target at once but grows by at most one frame per keyframe, so the
+// velocity estimates behind a longer interval have been confirmed by several detections.
+// A keyframe is also forced as soon as any track's predicted position gets too uncertain.
+//
+// nextFrame() is called by the frame producer, the report*() calls by whichever thread
+// runs inference and tracking; all members are guarded by one mutex.
+class KeyframeScheduler {
+public:
+    // max_interval <= 1 runs the detector on every frame (the default)
+    void setMaxInterval(int max_interval);
+
+    // Called once per incoming frame; true if the detector should run on it
+    bool nextFrame(int64_t timestamp_ns);
+
+    void reportDetectorLatency(double ms);
+    // Tracker state after a keyframe update or an extrapolated frame
+    void reportTracks(const TrackMotion& motion);
+    // Runs the detector on the next frame regardless of the interval
+    void requestKeyframe();
+
+    int interval() const;
+
+private:
+    void updateInterval();
+
+    mutable std::mutex mutex;
+    int max_frames = 1;
+    int current_interval = 1;
+    int target_interval = 1;
+    int frames_since_keyframe = 0;
+    bool force_keyframe = true;
+    int64_t last_timestamp_ns = 0;
+    double frame_ms = 0;    // smoothed camera frame period
+    double detector_ms = 0; // smoothed inference latency
+    TrackMotion motion;
+};
+
+#endif // KEYFRAME_SCHEDULER_H
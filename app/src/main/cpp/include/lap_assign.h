@@ -0,0 +1,71 @@
+#ifndef LAP_ASSIGN_H
+#define LAP_ASSIGN_H
+
+#include <utility>
+#include <vector>
+
+// Optimal track/detection assignment on a sparse cost matrix.
+// Only gated pairs are added as edges. solve() finds the minimum-cost assignment where
+// leaving a row or column unassigned costs cost_limit / 2 (ByteTrack's lapjv with
+// extend_cost and cost_limit), i.e. a pair is only worth taking if its cost is below
+// cost_limit. Rows and columns are first cut into connected components of the edge
+// graph; each component is solved with Jonker-Volgenant shortest augmenting paths
+// (Dijkstra with row/column potentials) over its own edges only, so a crowd of
+// independent objects costs a sum of tiny problems and even a large component never
+// touches the pairs that were gated out. All buffers are kept across frames.
+class SparseAssignment {
+public:
+    void reset(int rows, int cols);
+    void add(int row, int col, float cost);
+
+    // row_to_col / col_to_row receive the match of each row / column, or -1
+    void solve(float cost_limit, std::vector<int>& row_to_col, std::vector<int>& col_to_row);
+
+    int numComponents() const { return num_components; }
+
+private:
+    int find(int node);
+    void solveComponent(int begin, int end, float cost_limit, std::vector<int>& row_to_col, std::vector<int>& col_to_row);
+    void relax(int row, float base);
+
+    int num_rows = 0;
+    int num_cols = 0;
+    int num_components = 0;
+
+    // Edges as parallel columns
+    std::vector<int> edge_row;
+    std::vector<int> edge_col;
+    std::vector<float> edge_cost;
+
+    // Union-find over rows [0, num_rows) and columns [num_rows, num_rows + num_cols)
+    std::vector<int> parent;
+    std::vector<int> component_of;   // root node -> component index
+    std::vector<int> component_start;
+    std::vector<int> sorted_edges;   // edge indices grouped by component
+
+    // Per-component scratch
+    std::vector<int> local_row;      // global row -> local index, -1 outside the component
+    std::vector<int> local_col;
+    std::vector<int> rows_in;        // local -> global
+    std::vector<int> cols_in;
+
+    // Component edges in CSR order by local row; column c + i is row i's "unmatched" column
+    std::vector<int> row_start;
+    std::vector<int> adj_col;
+    std::vector<float> adj_cost;     // cost - cost_limit, negative for every gated pair
+    std::vector<int> fill_pos;
+
+    // Shortest augmenting path state
+    std::vector<float> row_potential;
+    std::vector<float> col_potential;
+    std::vector<int> row_assigned;
+    std::vector<int> col_assigned;
+    std::vector<float> dist;
+    std::vector<int> pred;
+    std::vector<char> done;
+    std::vector<int> touched;        // columns with a tentative distance
+    std::vector<int> settled;        // columns popped in the current search
+    std::vector<std::pair<float, int> > heap;
+};
+
+#endif // LAP_ASSIGN_H
@@ -0,0 +1,89 @@
+#ifndef MJPEG_DEMUXER_H
+#define MJPEG_DEMUXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// One JPEG of the stream. data points into the demuxer's buffer and stays valid until the
+// next call to next(); timestamp_ns is the arrival of its last byte (CLOCK_MONOTONIC).
+struct MjpegFrame {
+    const unsigned char* data;
+    size_t size;
+    int64_t timestamp_ns;
+};
+
+// Splits a multipart/x-mixed-replace MJPEG stream (ESP32-CAM and most IP cameras) read from
+// a file descriptor into JPEG frames without copying them.
+//
+// The decoded body is read straight into one contiguous window that only slides (or grows)
+// when a frame would not fit behind the data still unparsed, so every frame is a single
+// span and nearly all bytes land in place with one read(). A part's Content-Length is used
+// to jump straight over the payload; the boundary is only searched for (SIMD first/last
+// byte filter) between parts and for parts that do not announce their length.
+//
+// HTTP response headers and chunked transfer coding are handled on a small side buffer:
+// payload reads are capped at the current chunk, so chunk framing never ends up inside a
+// frame and only the few bytes read together with a chunk-size line are copied.
+//
+// next() blocks in read(); cancel() may be called from another thread to unblock it.
+class MjpegDemuxer {
+public:
+    // fd is positioned at an HTTP response; the boundary comes from its Content-Type
+    explicit MjpegDemuxer(int fd, bool owns_fd = true);
+    // fd is positioned at a bare multipart body (e.g. a recording) with a known boundary
+    MjpegDemuxer(int fd, const std::string& boundary, bool owns_fd = true);
+    ~MjpegDemuxer();
+
+    // Opens a TCP connection and sends the GET request; returns the socket or -1.
+    // timeout_ms bounds the connect and every later read.
+    static int connect(const char* host, int port, const char* path, int timeout_ms);
+
+    // Next JPEG frame; false at the end of the stream, on errors and after cancel()
+    bool next(MjpegFrame& frame);
+    void cancel();
+
+    const std::string& boundary() const { return boundary_name; }
+    int64_t bytesRead() const { return bytes_read; }
+
+private:
+    MjpegDemuxer(const MjpegDemuxer&);
+    MjpegDemuxer& operator=(const MjpegDemuxer&);
+
+    void setBoundary(const std::string& boundary);
+    bool readResponseHead();
+    bool readLine(std::string& line);
+    bool startChunk();
+    long readRaw(unsigned char* dst, size_t max);
+    long readBody(unsigned char* dst, size_t max);
+    bool fill(size_t need);
+
+    int fd;
+    bool owns_fd;
+    bool failed = false;
+    bool at_eof = false;
+    std::atomic<bool> cancelled{false};
+    bool head_pending;
+    bool chunked = false;
+    size_t chunk_left = 0;
+    bool chunk_trailer_crlf = false; // CRLF closing the previous chunk not consumed yet
+    int64_t bytes_read = 0;
+
+    std::string boundary_name;
+    std::string delimiter;        // "--" + boundary
+    std::string closing;          // CRLF + delimiter, ends a payload of unknown length
+
+    // Undecoded bytes: HTTP header and chunk-size lines plus whatever came with them
+    std::vector<unsigned char> side;
+    size_t side_begin = 0;
+    size_t side_end = 0;
+
+    // Decoded body; [begin, end) is unparsed, everything before begin may be dropped
+    std::vector<unsigned char> window;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+#endif // MJPEG_DEMUXER_H
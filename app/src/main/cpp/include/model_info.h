@@ -0,0 +1,30 @@
+#ifndef MODEL_INFO_H
+#define MODEL_INFO_H
+
+#include <string>
+#include <vector>
+
+// Per-model descriptor built at load time from the .param graph and the
+// Ultralytics metadata.yaml, so preprocessing and decoding specialise on the
+// actual model instead of compile-time constants.
+struct ModelInfo {
+    std::string input_name = "in0";
+    std::string output_name = "out0";
+    int input_w = 640;
+    int input_h = 640;
+    int stride = 32;
+    int num_classes = 80;
+    int num_anchors = 0;      // anchor count baked into the graph, 0 if the graph is shape-agnostic
+    bool fixed_shape = false; // MemoryData anchors present: the input must be exactly input_w x input_h
+    bool end2end = false;     // metadata says the one-to-one (NMS-free) head was exported
+    std::vector<std::string> class_names;
+};
+
+// Reads blob names, the Input layer shape and baked anchor grids from ncnn .param text.
+bool parse_param_graph(const char* text, size_t len, ModelInfo& info);
+
+// Reads imgsz, stride, names and end2end from an Ultralytics metadata.yaml.
+// Only the flat subset Ultralytics writes is understood; unknown keys are ignored.
+bool parse_metadata_yaml(const char* text, size_t len, ModelInfo& info);
+
+#endif // MODEL_INFO_H
@@ -0,0 +1,55 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Skips inference while the scene stands still. Each candidate frame is reduced to an
+// 80x60 luma thumbnail (every cell averages a 4x4 grid of samples, so the full frame is
+// never read) and compared against the thumbnail of the last frame that was inferred.
+// The score is the mean absolute difference of the worst 8x6 block, so a small object
+// entering one corner counts as much as a global change.
+//
+// A frame passes when the score exceeds max(MIN_THRESHOLD, NOISE_FACTOR x noise), where
+// noise is a running average of the scores of held frames (sensor noise, flicker) capped
+// at a fixed ceiling, or when the last inference is older than the staleness bound.
+//
+// Used from the thread that feeds frames; setEnabled() and requestRefresh() may come from
+// any thread.
+class MotionGate {
+public:
+    static const int THUMB_W = 80;
+    static const int THUMB_H = 60;
+
+    // Off by default. max_stale bounds the milliseconds between two inferences while gated.
+    void setEnabled(bool enabled, int max_stale);
+    bool enabled() const { return is_enabled.load(std::memory_order_relaxed); }
+
+    // Luma of the next candidate frame: a Y plane, or RGBA8888 (luma ~ (R + 2G + B) / 4)
+    void sampleY(const unsigned char* y, int width, int height, int stride);
+    void sampleRGBA(const unsigned char* rgba, int width, int height, int stride);
+
+    // True if the sampled frame should be inferred; it then becomes the reference
+    bool admit(int64_t timestamp_ns);
+    // Lets the next frame through regardless of the score
+    void requestRefresh() { refresh.store(true, std::memory_order_relaxed); }
+
+    float lastScore() const { return last_score; }
+
+private:
+    float score();
+
+    std::atomic<bool> is_enabled{false};
+    std::atomic<int> max_stale_ms{1000};
+    std::atomic<bool> refresh{false};
+
+    unsigned char current[THUMB_W * THUMB_H];
+    unsigned char reference[THUMB_W * THUMB_H];
+    unsigned int block_sad[THUMB_W / 8];
+    bool has_reference = false;
+    int64_t reference_ns = 0;
+    float noise = 0.0f;
+    float last_score = 0.0f;
+};
+
+#endif // MOTION_GATE_H
@@ -0,0 +1,23 @@
+#ifndef NATIVE_LOG_H
+#define NATIVE_LOG_H
+
+// LOGD / LOGE for the detection core: logcat on Android, stderr on host builds.
+// Host debug logging is per frame and therefore off unless YOLO_HOST_VERBOSE is defined.
+#define LOG_TAG "YOLO_NATIVE"
+
+#if __ANDROID__
+#include <android/log.h>
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <stdio.h>
+#define LOG_HOST(level, ...) do { fprintf(stderr, level "/" LOG_TAG ": " __VA_ARGS__); fputc('\n', stderr); } while (0)
+#ifdef YOLO_HOST_VERBOSE
+#define LOGD(...) LOG_HOST("D", __VA_ARGS__)
+#else
+#define LOGD(...) do { if (0) LOG_HOST("D", __VA_ARGS__); } while (0)
+#endif
+#define LOGE(...) LOG_HOST("E", __VA_ARGS__)
+#endif
+
+#endif // NATIVE_LOG_H
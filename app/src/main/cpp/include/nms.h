@@ -0,0 +1,45 @@
+#ifndef NMS_H
+#define NMS_H
+
+#include <stdint.h>
+#include <vector>
+#include "spatial_grid.h"
+
+struct NmsOptions {
+    float iou_threshold;
+    int max_candidates;  // top-K by score considered at all (partial selection before the sort)
+    int max_detections;  // stop once this many boxes are kept
+    bool class_aware;    // only boxes of the same class suppress each other
+
+    NmsOptions() : iou_threshold(0.7f), max_candidates(1024), max_detections(300), class_aware(false) {}
+};
+
+// Greedy non-maximum suppression with bounded cost.
+// Candidates are capped to the top-K scores, gathered into score-sorted SoA columns with
+// precomputed areas, and each kept box tests a whole block of later boxes at once in SIMD
+// lanes, setting bits in a suppression mask instead of rebuilding an index list.
+// Class-aware mode shifts every box by class_id * (max coordinate + 1) so boxes of different
+// classes can never overlap and one pass handles all classes.
+// With many candidates the sweep switches to a SpatialGrid and only tests intersecting pairs.
+class NmsEngine {
+public:
+    // boxes: [x1, y1, x2, y2] per candidate. keep receives candidate indices in descending score order.
+    void run(const std::vector<float>& boxes, const std::vector<float>& scores, const std::vector<int>& class_ids,
+             const NmsOptions& opt, std::vector<int>& keep);
+
+private:
+    void sweepGrid(const std::vector<int>& class_ids, const NmsOptions& opt, int n, std::vector<int>& keep);
+
+    // Reused across frames so steady-state calls do not allocate
+    std::vector<int> order;
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    std::vector<float> area;
+    std::vector<uint32_t> suppressed;
+    SpatialGrid grid;
+    std::vector<int> neighbours;
+};
+
+#endif // NMS_H
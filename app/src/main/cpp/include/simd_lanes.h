@@ -0,0 +1,150 @@
+#ifndef SIMD_LANES_H
+#define SIMD_LANES_H
+
+// Minimal float lane abstraction shared by the hot loops.
+// Kernels are written once as templates over a lane type and instantiated for
+// a 4-wide SIMD register (NEON or SSE2) plus plain float for tails/fallback:
+//
+//   int x = 0;
+// #if HAVE_SIMD_LANES
+//   x = kernel<SimdLanes>(..., x, n);
+// #endif
+//   kernel<ScalarLanes>(..., x, n);
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#elif __SSE2__
+#include <emmintrin.h>
+#endif
+
+struct ScalarLanes {
+    typedef float V;
+    typedef bool M;
+    static const int N = 1;
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V dup(float x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static M gt(V a, V b) { return a > b; }
+    static V select(M m, V a, V b) { return m ? a : b; }
+    static int bits(M m) { return m ? 1 : 0; }
+};
+
+#if __ARM_NEON
+struct SimdLanes {
+    typedef float32x4_t V;
+    typedef uint32x4_t M;
+    static const int N = 4;
+    static V load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, V v) { vst1q_f32(p, v); }
+    static V dup(float x) { return vdupq_n_f32(x); }
+    static V add(V a, V b) { return vaddq_f32(a, b); }
+    static V sub(V a, V b) { return vsubq_f32(a, b); }
+    static V mul(V a, V b) { return vmulq_f32(a, b); }
+#if __aarch64__
+    static V div(V a, V b) { return vdivq_f32(a, b); }
+#else
+    // ARMv7 has no vector divide: reciprocal estimate refined by two Newton-Raphson steps
+    static V div(V a, V b) {
+        V r = vrecpeq_f32(b);
+        r = vmulq_f32(vrecpsq_f32(b, r), r);
+        r = vmulq_f32(vrecpsq_f32(b, r), r);
+        return vmulq_f32(a, r);
+    }
+#endif
+    static V min(V a, V b) { return vminq_f32(a, b); }
+    static V max(V a, V b) { return vmaxq_f32(a, b); }
+    static M gt(V a, V b) { return vcgtq_f32(a, b); }
+    static V select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+    // Lane i of the mask -> bit i of the result
+    static int bits(M m) {
+        static const uint32_t weights[4] = {1, 2, 4, 8};
+        uint32x4_t t = vandq_u32(m, vld1q_u32(weights));
+        uint32x2_t p = vorr_u32(vget_low_u32(t), vget_high_u32(t));
+        return (int)(vget_lane_u32(p, 0) | vget_lane_u32(p, 1));
+    }
+};
+#define HAVE_SIMD_LANES 1
+#elif __SSE2__
+struct SimdLanes {
+    typedef __m128 V;
+    typedef __m128 M;
+    static const int N = 4;
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V dup(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    // Lane i of the mask -> bit i of the result
+    static int bits(M m) { return _mm_movemask_ps(m); }
+};
+#define HAVE_SIMD_LANES 1
+#else
+#define HAVE_SIMD_LANES 0
+#endif
+
+// Byte lanes, same dispatch as above.
+// sad() adds |a - b| of each group of 8 bytes to out[group], so a kernel over N-byte
+// steps accumulates per-8-pixel block sums whatever the lane width.
+// match() flags the N positions i where p[i] == first and p[i + gap] == last (bit i of
+// the result): the candidate filter of a substring search, checked with memcmp after.
+struct ScalarBytes {
+    static const int N = 1;
+    static void sad(const unsigned char* a, const unsigned char* b, unsigned int* out) {
+        *out += *a > *b ? *a - *b : *b - *a;
+    }
+    static int match(const unsigned char* p, unsigned char first, unsigned char last, int gap) {
+        return p[0] == first && p[gap] == last ? 1 : 0;
+    }
+};
+
+#if __ARM_NEON
+struct SimdBytes {
+    static const int N = 16;
+    static void sad(const unsigned char* a, const unsigned char* b, unsigned int* out) {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a), vld1q_u8(b));
+        uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(d)));
+        out[0] += (unsigned int)vgetq_lane_u64(s, 0);
+        out[1] += (unsigned int)vgetq_lane_u64(s, 1);
+    }
+    static int match(const unsigned char* p, unsigned char first, unsigned char last, int gap) {
+        static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(p), vdupq_n_u8(first)),
+                                 vceqq_u8(vld1q_u8(p + gap), vdupq_n_u8(last)));
+        // Lane i -> bit i: weight each lane, then three pairwise adds leave the low and
+        // high halves' masks in bytes 0 and 1
+        uint8x16_t t = vandq_u8(eq, vld1q_u8(weights));
+        uint8x8_t m = vpadd_u8(vget_low_u8(t), vget_high_u8(t));
+        m = vpadd_u8(m, m);
+        m = vpadd_u8(m, m);
+        return vget_lane_u8(m, 0) | (vget_lane_u8(m, 1) << 8);
+    }
+};
+#elif __SSE2__
+struct SimdBytes {
+    static const int N = 16;
+    static void sad(const unsigned char* a, const unsigned char* b, unsigned int* out) {
+        __m128i s = _mm_sad_epu8(_mm_loadu_si128((const __m128i*)a), _mm_loadu_si128((const __m128i*)b));
+        out[0] += (unsigned int)_mm_cvtsi128_si32(s);
+        out[1] += (unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+    }
+    static int match(const unsigned char* p, unsigned char first, unsigned char last, int gap) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8((char)first));
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + gap)), _mm_set1_epi8((char)last));
+        return _mm_movemask_epi8(_mm_and_si128(a, b));
+    }
+};
+#endif
+
+#endif // SIMD_LANES_H
@@ -0,0 +1,48 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <vector>
+
+// Uniform-grid index over axis-aligned boxes, for enumerating only the pairs that can overlap.
+// Each box is stored once, in the cell holding its top-left corner; a query scans the cells
+// from its own top-left minus the largest indexed box size to its bottom-right, so every
+// candidate is seen exactly once without per-query dedup. The cell size follows the mean box
+// size, and boxes far larger than a cell sit in a short list every query checks, so a few
+// huge boxes cannot widen every query. Cells are CSR-style flat arrays rebuilt per call;
+// buffers are kept across frames.
+class SpatialGrid {
+public:
+    // Indexes count boxes given as x1/y1/x2/y2 columns (copied)
+    void build(const float* x1, const float* y1, const float* x2, const float* y2, int count);
+
+    // Appends every indexed box whose rectangle overlaps the query with positive area
+    void query(float x1, float y1, float x2, float y2, std::vector<int>& out) const;
+
+    int size() const { return (int)bx1.size(); }
+
+private:
+    int cellOf(float v, float origin, int cells) const;
+    bool overlaps(int j, float x1, float y1, float x2, float y2) const {
+        return (x2 < bx2[j] ? x2 : bx2[j]) > (x1 > bx1[j] ? x1 : bx1[j]) &&
+               (y2 < by2[j] ? y2 : by2[j]) > (y1 > by1[j] ? y1 : by1[j]);
+    }
+
+    std::vector<float> bx1;
+    std::vector<float> by1;
+    std::vector<float> bx2;
+    std::vector<float> by2;
+
+    float origin_x = 0.0f;
+    float origin_y = 0.0f;
+    float inv_cell = 1.0f;
+    float reach_w = 0.0f; // largest gridded box size: how far left/up a query must look
+    float reach_h = 0.0f;
+    int grid_w = 0;
+    int grid_h = 0;
+    std::vector<int> cell_start; // grid_w * grid_h + 1 offsets into cell_items
+    std::vector<int> cell_items;
+    std::vector<int> cursor;
+    std::vector<int> oversize;
+};
+
+#endif // SPATIAL_GRID_H
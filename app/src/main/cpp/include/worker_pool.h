@@ -0,0 +1,40 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small persistent thread pool for splitting per-frame loops into chunks.
+// Threads are created once, so a parallel_for costs a wake-up rather than a spawn.
+class WorkerPool {
+public:
+    explicit WorkerPool(int num_threads);
+    ~WorkerPool();
+
+    int size() const { return (int)threads.size() + 1; }
+
+    // Runs fn(0) .. fn(num_tasks - 1) and blocks until all have finished.
+    // The calling thread takes part, so a pool of size 1 runs everything inline.
+    void parallel_for(int num_tasks, const std::function<void(int)>& fn);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+
+    const std::function<void(int)>* job;
+    int job_tasks;
+    int next_task;
+    int pending_tasks;
+    unsigned int generation;
+    bool stopping;
+};
+
+#endif // WORKER_POOL_H
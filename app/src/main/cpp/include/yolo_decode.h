@@ -0,0 +1,54 @@
+#ifndef YOLO_DECODE_H
+#define YOLO_DECODE_H
+
+#include <vector>
+#include "mat.h"
+#include "worker_pool.h"
+
+// Anchor that cleared the confidence threshold, in network input coordinates
+struct Candidate {
+    float cx;
+    float cy;
+    float w;
+    float h;
+    float score;
+    int class_id;
+};
+
+enum HeadType {
+    HEAD_DENSE = 0, // YOLOv8/11 style (4 + num_classes) x num_anchors, needs NMS
+    HEAD_END2END    // YOLO26 one-to-one head: max_det rows of [x1, y1, x2, y2, score, class], NMS-free
+};
+
+// Classifies a head from the shape of its output blob. Rows of 6 values are the end-to-end
+// layout; anything else is treated as the dense head.
+HeadType detect_head_type(const ncnn::Mat& output);
+
+// Decodes the end-to-end head: already suppressed top-K rows, kept in model order.
+void decode_end2end(const ncnn::Mat& output, const std::vector<int>& class_ids, float conf_threshold,
+                    std::vector<Candidate>& candidates);
+
+// Decoder for the dense YOLOv8/11 head: a (4 + num_classes) x num_anchors blob
+// where each row is one feature (cx, cy, w, h, class scores...) across all anchors.
+// The head is read in this native class-major layout: per-anchor max/argmax runs
+// over contiguous rows in SIMD lanes, and box rows are only touched for anchors
+// that pass the threshold. The anchor range is split across the worker pool.
+// Only the class rows listed in class_ids (sorted ascending) are read, so a class subset also
+// shrinks the argmax work; other classes never produce candidates.
+class DenseHeadDecoder {
+public:
+    explicit DenseHeadDecoder(int num_threads);
+
+    void decode(const ncnn::Mat& output, const std::vector<int>& class_ids, float conf_threshold, std::vector<Candidate>& candidates);
+
+private:
+    void decodeRange(const ncnn::Mat& output, const std::vector<int>& class_ids, float conf_threshold,
+                     int begin, int end, std::vector<float>& scratch, std::vector<Candidate>& out);
+
+    WorkerPool pool;
+    // One candidate list and score/argmax scratch per chunk, reused across frames
+    std::vector<std::vector<Candidate> > chunk_candidates;
+    std::vector<std::vector<float> > chunk_scratch;
+};
+
+#endif // YOLO_DECODE_H
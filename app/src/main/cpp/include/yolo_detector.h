@@ -1,12 +1,26 @@
-#include <jni.h>
-#include <android/bitmap.h>
-#include "../ncnn/include/ncnn/net.h"
-#include "ByteTracker.h"
+#ifndef YOLO_DETECTOR_H
+#define YOLO_DETECTOR_H
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+// Platform-neutral detection core: plain pixel buffers in, DetectionResult out.
+// JNI, Bitmap/ImageProxy access and asset loading live in jni_bridge.cpp.
+#include "net.h"
+#include "datareader.h"
+#include "ByteTracker.h"
+#include "image_preprocess.h"
+#include "yolo_decode.h"
+#include "nms.h"
+#include "model_info.h"
+#include "frame_pipeline.h"
+#include "blob_pool.h"
+#include "keyframe_scheduler.h"
+#include "motion_gate.h"
+#include "jpeg_decoder.h"
+#include <functional>
+#include <mutex>
+#include <string>
 
+// Boxes from detect*(), predictTo() and the pipeline are normalized to [0, 1] of the upright
+// frame; postprocess() returns upright source pixels.
 struct DetectionResult {
     int classId;
     float confidence;
@@ -17,38 +31,187 @@ struct DetectionResult {
     int trackId; // Added trackId
 };
 
+// Wall time of each stage of the last synchronous detect*() call, in milliseconds.
+// On frames without inference (keyframe mode, motion gate) only track_ms is measured.
+struct StageTimings {
+    double jpeg_ms = 0; // detectJPEG() only; 0 when the frame was extrapolated without decoding
+    double preprocess_ms = 0;
+    double extract_ms = 0;
+    double decode_ms = 0;
+    double nms_ms = 0;
+    double track_ms = 0;
+    bool keyframe = true;
+};
+
+// Counters of the JPEG input path (detectJPEG() and submitJPEG() together)
+struct JpegStats {
+    int64_t frames = 0;    // decoded
+    int64_t failures = 0;  // unsupported (the caller fell back to its own decoder) or corrupt (held)
+    int64_t skipped = 0;   // extrapolated by the keyframe scheduler without being decoded
+    int64_t last_us = 0;   // decode time of the last decoded frame
+    int64_t total_us = 0;
+    int last_scale = 0;    // IDCT scale denominator of the last decoded frame
+};
+
 class YOLODetector {
 public:
     YOLODetector();
     ~YOLODetector();
 
-    bool loadModel(AAssetManager* mgr, const char* param, const char* bin);
-    std::vector<DetectionResult> detect(JNIEnv* env, jobject bitmap);
-    std::vector<DetectionResult> detectFromImageProxy(JNIEnv* env, jobject imageProxy);
+    // Returns the whole contents of a model-side text file (.param, metadata.yaml), false if absent
+    typedef std::function<bool(const std::string& name, std::string& contents)> ModelFileReader;
+
+    // param_name is the .param file name as read_file knows it; metadata.yaml is looked up next to it
+    bool loadModel(const ncnn::DataReader& param_reader, const ncnn::DataReader& bin_reader,
+                   const char* param_name, const ModelFileReader& read_file);
+    // Filesystem paths, for host builds and tools
+    bool loadModel(const char* param_path, const char* bin_path);
+
+    // Both take effect on the next loadModel(). 0 keeps the default (big cores / model shape);
+    // the input size is ignored for graphs with a baked anchor grid.
+    void setNumThreads(int num_threads);
+    void setInputSize(int width, int height);
+
+    // RGBA8888 rows of `stride` bytes. timestamp_ns is the capture time on the monotonic clock
+    // (System.nanoTime() / CLOCK_MONOTONIC); the tracker integrates motion over real time
+    // between frames. 0 stamps the frame with the time of the call.
+    // rotation is the clockwise turn (0, 90, 180, 270) that makes the buffer upright, e.g. the
+    // camera's rotationDegrees; the network sees the upright frame and boxes refer to it.
+    std::vector<DetectionResult> detectRGBA(const unsigned char* pixels, int width, int height, int stride,
+                                            int64_t timestamp_ns = 0, int rotation = 0);
+    std::vector<DetectionResult> detectYUV420(const YUV420Image& img, int64_t timestamp_ns = 0, int rotation = 0);
+    // A compressed frame (e.g. one MJPEG part), decoded natively at the smallest IDCT scale that
+    // still covers the network input and fed to the YUV path. Frames the keyframe scheduler
+    // extrapolates are not decoded at all. Returns false, with results empty and the frame not
+    // counted by the keyframe scheduler or motion gate, when the data is not a JPEG this decoder
+    // handles (see JpegDecoder); decode it elsewhere and use detectRGBA(). Corrupt data in a
+    // supported JPEG repeats the last boxes, like a held frame.
+    bool detectJPEG(const unsigned char* data, size_t size, std::vector<DetectionResult>& results,
+                    int64_t timestamp_ns = 0, int rotation = 0);
+
+    // Tracked boxes extrapolated to timestamp_ns (same clock), e.g. the display or alert time,
+    // to hide inference latency. Does not advance the tracker; safe from any thread.
+    std::vector<DetectionResult> predictTo(int64_t timestamp_ns);
+
+    // Letterbox keeps the aspect ratio and pads with grey. With rect=true the input is only
+    // padded to the next stride multiple (640x480 stays 640x480); this needs a model exported
+    // with a dynamic input shape and is ignored for graphs with a baked anchor grid.
+    // Safe to call from another thread; takes effect on the next frame.
+    void setLetterbox(bool enabled, bool rect);
+
+    // Restricts decoding, NMS and tracking to the given class ids (empty = all classes).
+    // Safe to call from another thread; takes effect on the next frame.
+    void setClassFilter(const std::vector<int>& class_ids);
+
+    // Keyframe mode: the network runs on at most every max_frames-th frame and the tracker
+    // extrapolates boxes on the frames in between. The actual interval adapts to inference
+    // latency and scene motion (see KeyframeScheduler). 1 runs inference on every frame.
+    // Safe to call from another thread.
+    void setKeyframeInterval(int max_frames);
+
+    // Motion gate: frames whose luma barely differs from the last inferred frame skip inference
+    // and repeat the tracked boxes, but inference still runs at least every max_stale_ms.
+    // For mostly static scenes; safe to call from another thread.
+    void setMotionGate(bool enabled, int max_stale_ms = 1000);
+
+    // --- Pipelined detection ---
+    // submit*() preprocesses on the calling thread and returns without waiting for inference;
+    // results arrive on the pipeline's postprocess thread. Stale frames are dropped, not queued.
+    // Do not mix with detectRGBA() / detectYUV420() while the pipeline is running.
+    typedef std::function<void(const std::vector<DetectionResult>&, int64_t frame_id, int64_t timestamp_ns)> ResultCallback;
+    void startPipeline(const ResultCallback& callback);
+    void stopPipeline();
+    bool submitRGBA(const unsigned char* pixels, int width, int height, int stride, int64_t timestamp_ns,
+                    int rotation = 0);
+    bool submitYUV420(const YUV420Image& img, int64_t timestamp_ns, int rotation = 0);
+    // False without submitting anything when the JPEG cannot be decoded natively, as detectJPEG()
+    bool submitJPEG(const unsigned char* data, size_t size, int64_t timestamp_ns, int rotation = 0);
+
+    // Decode + NMS of a raw output blob, mapped back through tf. Public so tools can drive it
+    // with synthetic heads; not thread-safe against a running pipeline. The result is reused
+    // scratch, valid until the next call.
+    const std::vector<DetectionResult>& postprocess(const ncnn::Mat& output, const InputTransform& tf);
+
+    const StageTimings& lastTimings() const { return stage_timings; }
+    const ModelInfo& modelInfo() const { return model_info; }
+
+    // Blob + workspace pool counters; system_allocs stops growing once inference is warm
+    AllocStats allocatorStats() const;
+    // Safe to call from any thread
+    JpegStats jpegStats() const;
 
 private:
+    // Declared before net so they outlive every Mat the net hands out
+    BlobPool blob_pool;
+    BlobPool workspace_pool;
     ncnn::Net net;
     bool modelLoaded;
+    ModelInfo model_info;
+    int num_threads_override = 0;
+    int input_w_override = 0;
+    int input_h_override = 0;
+    StageTimings stage_timings;
     BYTETracker* tracker; // Added tracker
+    std::mutex tracker_mutex; // predictTo() may run on another thread than the frames
+    float output_scale_x = 1.0f; // upright frame pixels -> normalized, under tracker_mutex
+    float output_scale_y = 1.0f;
 
     // --- Reusable Buffers & Tracker Optimization ---
-    ncnn::Mat rgb_mat;
+    InputPreprocessor input_preprocessor;
     ncnn::Mat resized_input;
-    int frame_counter = 0;
-    const int TRACKER_FRAME_SKIP = 2; // Run tracker every N frames to save CPU
-    std::vector<Object> last_tracked_objects;
-    ncnn::Mat transposed_output;
+    InputTransform input_transform;
+    KeyframeScheduler keyframes;
+    MotionGate motion_gate;
+    std::vector<Object> tracker_objects;
+    std::vector<Object> tracked_objects;
+    HeadType head_type = HEAD_DENSE;
+    DenseHeadDecoder decoder;
+    std::vector<Candidate> candidates;
+    NmsEngine nms_engine;
+    NmsOptions nms_options;
+    std::vector<int> nms_keep;
+    std::vector<float> box_corners; // [x1, y1, x2, y2, ...] in upright source pixels
+    std::vector<float> box_scores;
+    std::vector<int> box_classes;
+    std::vector<DetectionResult> nms_results;
 
-    void preprocess(JNIEnv* env, jobject bitmap, AndroidBitmapInfo& info, void* pixels);
-    std::vector<DetectionResult> postprocess(const ncnn::Mat& output, int img_w, int img_h);
-};
+    // --- Class subset (sorted ids the decoder reads) ---
+    std::vector<int> active_classes;
+
+    // --- Settings from other threads, under config_mutex ---
+    mutable std::mutex config_mutex;
+    std::vector<int> pending_classes;
+    bool classes_dirty = false;
+    bool letterbox_enabled = true;
+    bool rect_input = false;
+
+    // --- Pipeline (stage 1 runs on the submitting thread with its own preprocessor) ---
+    std::mutex pipeline_mutex;
+    FramePipeline* pipeline = nullptr;
+    InputPreprocessor pipeline_preprocessor;
+    ResultCallback pipeline_callback;
 
-// JNI Functions
-JNIEXPORT jlong JNICALL Java_com_yolo11_YOLODetector_initDetector(JNIEnv* env, jobject thiz);
-JNIEXPORT jboolean JNICALL Java_com_yolo11_YOLODetector_loadModel(JNIEnv* env, jobject thiz, jlong nativePtr, jobject assetManager, jstring paramPath, jstring binPath);
-JNIEXPORT jobjectArray JNICALL Java_com_yolo11_YOLODetector_detectFromBitmap(JNIEnv* env, jobject thiz, jlong nativePtr, jobject bitmap);
-JNIEXPORT void JNICALL Java_com_yolo11_YOLODetector_releaseDetector(JNIEnv* env, jobject thiz, jlong nativePtr);
+    // --- JPEG input (one decoder per submitting side, like the preprocessors) ---
+    JpegDecoder jpeg_decoder;
+    JpegDecoder pipeline_jpeg_decoder;
+    mutable std::mutex jpeg_stats_mutex;
+    JpegStats jpeg_stats;
+
+    void loadModelInfo(const char* param_name, const ModelFileReader& read_file);
+    void probeHeadType();
+    void extract(const ncnn::Mat& input, ncnn::Mat& output);
+    void applyPendingConfig();
+    InputTransform makeInputTransform(int img_w, int img_h, int rotation) const;
+    std::vector<DetectionResult> track(const std::vector<DetectionResult>& raw_detections, const InputTransform& tf,
+                                       int64_t timestamp_ns);
+    std::vector<DetectionResult> extrapolate(int64_t timestamp_ns);
+    std::vector<DetectionResult> hold();
+    FrameMode planFrame(int64_t timestamp_ns, const unsigned char* pixels, int width, int height, int stride,
+                        bool rgba);
+    bool planJPEG(int64_t timestamp_ns, JpegDecoder& jpeg, const unsigned char* data, size_t size, int rotation,
+                  FrameMode& mode, YUV420Image& img, double& decode_ms);
+    static std::vector<DetectionResult> toResults(const std::vector<Object>& objects, float scale_x, float scale_y);
+    void releasePipeline();
+};
 
-#ifdef __cplusplus
-}
-#endif
\ No newline at end of file
+#endif // YOLO_DETECTOR_H
\ No newline at end of file
@@ -1,9 +1,201 @@
+// Thin JNI adapter: Bitmap / ImageProxy / AssetManager access on top of the platform-neutral YOLODetector
 #include "yolo_detector.h"
+#include "mjpeg_demuxer.h"
+#include <jni.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
+#include <android/bitmap.h>
+#include <pthread.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include "native_log.h"
+
+// --- Cached JNI handles ---
+// Resolved once in JNI_OnLoad (on the app class loader); native threads attached later
+// cannot FindClass app classes, and per-frame lookups are pure overhead.
+static JavaVM* g_vm = nullptr;
+static struct {
+    jclass resultClass = nullptr;           // global ref
+    jmethodID resultInit = nullptr;
+    jmethodID listenerOnDetections = nullptr;
+    jmethodID packedOnDetections = nullptr;
+} g_jni;
+
+// Looks up a class, clearing the exception if it is not on the class path
+static jclass findClass(JNIEnv* env, const char* name) {
+    jclass cls = env->FindClass(name);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        LOGE("JNI class %s not found", name);
+        return nullptr;
+    }
+    return cls;
+}
+
+static jmethodID findMethod(JNIEnv* env, jclass cls, const char* name, const char* signature) {
+    if (!cls) return nullptr;
+    jmethodID method = env->GetMethodID(cls, name, signature);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        LOGE("JNI method %s%s not found", name, signature);
+        return nullptr;
+    }
+    return method;
+}
+
+// Convert to Java objects
+static jobjectArray toJavaArray(JNIEnv* env, const std::vector<DetectionResult>& detections) {
+    if (!g_jni.resultClass || !g_jni.resultInit) return nullptr;
+    jobjectArray results = env->NewObjectArray(detections.size(), g_jni.resultClass, nullptr);
+
+    for (int i = 0; i < (int)detections.size(); i++) {
+        auto& det = detections[i];
+        jobject obj = env->NewObject(g_jni.resultClass, g_jni.resultInit,
+                                     det.classId, det.confidence,
+                                     det.x, det.y, det.width, det.height, det.trackId);
+        env->SetObjectArrayElement(results, i, obj);
+        env->DeleteLocalRef(obj);
+    }
+
+    return results;
+}
+
+// Packed result record in native byte order, mirrored by DetectionBuffer.kt:
+// int32 classId, float32 confidence, x, y, width, height, int32 trackId
+static const int PACKED_RECORD_BYTES = 28;
+
+// Writes as many records as fit into the buffer and returns the number of detections,
+// which is larger than what was written if the buffer is too small
+static jint writePacked(const std::vector<DetectionResult>& detections, void* address, jlong capacity) {
+    const size_t fit = std::min(detections.size(), (size_t)(capacity / PACKED_RECORD_BYTES));
+    unsigned char* out = static_cast<unsigned char*>(address);
+    for (size_t i = 0; i < fit; i++, out += PACKED_RECORD_BYTES) {
+        const DetectionResult& det = detections[i];
+        const float box[5] = { det.confidence, det.x, det.y, det.width, det.height };
+        memcpy(out, &det.classId, 4);
+        memcpy(out + 4, box, sizeof(box));
+        memcpy(out + 24, &det.trackId, 4);
+    }
+    return (jint)detections.size();
+}
+
+// Bytes a plane buffer must span: rows - 1 full strides plus the last row, which
+// Android does not pad to the row stride
+static jlong planeSpan(int rows, int cols, int rowStride, int pixelStride) {
+    return (jlong)(rows - 1) * rowStride + (jlong)(cols - 1) * pixelStride + 1;
+}
+
+// Resolves the three YUV_420_888 plane buffers of a frame. Strides come from Kotlin as
+// plain ints, so the only JNI calls are the direct buffer address/capacity lookups.
+// Both layouts CameraX produces are covered because U and V are addressed separately:
+// planar I420 (uvPixelStride 1) and interleaved NV21/NV12 (uvPixelStride 2, where the
+// U and V buffers are views into the same VU/UV plane offset by one byte).
+static bool wrapPlanes(JNIEnv* env, jobject yBuffer, jobject uBuffer, jobject vBuffer,
+                       jint yRowStride, jint uvRowStride, jint uvPixelStride, jint width, jint height,
+                       YUV420Image& img) {
+    if (!yBuffer || !uBuffer || !vBuffer || width < 2 || height < 2) return false;
+    if (yRowStride < width || (uvPixelStride != 1 && uvPixelStride != 2)) return false;
+    const int chromaW = (width + 1) / 2;
+    const int chromaH = (height + 1) / 2;
+    if (uvRowStride < (chromaW - 1) * uvPixelStride + 1) return false;
+
+    img.y = (const unsigned char*)env->GetDirectBufferAddress(yBuffer);
+    img.u = (const unsigned char*)env->GetDirectBufferAddress(uBuffer);
+    img.v = (const unsigned char*)env->GetDirectBufferAddress(vBuffer);
+    if (!img.y || !img.u || !img.v) return false;
+
+    const jlong chromaSpan = planeSpan(chromaH, chromaW, uvRowStride, uvPixelStride);
+    if (env->GetDirectBufferCapacity(yBuffer) < planeSpan(height, width, yRowStride, 1) ||
+        env->GetDirectBufferCapacity(uBuffer) < chromaSpan ||
+        env->GetDirectBufferCapacity(vBuffer) < chromaSpan) {
+        LOGE("YUV plane buffers smaller than %dx%d at the given strides", width, height);
+        return false;
+    }
+
+    img.width = width;
+    img.height = height;
+    img.y_row_stride = yRowStride;
+    img.uv_row_stride = uvRowStride;
+    img.uv_pixel_stride = uvPixelStride;
+    return true;
+}
+
+// [offset, offset + length) of a direct buffer, e.g. an MjpegStream frame view. Heap
+// buffers have no stable address and are refused.
+static const unsigned char* directBytes(JNIEnv* env, jobject buffer, jint offset, jint length) {
+    if (!buffer || offset < 0 || length <= 0) return nullptr;
+    const unsigned char* base = (const unsigned char*)env->GetDirectBufferAddress(buffer);
+    if (!base || env->GetDirectBufferCapacity(buffer) < (jlong)offset + length) return nullptr;
+    return base + offset;
+}
+
+static bool readAsset(AAssetManager* mgr, const std::string& path, std::string& out) {
+    AAsset* asset = AAssetManager_open(mgr, path.c_str(), AASSET_MODE_BUFFER);
+    if (!asset) return false;
+    const char* data = (const char*)AAsset_getBuffer(asset);
+    if (data) out.assign(data, AAsset_getLength(asset));
+    AAsset_close(asset);
+    return data != nullptr;
+}
+
+// --- Pipeline callbacks ---
+// Results are delivered on the pipeline's native postprocess thread, which is attached to the
+// VM on first use and detached by the pthread key destructor when the thread exits.
+static pthread_key_t g_detach_key;
+
+static void detachThread(void*) {
+    if (g_vm) g_vm->DetachCurrentThread();
+}
+
+static JNIEnv* attachedEnv() {
+    JNIEnv* env = nullptr;
+    if (g_vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) return env;
+    if (g_vm->AttachCurrentThread(&env, nullptr) != JNI_OK) return nullptr;
+    pthread_setspecific(g_detach_key, env);
+    return env;
+}
+
+// Java listener owned by the pipeline callback; released when the detector drops the callback.
+// Packed listeners also pin the caller's direct ByteBuffer the results are written into.
+struct PipelineListener {
+    jobject ref = nullptr;
+    jobject buffer = nullptr;
+    void* address = nullptr;
+    jlong capacity = 0;
+
+    ~PipelineListener() {
+        JNIEnv* env = attachedEnv();
+        if (env && ref) env->DeleteGlobalRef(ref);
+        if (env && buffer) env->DeleteGlobalRef(buffer);
+    }
+};
 
 extern "C" {
 
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) return JNI_ERR;
+    g_vm = vm;
+    pthread_key_create(&g_detach_key, detachThread);
+
+    jclass resultClass = findClass(env, "com/example/objectdetection/DetectionResult");
+    if (resultClass) {
+        g_jni.resultClass = (jclass)env->NewGlobalRef(resultClass);
+        g_jni.resultInit = findMethod(env, resultClass, "<init>", "(IFFFFFI)V");
+        env->DeleteLocalRef(resultClass);
+    }
+
+    jclass listener = findClass(env, "com/example/objectdetection/DetectionListener");
+    g_jni.listenerOnDetections = findMethod(env, listener, "onDetections",
+                                            "([Lcom/example/objectdetection/DetectionResult;JJ)V");
+    jclass packed = findClass(env, "com/example/objectdetection/PackedResultsCallback");
+    g_jni.packedOnDetections = findMethod(env, packed, "onPackedResults", "(IJJ)V");
+    if (listener) env->DeleteLocalRef(listener);
+    if (packed) env->DeleteLocalRef(packed);
+    return JNI_VERSION_1_6;
+}
+
 JNIEXPORT jlong JNICALL
 Java_com_example_objectdetection_YOLODetector_initDetector(JNIEnv* env, jobject thiz) {
     return reinterpret_cast<jlong>(new YOLODetector());
@@ -19,7 +211,19 @@ Java_com_example_objectdetection_YOLODetector_loadModel(JNIEnv* env, jobject thi
     const char* param = env->GetStringUTFChars(paramPath, nullptr);
     const char* bin = env->GetStringUTFChars(binPath, nullptr);
 
-    bool success = detector->loadModel(mgr, param, bin);
+    bool success = false;
+    AAsset* paramAsset = mgr ? AAssetManager_open(mgr, param, AASSET_MODE_BUFFER) : nullptr;
+    AAsset* binAsset = mgr ? AAssetManager_open(mgr, bin, AASSET_MODE_STREAMING) : nullptr;
+    if (paramAsset && binAsset) {
+        ncnn::DataReaderFromAndroidAsset paramReader(paramAsset);
+        ncnn::DataReaderFromAndroidAsset binReader(binAsset);
+        success = detector->loadModel(paramReader, binReader, param,
+                                      [mgr](const std::string& name, std::string& contents) {
+                                          return readAsset(mgr, name, contents);
+                                      });
+    }
+    if (paramAsset) AAsset_close(paramAsset);
+    if (binAsset) AAsset_close(binAsset);
 
     env->ReleaseStringUTFChars(paramPath, param);
     env->ReleaseStringUTFChars(binPath, bin);
@@ -28,51 +232,267 @@ Java_com_example_objectdetection_YOLODetector_loadModel(JNIEnv* env, jobject thi
 }
 
 JNIEXPORT jobjectArray JNICALL
-Java_com_example_objectdetection_YOLODetector_detectFromImageProxy(JNIEnv* env, jobject thiz, jlong nativePtr, jobject imageProxy) {
+Java_com_example_objectdetection_YOLODetector_detectFromPlanes(JNIEnv* env, jobject thiz, jlong nativePtr,
+                                                              jobject yBuffer, jobject uBuffer, jobject vBuffer,
+                                                              jint yRowStride, jint uvRowStride, jint uvPixelStride,
+                                                              jint width, jint height, jint rotationDegrees,
+                                                              jlong timestampNs) {
     auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
     if (!detector) return nullptr;
 
-    auto detections = detector->detectFromImageProxy(env, imageProxy);
+    YUV420Image img;
+    if (!wrapPlanes(env, yBuffer, uBuffer, vBuffer, yRowStride, uvRowStride, uvPixelStride, width, height, img)) {
+        return toJavaArray(env, std::vector<DetectionResult>());
+    }
+    auto detections = detector->detectYUV420(img, timestampNs, rotationDegrees);
 
-    // Convert to Java objects
-    jclass resultClass = env->FindClass("com/example/objectdetection/DetectionResult");
-    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "(IFFFFFI)V");
+    return toJavaArray(env, detections);
+}
 
-    jobjectArray results = env->NewObjectArray(detections.size(), resultClass, nullptr);
+// null when the JPEG cannot be decoded natively, so Kotlin can fall back to BitmapFactory
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_objectdetection_YOLODetector_detectFromJpeg(JNIEnv* env, jobject thiz, jlong nativePtr, jobject jpeg,
+                                                            jint offset, jint length, jint rotationDegrees,
+                                                            jlong timestampNs) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    const unsigned char* data = directBytes(env, jpeg, offset, length);
+    if (!detector || !data) return nullptr;
 
-    for (int i = 0; i < detections.size(); i++) {
-        auto& det = detections[i];
-        jobject obj = env->NewObject(resultClass, constructor,
-                                     det.classId, det.confidence,
-                                     det.x, det.y, det.width, det.height, det.trackId);
-        env->SetObjectArrayElement(results, i, obj);
+    std::vector<DetectionResult> detections;
+    if (!detector->detectJPEG(data, length, detections, timestampNs, rotationDegrees)) return nullptr;
+    return toJavaArray(env, detections);
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_objectdetection_YOLODetector_detectFromBitmap(JNIEnv* env, jobject thiz, jlong nativePtr, jobject bitmap,
+                                                              jlong timestampNs) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return nullptr;
+
+    AndroidBitmapInfo info;
+    void* pixels;
+    std::vector<DetectionResult> detections;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) >= 0 && AndroidBitmap_lockPixels(env, bitmap, &pixels) >= 0) {
+        detections = detector->detectRGBA((const unsigned char*)pixels, info.width, info.height, info.stride,
+                                          timestampNs);
+        AndroidBitmap_unlockPixels(env, bitmap);
     }
 
-    return results;
+    return toJavaArray(env, detections);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_objectdetection_YOLODetector_detectIntoBuffer(JNIEnv* env, jobject thiz, jlong nativePtr, jobject bitmap,
+                                                              jlong timestampNs, jobject out) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    void* address = out ? env->GetDirectBufferAddress(out) : nullptr;
+    if (!detector || !address) return 0;
+
+    AndroidBitmapInfo info;
+    void* pixels;
+    std::vector<DetectionResult> detections;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) >= 0 && AndroidBitmap_lockPixels(env, bitmap, &pixels) >= 0) {
+        detections = detector->detectRGBA((const unsigned char*)pixels, info.width, info.height, info.stride,
+                                          timestampNs);
+        AndroidBitmap_unlockPixels(env, bitmap);
+    }
+    return writePacked(detections, address, env->GetDirectBufferCapacity(out));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_example_objectdetection_YOLODetector_detectPlanesIntoBuffer(JNIEnv* env, jobject thiz, jlong nativePtr,
+                                                                    jobject yBuffer, jobject uBuffer, jobject vBuffer,
+                                                                    jint yRowStride, jint uvRowStride,
+                                                                    jint uvPixelStride, jint width, jint height,
+                                                                    jint rotationDegrees, jlong timestampNs,
+                                                                    jobject out) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    void* address = out ? env->GetDirectBufferAddress(out) : nullptr;
+    if (!detector || !address) return 0;
+
+    YUV420Image img;
+    if (!wrapPlanes(env, yBuffer, uBuffer, vBuffer, yRowStride, uvRowStride, uvPixelStride, width, height, img)) {
+        return 0;
+    }
+    return writePacked(detector->detectYUV420(img, timestampNs, rotationDegrees), address,
+                       env->GetDirectBufferCapacity(out));
+}
+
+// -1 when the JPEG cannot be decoded natively, as detectFromJpeg returns null
+JNIEXPORT jint JNICALL
+Java_com_example_objectdetection_YOLODetector_detectJpegIntoBuffer(JNIEnv* env, jobject thiz, jlong nativePtr,
+                                                                  jobject jpeg, jint offset, jint length,
+                                                                  jint rotationDegrees, jlong timestampNs,
+                                                                  jobject out) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    const unsigned char* data = directBytes(env, jpeg, offset, length);
+    void* address = out ? env->GetDirectBufferAddress(out) : nullptr;
+    if (!detector || !data || !address) return -1;
+
+    std::vector<DetectionResult> detections;
+    if (!detector->detectJPEG(data, length, detections, timestampNs, rotationDegrees)) return -1;
+    return writePacked(detections, address, env->GetDirectBufferCapacity(out));
 }
 
 JNIEXPORT jobjectArray JNICALL
-Java_com_example_objectdetection_YOLODetector_detectFromBitmap(JNIEnv* env, jobject thiz, jlong nativePtr, jobject bitmap) {
+Java_com_example_objectdetection_YOLODetector_predictTo(JNIEnv* env, jobject thiz, jlong nativePtr, jlong timestampNs) {
     auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
     if (!detector) return nullptr;
 
-    auto detections = detector->detect(env, bitmap);
+    return toJavaArray(env, detector->predictTo(timestampNs));
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_setLetterbox(JNIEnv* env, jobject thiz, jlong nativePtr, jboolean enabled, jboolean rect) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return;
 
-    // Convert to Java objects
-    jclass resultClass = env->FindClass("com/example/objectdetection/DetectionResult");
-    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "(IFFFFFI)V");
+    detector->setLetterbox(enabled == JNI_TRUE, rect == JNI_TRUE);
+}
 
-    jobjectArray results = env->NewObjectArray(detections.size(), resultClass, nullptr);
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_setClassFilter(JNIEnv* env, jobject thiz, jlong nativePtr, jintArray classIds) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return;
 
-    for (int i = 0; i < detections.size(); i++) {
-        auto& det = detections[i];
-        jobject obj = env->NewObject(resultClass, constructor,
-                                     det.classId, det.confidence,
-                                     det.x, det.y, det.width, det.height, det.trackId);
-        env->SetObjectArrayElement(results, i, obj);
+    std::vector<int> ids;
+    if (classIds) {
+        jsize count = env->GetArrayLength(classIds);
+        ids.resize(count);
+        if (count > 0) env->GetIntArrayRegion(classIds, 0, count, reinterpret_cast<jint*>(ids.data()));
     }
+    detector->setClassFilter(ids);
+}
 
-    return results;
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_setKeyframeInterval(JNIEnv* env, jobject thiz, jlong nativePtr, jint maxFrames) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return;
+
+    detector->setKeyframeInterval(maxFrames);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_setMotionGate(JNIEnv* env, jobject thiz, jlong nativePtr, jboolean enabled,
+                                                           jint maxStaleMs) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return;
+
+    detector->setMotionGate(enabled == JNI_TRUE, maxStaleMs);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_startPipeline(JNIEnv* env, jobject thiz, jlong nativePtr, jobject listener) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector || !listener || !g_jni.listenerOnDetections) return;
+
+    std::shared_ptr<PipelineListener> target(new PipelineListener());
+    target->ref = env->NewGlobalRef(listener);
+    detector->startPipeline([target](const std::vector<DetectionResult>& detections, int64_t frameId, int64_t timestampNs) {
+        JNIEnv* cbEnv = attachedEnv();
+        if (!cbEnv) return;
+        jobjectArray results = toJavaArray(cbEnv, detections);
+        cbEnv->CallVoidMethod(target->ref, g_jni.listenerOnDetections, results, (jlong)frameId, (jlong)timestampNs);
+        if (cbEnv->ExceptionCheck()) cbEnv->ExceptionClear();
+        cbEnv->DeleteLocalRef(results);
+    });
+}
+
+// Packed pipeline results: every frame is written into the same direct buffer and the
+// callback gets only the count, so no Java object is created per frame
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_startPipelinePacked(JNIEnv* env, jobject thiz, jlong nativePtr, jobject buffer,
+                                                                 jobject callback) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector || !buffer || !callback || !g_jni.packedOnDetections) return;
+    void* address = env->GetDirectBufferAddress(buffer);
+    if (!address) return;
+
+    std::shared_ptr<PipelineListener> target(new PipelineListener());
+    target->ref = env->NewGlobalRef(callback);
+    target->buffer = env->NewGlobalRef(buffer);
+    target->address = address;
+    target->capacity = env->GetDirectBufferCapacity(buffer);
+    detector->startPipeline([target](const std::vector<DetectionResult>& detections, int64_t frameId, int64_t timestampNs) {
+        JNIEnv* cbEnv = attachedEnv();
+        if (!cbEnv) return;
+        jint count = writePacked(detections, target->address, target->capacity);
+        cbEnv->CallVoidMethod(target->ref, g_jni.packedOnDetections, count, (jlong)frameId, (jlong)timestampNs);
+        if (cbEnv->ExceptionCheck()) cbEnv->ExceptionClear();
+    });
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_objectdetection_YOLODetector_submitBitmap(JNIEnv* env, jobject thiz, jlong nativePtr, jobject bitmap, jlong timestampNs) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return JNI_FALSE;
+
+    AndroidBitmapInfo info;
+    void* pixels;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) < 0) return JNI_FALSE;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) return JNI_FALSE;
+    bool submitted = detector->submitRGBA((const unsigned char*)pixels, info.width, info.height, info.stride, timestampNs);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return submitted ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_objectdetection_YOLODetector_submitPlanes(JNIEnv* env, jobject thiz, jlong nativePtr,
+                                                          jobject yBuffer, jobject uBuffer, jobject vBuffer,
+                                                          jint yRowStride, jint uvRowStride, jint uvPixelStride,
+                                                          jint width, jint height, jint rotationDegrees,
+                                                          jlong timestampNs) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return JNI_FALSE;
+
+    YUV420Image img;
+    if (!wrapPlanes(env, yBuffer, uBuffer, vBuffer, yRowStride, uvRowStride, uvPixelStride, width, height, img)) {
+        return JNI_FALSE;
+    }
+    return detector->submitYUV420(img, timestampNs, rotationDegrees) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_objectdetection_YOLODetector_submitJpeg(JNIEnv* env, jobject thiz, jlong nativePtr, jobject jpeg,
+                                                        jint offset, jint length, jint rotationDegrees,
+                                                        jlong timestampNs) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    const unsigned char* data = directBytes(env, jpeg, offset, length);
+    if (!detector || !data) return JNI_FALSE;
+
+    return detector->submitJPEG(data, length, timestampNs, rotationDegrees) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_YOLODetector_stopPipeline(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return;
+
+    detector->stopPipeline();
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_example_objectdetection_YOLODetector_getAllocatorStats(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return nullptr;
+
+    AllocStats stats = detector->allocatorStats();
+    jlong values[4] = { stats.requests, stats.system_allocs, stats.system_frees, stats.bytes_held };
+    jlongArray result = env->NewLongArray(4);
+    env->SetLongArrayRegion(result, 0, 4, values);
+    return result;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_example_objectdetection_YOLODetector_getJpegStats(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* detector = reinterpret_cast<YOLODetector*>(nativePtr);
+    if (!detector) return nullptr;
+
+    JpegStats stats = detector->jpegStats();
+    jlong values[6] = { stats.frames, stats.failures, stats.skipped, stats.last_us, stats.total_us, stats.last_scale };
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
 }
 
 JNIEXPORT void JNICALL
@@ -80,4 +500,41 @@ Java_com_example_objectdetection_YOLODetector_releaseDetector(JNIEnv* env, jobje
     delete reinterpret_cast<YOLODetector*>(nativePtr);
 }
 
+JNIEXPORT jlong JNICALL
+Java_com_example_objectdetection_MjpegStream_openStream(JNIEnv* env, jobject thiz, jstring host, jint port, jstring path,
+                                                        jint timeoutMs) {
+    const char* host_chars = env->GetStringUTFChars(host, nullptr);
+    const char* path_chars = env->GetStringUTFChars(path, nullptr);
+    int fd = MjpegDemuxer::connect(host_chars, port, path_chars, timeoutMs);
+    env->ReleaseStringUTFChars(host, host_chars);
+    env->ReleaseStringUTFChars(path, path_chars);
+    if (fd < 0) return 0;
+
+    return reinterpret_cast<jlong>(new MjpegDemuxer(fd));
+}
+
+// Direct buffer over the demuxer's window: valid until the next nextFrame() or releaseStream()
+JNIEXPORT jobject JNICALL
+Java_com_example_objectdetection_MjpegStream_nextFrame(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* demuxer = reinterpret_cast<MjpegDemuxer*>(nativePtr);
+    if (!demuxer) return nullptr;
+
+    MjpegFrame frame;
+    if (!demuxer->next(frame)) return nullptr;
+    return env->NewDirectByteBuffer(const_cast<unsigned char*>(frame.data), (jlong)frame.size);
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_MjpegStream_cancelStream(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    auto* demuxer = reinterpret_cast<MjpegDemuxer*>(nativePtr);
+    if (!demuxer) return;
+
+    demuxer->cancel();
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_objectdetection_MjpegStream_releaseStream(JNIEnv* env, jobject thiz, jlong nativePtr) {
+    delete reinterpret_cast<MjpegDemuxer*>(nativePtr);
+}
+
 }
\ No newline at end of file
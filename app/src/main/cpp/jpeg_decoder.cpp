@@ -0,0 +1,695 @@
+#include "jpeg_decoder.h"
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+const int FAST_BITS = 9;
+
+// Zig-zag scan position -> natural (row-major) coefficient index
+const unsigned char NATURAL_ORDER[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// JPEG Annex K.3 tables: code counts per length 1..16, then the symbols
+const unsigned char STD_DC_LUMA_COUNTS[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+const unsigned char STD_DC_CHROMA_COUNTS[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+const unsigned char STD_DC_SYMBOLS[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+const unsigned char STD_AC_LUMA_COUNTS[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+const unsigned char STD_AC_LUMA_SYMBOLS[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+const unsigned char STD_AC_CHROMA_COUNTS[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+const unsigned char STD_AC_CHROMA_SYMBOLS[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+// Chroma of greyscale frames: every chroma offset is 0, so one sample covers the frame
+const unsigned char NEUTRAL_CHROMA = 128;
+
+// Larger than any camera frame this decodes; bounds the planes a corrupt SOF can ask for
+const int MAX_DIMENSION = 8192;
+
+inline int read_u16(const unsigned char* p) {
+    return (p[0] << 8) | p[1];
+}
+
+inline unsigned char clamp_u8(int v) {
+    return (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// -------------------------------------------------------------------------
+// Entropy-coded segment reader
+// -------------------------------------------------------------------------
+
+// MSB-first bit buffer over the scan data. Stuffed 0xFF00 pairs are unstuffed on the fly;
+// at a marker or the end of the data the reader stops advancing and feeds one bits, the
+// encoder's own byte padding. No Huffman code is all ones, so a block that reaches into the
+// padding fails to decode instead of turning zeros into short codes (zero runs are EOB in
+// the chroma AC table). The padding bytes are counted so that overrun() also catches a
+// segment that ran out of data without an invalid code.
+struct BitReader {
+    const unsigned char* p;
+    const unsigned char* end;
+    uint64_t acc;
+    int bits;
+    int padding; // padding bytes fed since the last reset
+
+    void reset(const unsigned char* begin, const unsigned char* stop) {
+        p = begin;
+        end = stop;
+        acc = 0;
+        bits = 0;
+        padding = 0;
+    }
+
+    // Leaves at least 57 bits in acc
+    void refill() {
+        while (bits <= 56) {
+            unsigned int b = 0xFF;
+            if (p < end && (p[0] != 0xFF || (p + 1 < end && p[1] == 0x00))) {
+                b = *p;
+                p += b == 0xFF ? 2 : 1;
+            } else {
+                padding++; // end of data or a marker: stay on it
+            }
+            acc |= (uint64_t)b << (56 - bits);
+            bits += 8;
+        }
+    }
+
+    // More than the last byte of the segment was made up: the data is truncated or corrupt
+    bool overrun() const { return padding * 8 - bits > 8; }
+
+    // Callers refill so that a whole symbol plus its extra bits (at most 32) is buffered
+    bool low() const { return bits < 32; }
+
+    // Next Huffman symbol, -1 for a code the table does not have
+    template<class H>
+    int decode(const H& table) {
+        const int e = table.fast[acc >> (64 - FAST_BITS)];
+        if (e) {
+            acc <<= e >> 8;
+            bits -= e >> 8;
+            return e & 0xFF;
+        }
+        for (int len = FAST_BITS + 1; len <= 16; len++) {
+            const int32_t code = (int32_t)(acc >> (64 - len));
+            if (code <= table.max_code[len]) {
+                acc <<= len;
+                bits -= len;
+                return table.values[code + table.value_offset[len]];
+            }
+        }
+        return -1;
+    }
+
+    void skip(int n) {
+        acc <<= n;
+        bits -= n;
+    }
+
+    int peek(int n) const {
+        return (int)(acc >> (64 - n));
+    }
+
+    // n in [1, 16]
+    int receive(int n) {
+        int v = (int)(acc >> (64 - n));
+        acc <<= n;
+        bits -= n;
+        return v;
+    }
+
+    // Skips to just after the next RSTn marker and drops the buffered bits
+    bool restart() {
+        acc = 0;
+        bits = 0;
+        padding = 0;
+        while (p + 1 < end) {
+            if (p[0] == 0xFF && p[1] >= 0xD0 && p[1] <= 0xD7) {
+                p += 2;
+                return true;
+            }
+            p++;
+        }
+        return false;
+    }
+};
+
+// Sign extension of an n-bit magnitude category value (F.2.2.1)
+inline int extend(int v, int n) {
+    return v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+}
+
+// -------------------------------------------------------------------------
+// Inverse DCT, full and reduced size
+// -------------------------------------------------------------------------
+
+// Fixed-point 8x8 IDCT (the Loeffler-Ligtenberg-Moschytz factorisation used by the IJG
+// "islow" method): columns to a workspace with PASS1_BITS of extra precision, then rows
+const int CONST_BITS = 13;
+const int PASS1_BITS = 2;
+
+#define FIX(x) ((int32_t)((x) * (1 << CONST_BITS) + 0.5))
+#define DESCALE(x, n) (((x) + (1 << ((n) - 1))) >> (n))
+
+const int32_t FIX_0_298631336 = FIX(0.298631336);
+const int32_t FIX_0_390180644 = FIX(0.390180644);
+const int32_t FIX_0_541196100 = FIX(0.541196100);
+const int32_t FIX_0_765366865 = FIX(0.765366865);
+const int32_t FIX_0_899976223 = FIX(0.899976223);
+const int32_t FIX_1_175875602 = FIX(1.175875602);
+const int32_t FIX_1_501321110 = FIX(1.501321110);
+const int32_t FIX_1_847759065 = FIX(1.847759065);
+const int32_t FIX_1_961570560 = FIX(1.961570560);
+const int32_t FIX_2_053119869 = FIX(2.053119869);
+const int32_t FIX_2_562915447 = FIX(2.562915447);
+const int32_t FIX_3_072711026 = FIX(3.072711026);
+
+// One 8-point IDCT over in[0], in[step], ..., writing out[0], out[ostep], ... descaled by shift
+template<class T>
+inline void idct8_1d(const int32_t* in, int step, T* out, int ostep, int shift, int bias) {
+    // Even part
+    int32_t z2 = in[2 * step];
+    int32_t z3 = in[6 * step];
+    int32_t z1 = (z2 + z3) * FIX_0_541196100;
+    int32_t tmp2 = z1 - z3 * FIX_1_847759065;
+    int32_t tmp3 = z1 + z2 * FIX_0_765366865;
+
+    z2 = in[0];
+    z3 = in[4 * step];
+    int32_t tmp0 = (z2 + z3) * (1 << CONST_BITS);
+    int32_t tmp1 = (z2 - z3) * (1 << CONST_BITS);
+
+    const int32_t tmp10 = tmp0 + tmp3;
+    const int32_t tmp13 = tmp0 - tmp3;
+    const int32_t tmp11 = tmp1 + tmp2;
+    const int32_t tmp12 = tmp1 - tmp2;
+
+    // Odd part
+    tmp0 = in[7 * step];
+    tmp1 = in[5 * step];
+    tmp2 = in[3 * step];
+    tmp3 = in[1 * step];
+
+    z1 = tmp0 + tmp3;
+    z2 = tmp1 + tmp2;
+    z3 = tmp0 + tmp2;
+    int32_t z4 = tmp1 + tmp3;
+    const int32_t z5 = (z3 + z4) * FIX_1_175875602;
+
+    tmp0 *= FIX_0_298631336;
+    tmp1 *= FIX_2_053119869;
+    tmp2 *= FIX_3_072711026;
+    tmp3 *= FIX_1_501321110;
+    z1 *= -FIX_0_899976223;
+    z2 *= -FIX_2_562915447;
+    z3 = z3 * -FIX_1_961570560 + z5;
+    z4 = z4 * -FIX_0_390180644 + z5;
+
+    tmp0 += z1 + z3;
+    tmp1 += z2 + z4;
+    tmp2 += z2 + z3;
+    tmp3 += z1 + z4;
+
+    out[0 * ostep] = (T)(DESCALE(tmp10 + tmp3, shift) + bias);
+    out[7 * ostep] = (T)(DESCALE(tmp10 - tmp3, shift) + bias);
+    out[1 * ostep] = (T)(DESCALE(tmp11 + tmp2, shift) + bias);
+    out[6 * ostep] = (T)(DESCALE(tmp11 - tmp2, shift) + bias);
+    out[2 * ostep] = (T)(DESCALE(tmp12 + tmp1, shift) + bias);
+    out[5 * ostep] = (T)(DESCALE(tmp12 - tmp1, shift) + bias);
+    out[3 * ostep] = (T)(DESCALE(tmp13 + tmp0, shift) + bias);
+    out[4 * ostep] = (T)(DESCALE(tmp13 - tmp0, shift) + bias);
+}
+
+void idct_8x8(const int32_t* coef, unsigned char* out, int pitch) {
+    int32_t ws[64];
+    for (int c = 0; c < 8; c++) {
+        const int32_t* in = coef + c;
+        // Most columns of camera frames carry only the DC term
+        if ((in[8] | in[16] | in[24] | in[32] | in[40] | in[48] | in[56]) == 0) {
+            const int32_t dc = in[0] * (1 << PASS1_BITS);
+            for (int r = 0; r < 8; r++) ws[r * 8 + c] = dc;
+            continue;
+        }
+        idct8_1d(in, 8, ws + c, 8, CONST_BITS - PASS1_BITS, 0);
+    }
+
+    int32_t row[8];
+    for (int r = 0; r < 8; r++) {
+        const int32_t* in = ws + r * 8;
+        unsigned char* dst = out + r * pitch;
+        if ((in[1] | in[2] | in[3] | in[4] | in[5] | in[6] | in[7]) == 0) {
+            const unsigned char dc = clamp_u8(DESCALE(in[0], PASS1_BITS + 3) + 128);
+            memset(dst, dc, 8);
+            continue;
+        }
+        idct8_1d(in, 1, row, 1, CONST_BITS + PASS1_BITS + 3, 128);
+        for (int x = 0; x < 8; x++) dst[x] = clamp_u8(row[x]);
+    }
+}
+
+// Reduced transforms: the block at 1/(8/N) size as the exact area average of its full 8x8
+// decode (what the IJG reduced-size IDCTs compute). Averaging s = 8/N neighbours of the
+// 8-point basis gives one N-point output basis per frequency,
+//   k[x][u] = 1/s sum_{X = xs}^{xs+s-1} C(u)/2 cos((2X+1)u pi / 16),
+// so one separable N x 8 pass per axis replaces the full transform plus a box filter.
+// Frequencies above N fold back onto lower ones instead of being dropped, which keeps edges
+// free of the ringing a truncated spectrum would add.
+
+// The basis is symmetric, k[N-1-x][u] = (-1)^u k[x][u], and k[x][4] = 0 (plus every even
+// u > 0 for N = 2), so each 1D pass is an even and an odd sum per output pair:
+//   N = 4: x0/x3 = c0 f0 + e f +- o0 f,  x1/x2 = c0 f0 - e f +- o1 f
+//   N = 2: x0/x1 = c0 f0 +- o f
+const int32_t BOX_C0 = FIX(0.353553391);
+const int32_t BOX4_E2 = FIX(0.326640741);
+const int32_t BOX4_E6 = FIX(0.135299025);
+const int32_t BOX4_O0[4] = { FIX(0.453063723), FIX(0.159094823), -FIX(0.106303762), -FIX(0.090119978) };
+const int32_t BOX4_O1[4] = { FIX(0.187665139), -FIX(0.384088878), FIX(0.256639984), -FIX(0.037328917) };
+const int32_t BOX2_O[4] = { FIX(0.320364431), -FIX(0.112497028), FIX(0.075168111), -FIX(0.063724447) };
+
+// 4 outputs from the 8 coefficients f[0], f[step], ... (f[4 * step] has no weight)
+inline void box4_1d(const int32_t* f, int step, int32_t* out) {
+    const int32_t c = f[0] * BOX_C0;
+    const int32_t e = f[2 * step] * BOX4_E2 - f[6 * step] * BOX4_E6;
+    const int32_t f1 = f[step], f3 = f[3 * step], f5 = f[5 * step], f7 = f[7 * step];
+    const int32_t o0 = f1 * BOX4_O0[0] + f3 * BOX4_O0[1] + f5 * BOX4_O0[2] + f7 * BOX4_O0[3];
+    const int32_t o1 = f1 * BOX4_O1[0] + f3 * BOX4_O1[1] + f5 * BOX4_O1[2] + f7 * BOX4_O1[3];
+    out[0] = c + e + o0;
+    out[3] = c + e - o0;
+    out[1] = c - e + o1;
+    out[2] = c - e - o1;
+}
+
+void idct_4x4(const int32_t* coef, unsigned char* out, int pitch) {
+    // Columns to a 4 x 8 workspace (column 4 is never read back)
+    int32_t ws[32];
+    int32_t col[4];
+    for (int u = 0; u < 8; u++) {
+        if (u == 4) continue;
+        const int32_t* in = coef + u;
+        if ((in[8] | in[16] | in[24] | in[40] | in[48] | in[56]) == 0) {
+            const int32_t dc = DESCALE(in[0] * BOX_C0, CONST_BITS - PASS1_BITS);
+            for (int y = 0; y < 4; y++) ws[y * 8 + u] = dc;
+            continue;
+        }
+        box4_1d(in, 8, col);
+        for (int y = 0; y < 4; y++) ws[y * 8 + u] = DESCALE(col[y], CONST_BITS - PASS1_BITS);
+    }
+    int32_t row[4];
+    for (int y = 0; y < 4; y++) {
+        box4_1d(ws + y * 8, 1, row);
+        unsigned char* dst = out + y * pitch;
+        for (int x = 0; x < 4; x++) dst[x] = clamp_u8(DESCALE(row[x], CONST_BITS + PASS1_BITS) + 128);
+    }
+}
+
+// 2 outputs from the DC and odd coefficients of f[0], f[step], ...
+inline void box2_1d(const int32_t* f, int step, int32_t* out) {
+    const int32_t c = f[0] * BOX_C0;
+    const int32_t o = f[step] * BOX2_O[0] + f[3 * step] * BOX2_O[1] + f[5 * step] * BOX2_O[2] +
+                      f[7 * step] * BOX2_O[3];
+    out[0] = c + o;
+    out[1] = c - o;
+}
+
+void idct_2x2(const int32_t* coef, unsigned char* out, int pitch) {
+    // Only columns 0, 1, 3, 5 and 7 carry weight in the row pass
+    int32_t ws[16];
+    int32_t col[2];
+    for (int u = 0; u < 8; u += (u == 0 ? 1 : 2)) {
+        box2_1d(coef + u, 8, col);
+        ws[u] = DESCALE(col[0], CONST_BITS - PASS1_BITS);
+        ws[8 + u] = DESCALE(col[1], CONST_BITS - PASS1_BITS);
+    }
+    int32_t row[2];
+    for (int y = 0; y < 2; y++) {
+        box2_1d(ws + y * 8, 1, row);
+        out[y * pitch] = clamp_u8(DESCALE(row[0], CONST_BITS + PASS1_BITS) + 128);
+        out[y * pitch + 1] = clamp_u8(DESCALE(row[1], CONST_BITS + PASS1_BITS) + 128);
+    }
+}
+
+void idct_1x1(const int32_t* coef, unsigned char* out, int /*pitch*/) {
+    out[0] = clamp_u8(DESCALE(coef[0], 3) + 128);
+}
+
+typedef void (*IdctFn)(const int32_t*, unsigned char*, int);
+
+} // namespace
+
+namespace {
+
+// One 8x8 block: DC difference + run-length coded AC terms, dequantized into natural order.
+// block must be all zero on entry; returns the last zig-zag position written (the caller
+// clears up to it again after the IDCT), or -1 on a corrupt code.
+template<class H>
+int decode_block(BitReader& br, const H& dc, const H& ac, const uint16_t* q, int& pred, int32_t* block) {
+    if (br.low()) br.refill();
+    int s = br.decode(dc);
+    if (s < 0 || s > 11) return -1;
+    if (s) pred += extend(br.receive(s), s);
+    block[0] = pred * q[0];
+
+    int k = 1;
+    int last = 0;
+    while (k < 64) {
+        if (br.low()) br.refill();
+        // Short code + short magnitude: run, value and bit count from one lookup
+        const int32_t f = ac.fast_ac[br.peek(FAST_BITS)];
+        if (f) {
+            br.skip(f & 15);
+            k += (f >> 4) & 15;
+            if (k > 63) return -1;
+            const int n = NATURAL_ORDER[k];
+            block[n] = (f >> 8) * q[n];
+            last = k++;
+            continue;
+        }
+        const int rs = br.decode(ac);
+        if (rs < 0) return -1;
+        const int r = rs >> 4;
+        s = rs & 15;
+        if (s == 0) {
+            if (r != 15) break; // end of block
+            k += 16;            // run of 16 zeros
+            continue;
+        }
+        k += r;
+        if (k > 63) return -1;
+        const int n = NATURAL_ORDER[k];
+        block[n] = extend(br.receive(s), s) * q[n];
+        last = k++;
+    }
+    return last;
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------
+// JpegDecoder
+// -------------------------------------------------------------------------
+
+JpegDecoder::JpegDecoder() {
+    buildHuffman(STD_DC_LUMA_COUNTS, STD_DC_SYMBOLS, std_tables[0][0]);
+    buildHuffman(STD_DC_CHROMA_COUNTS, STD_DC_SYMBOLS, std_tables[0][1]);
+    buildHuffman(STD_AC_LUMA_COUNTS, STD_AC_LUMA_SYMBOLS, std_tables[1][0]);
+    buildHuffman(STD_AC_CHROMA_COUNTS, STD_AC_CHROMA_SYMBOLS, std_tables[1][1]);
+    memset(quant, 0, sizeof(quant));
+    memset(quant_defined, 0, sizeof(quant_defined));
+    memset(selected, 0, sizeof(selected));
+}
+
+bool JpegDecoder::buildHuffman(const unsigned char* counts, const unsigned char* symbols, HuffTable& table) {
+    memset(table.fast, 0, sizeof(table.fast));
+    memset(table.fast_ac, 0, sizeof(table.fast_ac));
+    int code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++) {
+        const int n = counts[len - 1];
+        table.value_offset[len] = k - code;
+        table.max_code[len] = n ? code + n - 1 : -1;
+        for (int i = 0; i < n; i++, k++, code++) {
+            table.values[k] = symbols[k];
+            if (len <= FAST_BITS) {
+                const int shift = FAST_BITS - len;
+                const uint16_t entry = (uint16_t)((len << 8) | symbols[k]);
+                for (int j = 0; j < (1 << shift); j++) table.fast[(code << shift) + j] = entry;
+            }
+        }
+        if (code > (1 << len)) return false; // more codes than the length allows
+        code <<= 1;
+    }
+
+    // AC symbols whose magnitude bits also fit in the lookahead
+    for (int i = 0; i < (1 << FAST_BITS); i++) {
+        const int e = table.fast[i];
+        if (!e) continue;
+        const int len = e >> 8;
+        const int run = (e >> 4) & 15;
+        const int size = e & 15;
+        if (size == 0 || len + size > FAST_BITS) continue;
+        const int bits = (i >> (FAST_BITS - len - size)) & ((1 << size) - 1);
+        table.fast_ac[i] = extend(bits, size) * 256 + run * 16 + len + size;
+    }
+    return true;
+}
+
+bool JpegDecoder::readHeader(const unsigned char* data, size_t size) {
+    scan_begin = nullptr;
+    num_comps = 0;
+    frame_w = 0;
+    frame_h = 0;
+    restart_interval = 0;
+    memset(quant_defined, 0, sizeof(quant_defined));
+    // Tables 0 and 1 default to Annex K luma / chroma until a DHT replaces them
+    for (int tc = 0; tc < 2; tc++) {
+        selected[tc][0] = &std_tables[tc][0];
+        selected[tc][1] = &std_tables[tc][1];
+        selected[tc][2] = nullptr;
+        selected[tc][3] = nullptr;
+    }
+
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+    const unsigned char* p = data + 2;
+    const unsigned char* end = data + size;
+    while (p < end) {
+        if (*p != 0xFF) {
+            p++; // stray bytes between segments
+            continue;
+        }
+        while (p < end && *p == 0xFF) p++; // fill bytes
+        if (p >= end) break;
+        const int marker = *p++;
+        if (marker == 0x01 || marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7)) continue; // no payload
+        if (marker == 0xD9 || end - p < 2) return false;
+
+        const int len = read_u16(p);
+        if (len < 2 || len > end - p) return false;
+        const unsigned char* seg = p + 2;
+        const size_t n = len - 2;
+        p += len;
+
+        switch (marker) {
+        case 0xC0: // baseline
+        case 0xC1: // extended sequential, Huffman
+            if (!readFrame(seg, n)) return false;
+            break;
+        case 0xC4:
+            if (!readHuffman(seg, n)) return false;
+            break;
+        case 0xDB:
+            if (!readQuant(seg, n)) return false;
+            break;
+        case 0xDD:
+            if (n < 2) return false;
+            restart_interval = read_u16(seg);
+            break;
+        case 0xDA:
+            if (!readScan(seg, n)) return false;
+            scan_begin = p;
+            data_end = end;
+            return true;
+        default:
+            // Progressive, lossless, hierarchical and arithmetic-coded frames
+            if (marker >= 0xC2 && marker <= 0xCF) return false;
+            break; // APPn, COM
+        }
+    }
+    return false;
+}
+
+bool JpegDecoder::readFrame(const unsigned char* p, size_t n) {
+    if (n < 6 || p[0] != 8) return false;
+    frame_h = read_u16(p + 1);
+    frame_w = read_u16(p + 3);
+    num_comps = p[5];
+    if (frame_w == 0 || frame_h == 0 || frame_w > MAX_DIMENSION || frame_h > MAX_DIMENSION ||
+        (num_comps != 1 && num_comps != 3) || n < 6 + 3 * (size_t)num_comps) {
+        num_comps = 0;
+        return false;
+    }
+
+    max_h = 1;
+    max_v = 1;
+    for (int i = 0; i < num_comps; i++) {
+        Component& c = comps[i];
+        const unsigned char* cp = p + 6 + 3 * i;
+        c.id = cp[0];
+        c.h = cp[1] >> 4;
+        c.v = cp[1] & 15;
+        c.tq = cp[2];
+        if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4 || c.tq > 3) return false;
+        max_h = std::max(max_h, c.h);
+        max_v = std::max(max_v, c.v);
+    }
+
+    if (num_comps == 1) {
+        // A single-component scan is never interleaved: one block per MCU whatever the factors
+        comps[0].h = comps[0].v = max_h = max_v = 1;
+        return true;
+    }
+    // Luma at full resolution, both chroma planes at the same half or full resolution per axis,
+    // which is what the YUV sampler can address
+    const Component& y = comps[0];
+    const Component& cb = comps[1];
+    const Component& cr = comps[2];
+    if (y.h != max_h || y.v != max_v || cb.h != cr.h || cb.v != cr.v) return false;
+    if ((max_h != cb.h && max_h != 2 * cb.h) || (max_v != cb.v && max_v != 2 * cb.v)) return false;
+    return true;
+}
+
+bool JpegDecoder::readHuffman(const unsigned char* p, size_t n) {
+    while (n > 0) {
+        if (n < 17) return false;
+        const int tc = p[0] >> 4;
+        const int th = p[0] & 15;
+        if (tc > 1 || th > 3) return false;
+        size_t total = 0;
+        for (int i = 1; i <= 16; i++) total += p[i];
+        if (total > 256 || n < 17 + total) return false;
+        if (!buildHuffman(p + 1, p + 17, tables[tc][th])) return false;
+        selected[tc][th] = &tables[tc][th];
+        p += 17 + total;
+        n -= 17 + total;
+    }
+    return true;
+}
+
+bool JpegDecoder::readQuant(const unsigned char* p, size_t n) {
+    while (n > 0) {
+        const int pq = p[0] >> 4;
+        const int tq = p[0] & 15;
+        const size_t bytes = pq ? 128 : 64;
+        if (pq > 1 || tq > 3 || n < 1 + bytes) return false;
+        for (int k = 0; k < 64; k++) {
+            quant[tq][NATURAL_ORDER[k]] = (uint16_t)(pq ? read_u16(p + 1 + 2 * k) : p[1 + k]);
+        }
+        quant_defined[tq] = true;
+        p += 1 + bytes;
+        n -= 1 + bytes;
+    }
+    return true;
+}
+
+bool JpegDecoder::readScan(const unsigned char* p, size_t n) {
+    if (num_comps == 0 || n < 1) return false;
+    const int ns = p[0];
+    // Only single-scan frames: every component in the first scan
+    if (ns != num_comps || n < 4 + 2 * (size_t)ns) return false;
+    for (int i = 0; i < ns; i++) {
+        const int id = p[1 + 2 * i];
+        const int td = p[2 + 2 * i] >> 4;
+        const int ta = p[2 + 2 * i] & 15;
+        int ci = 0;
+        while (ci < num_comps && comps[ci].id != id) ci++;
+        if (ci == num_comps || td > 3 || ta > 3) return false;
+        Component& c = comps[ci];
+        c.dc = selected[0][td];
+        c.ac = selected[1][ta];
+        if (!c.dc || !c.ac || !quant_defined[c.tq]) return false;
+        scan_comps[i] = ci;
+    }
+    const unsigned char* sp = p + 1 + 2 * ns;
+    return sp[0] == 0 && sp[1] == 63 && sp[2] == 0; // full spectral range, no successive approximation
+}
+
+int JpegDecoder::scaleFor(int min_w, int min_h) const {
+    for (int scale = 8; scale > 1; scale /= 2) {
+        if ((frame_w + scale - 1) / scale >= min_w && (frame_h + scale - 1) / scale >= min_h) return scale;
+    }
+    return 1;
+}
+
+bool JpegDecoder::decode(int scale, YUV420Image& out) {
+    if (!scan_begin || (scale != 1 && scale != 2 && scale != 4 && scale != 8)) return false;
+    const int bs = 8 / scale; // output pixels per block side
+    const IdctFn idct = bs == 8 ? idct_8x8 : (bs == 4 ? idct_4x4 : (bs == 2 ? idct_2x2 : idct_1x1));
+
+    const int mcus_x = (frame_w + 8 * max_h - 1) / (8 * max_h);
+    const int mcus_y = (frame_h + 8 * max_v - 1) / (8 * max_v);
+    for (int i = 0; i < num_comps; i++) {
+        Component& c = comps[i];
+        c.pitch = mcus_x * c.h * bs;
+        c.plane.resize((size_t)c.pitch * mcus_y * c.v * bs);
+        c.dc_pred = 0;
+    }
+
+    BitReader br;
+    br.reset(scan_begin, data_end);
+    int32_t block[64];
+    memset(block, 0, sizeof(block));
+    int until_restart = restart_interval;
+    for (int my = 0; my < mcus_y; my++) {
+        for (int mx = 0; mx < mcus_x; mx++) {
+            if (restart_interval) {
+                if (until_restart == 0) {
+                    if (br.overrun() || !br.restart()) return false;
+                    for (int i = 0; i < num_comps; i++) comps[i].dc_pred = 0;
+                    until_restart = restart_interval;
+                }
+                until_restart--;
+            }
+            for (int i = 0; i < num_comps; i++) {
+                Component& c = comps[scan_comps[i]];
+                const uint16_t* q = quant[c.tq];
+                for (int by = 0; by < c.v; by++) {
+                    unsigned char* row = &c.plane[(size_t)((my * c.v + by) * bs) * c.pitch];
+                    for (int bx = 0; bx < c.h; bx++) {
+                        const int last = decode_block(br, *c.dc, *c.ac, q, c.dc_pred, block);
+                        if (last < 0) return false;
+                        idct(block, row + (mx * c.h + bx) * bs, c.pitch);
+                        for (int k = 0; k <= last; k++) block[NATURAL_ORDER[k]] = 0;
+                    }
+                }
+            }
+        }
+        if (br.overrun()) return false; // checked per MCU row so a cut-off frame fails early
+    }
+
+    out.width = (frame_w + scale - 1) / scale;
+    out.height = (frame_h + scale - 1) / scale;
+    out.y = &comps[0].plane[0];
+    out.y_row_stride = comps[0].pitch;
+    if (num_comps == 3) {
+        // The sampler reads chroma at half luma resolution: full-resolution chroma axes are
+        // stepped over two samples at a time
+        const Component& cb = comps[1];
+        out.u = &cb.plane[0];
+        out.v = &comps[2].plane[0];
+        out.uv_pixel_stride = cb.h == max_h ? 2 : 1;
+        out.uv_row_stride = (cb.v == max_v ? 2 : 1) * cb.pitch;
+    } else {
+        out.u = &NEUTRAL_CHROMA;
+        out.v = &NEUTRAL_CHROMA;
+        out.uv_pixel_stride = 0;
+        out.uv_row_stride = 0;
+    }
+    return true;
+}
@@ -0,0 +1,187 @@
+#include "kalman_filter.h"
+#include "simd_lanes.h"
+
+namespace {
+
+const int NDIM = 4; // measured coordinates; each one owns a 2x2 block
+
+// R x C matrix of lane vectors: lane l of every element belongs to coordinate k + l, so one
+// LaneMatrix<SimdLanes, 2, 2> is the 2x2 block of four coordinates at once. Dimensions are
+// template constants, so the loops below unroll completely.
+template<class L, int R, int C>
+struct LaneMatrix {
+    typename L::V m[R][C];
+};
+
+template<class L, int R, int K, int C>
+inline LaneMatrix<L, R, C> operator*(const LaneMatrix<L, R, K>& a, const LaneMatrix<L, K, C>& b) {
+    LaneMatrix<L, R, C> out;
+    for (int i = 0; i < R; i++) {
+        for (int j = 0; j < C; j++) {
+            typename L::V acc = L::mul(a.m[i][0], b.m[0][j]);
+            for (int k = 1; k < K; k++) acc = L::add(acc, L::mul(a.m[i][k], b.m[k][j]));
+            out.m[i][j] = acc;
+        }
+    }
+    return out;
+}
+
+template<class L, int R, int C>
+inline LaneMatrix<L, R, C> operator+(const LaneMatrix<L, R, C>& a, const LaneMatrix<L, R, C>& b) {
+    LaneMatrix<L, R, C> out;
+    for (int i = 0; i < R; i++)
+        for (int j = 0; j < C; j++) out.m[i][j] = L::add(a.m[i][j], b.m[i][j]);
+    return out;
+}
+
+template<class L, int R, int C>
+inline LaneMatrix<L, R, C> operator-(const LaneMatrix<L, R, C>& a, const LaneMatrix<L, R, C>& b) {
+    LaneMatrix<L, R, C> out;
+    for (int i = 0; i < R; i++)
+        for (int j = 0; j < C; j++) out.m[i][j] = L::sub(a.m[i][j], b.m[i][j]);
+    return out;
+}
+
+template<class L, int R, int C>
+inline LaneMatrix<L, C, R> transpose(const LaneMatrix<L, R, C>& a) {
+    LaneMatrix<L, C, R> out;
+    for (int i = 0; i < R; i++)
+        for (int j = 0; j < C; j++) out.m[j][i] = a.m[i][j];
+    return out;
+}
+
+template<class L>
+inline LaneMatrix<L, 2, 2> make2x2(float a, float b, float c, float d) {
+    LaneMatrix<L, 2, 2> out;
+    out.m[0][0] = L::dup(a);
+    out.m[0][1] = L::dup(b);
+    out.m[1][0] = L::dup(c);
+    out.m[1][1] = L::dup(d);
+    return out;
+}
+
+template<class L>
+inline LaneMatrix<L, 2, 2> load_block(const float* cov, int k) {
+    LaneMatrix<L, 2, 2> P;
+    P.m[0][0] = L::load(cov + k);
+    P.m[0][1] = P.m[1][0] = L::load(cov + NDIM + k);
+    P.m[1][1] = L::load(cov + 2 * NDIM + k);
+    return P;
+}
+
+template<class L>
+inline void store_block(float* cov, int k, const LaneMatrix<L, 2, 2>& P) {
+    L::store(cov + k, P.m[0][0]);
+    L::store(cov + NDIM + k, P.m[0][1]);
+    L::store(cov + 2 * NDIM + k, P.m[1][1]);
+}
+
+// x = F x, P = F P F^T + Q with F = [1 dt; 0 1], Q = diag(q_pos, q_vel)
+template<class L>
+int predict_blocks(float* mean, float* cov, float dt, const float* q_pos, const float* q_vel, int k) {
+    const LaneMatrix<L, 2, 2> F = make2x2<L>(1.0f, dt, 0.0f, 1.0f);
+    const LaneMatrix<L, 2, 2> Ft = transpose(F);
+    for (; k + L::N <= NDIM; k += L::N) {
+        LaneMatrix<L, 2, 1> x;
+        x.m[0][0] = L::load(mean + k);
+        x.m[1][0] = L::load(mean + NDIM + k);
+        x = F * x;
+        L::store(mean + k, x.m[0][0]);
+        L::store(mean + NDIM + k, x.m[1][0]);
+
+        LaneMatrix<L, 2, 2> Q;
+        Q.m[0][0] = L::load(q_pos + k);
+        Q.m[0][1] = Q.m[1][0] = L::dup(0.0f);
+        Q.m[1][1] = L::load(q_vel + k);
+        store_block<L>(cov, k, F * load_block<L>(cov, k) * Ft + Q);
+    }
+    return k;
+}
+
+// H = [1 0]: S = H P H^T + r, K = P H^T / S, x += K (z - H x), P -= K H P
+template<class L>
+int update_blocks(float* mean, float* cov, const float* z, const float* r, int k) {
+    LaneMatrix<L, 1, 2> H;
+    H.m[0][0] = L::dup(1.0f);
+    H.m[0][1] = L::dup(0.0f);
+    const LaneMatrix<L, 2, 1> Ht = transpose(H);
+    for (; k + L::N <= NDIM; k += L::N) {
+        LaneMatrix<L, 2, 1> x;
+        x.m[0][0] = L::load(mean + k);
+        x.m[1][0] = L::load(mean + NDIM + k);
+        LaneMatrix<L, 2, 2> P = load_block<L>(cov, k);
+
+        LaneMatrix<L, 2, 1> PHt = P * Ht;
+        typename L::V S = L::add((H * PHt).m[0][0], L::load(r + k));
+        LaneMatrix<L, 2, 1> K;
+        K.m[0][0] = L::div(PHt.m[0][0], S);
+        K.m[1][0] = L::div(PHt.m[1][0], S);
+
+        LaneMatrix<L, 1, 1> innovation;
+        innovation.m[0][0] = L::sub(L::load(z + k), (H * x).m[0][0]);
+        x = x + K * innovation;
+        P = P - K * (H * P);
+
+        L::store(mean + k, x.m[0][0]);
+        L::store(mean + NDIM + k, x.m[1][0]);
+        store_block<L>(cov, k, P);
+    }
+    return k;
+}
+
+} // namespace
+
+KalmanFilter::KalmanFilter()
+{
+    std_weight_position = 1.0f / 20.0f;
+    std_weight_velocity = 1.0f / 160.0f;
+}
+
+void KalmanFilter::initiate(const float* xyah, Mean& mean, Covariance& covariance) const
+{
+    const float h = xyah[3];
+    const float std_pos[NDIM] = { 2 * std_weight_position * h, 2 * std_weight_position * h, 1e-2f, 2 * std_weight_position * h };
+    const float std_vel[NDIM] = { 10 * std_weight_velocity * h, 10 * std_weight_velocity * h, 1e-5f, 10 * std_weight_velocity * h };
+    for (int k = 0; k < NDIM; k++) {
+        mean[k] = xyah[k];
+        mean[NDIM + k] = 0.0f;
+        covariance[k] = std_pos[k] * std_pos[k];
+        covariance[NDIM + k] = 0.0f;
+        covariance[2 * NDIM + k] = std_vel[k] * std_vel[k];
+    }
+}
+
+void KalmanFilter::predict(const int* slots, int count, float dt, Mean* means, Covariance* covariances) const
+{
+    for (int i = 0; i < count; i++) {
+        float* mean = means[slots[i]].data();
+        float* cov = covariances[slots[i]].data();
+        const float h = mean[3];
+        const float sp = std_weight_position * h;
+        const float sv = std_weight_velocity * h;
+        const float q_pos[NDIM] = { sp * sp * dt, sp * sp * dt, 1e-4f * dt, sp * sp * dt };
+        const float q_vel[NDIM] = { sv * sv * dt, sv * sv * dt, 1e-10f * dt, sv * sv * dt };
+
+        int k = 0;
+#if HAVE_SIMD_LANES
+        k = predict_blocks<SimdLanes>(mean, cov, dt, q_pos, q_vel, k);
+#endif
+        predict_blocks<ScalarLanes>(mean, cov, dt, q_pos, q_vel, k);
+    }
+}
+
+void KalmanFilter::update(const int* slots, const float* xyah, int count, Mean* means, Covariance* covariances) const
+{
+    for (int i = 0; i < count; i++) {
+        float* mean = means[slots[i]].data();
+        float* cov = covariances[slots[i]].data();
+        const float sp = std_weight_position * mean[3];
+        const float r[NDIM] = { sp * sp, sp * sp, 1e-2f, sp * sp };
+
+        int k = 0;
+#if HAVE_SIMD_LANES
+        k = update_blocks<SimdLanes>(mean, cov, xyah + i * NDIM, r, k);
+#endif
+        update_blocks<ScalarLanes>(mean, cov, xyah + i * NDIM, r, k);
+    }
+}
@@ -0,0 +1,84 @@
+#include "keyframe_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double SMOOTHING = 0.1;          // weight of a new sample in the running averages
+const double MAX_FRAME_GAP_MS = 1000;  // longer gaps are pauses, not the camera rate
+const double NOMINAL_FRAME_MS = 33.3;  // camera period until one has been measured
+const float MOTION_BUDGET = 0.5f;      // box heights a track may travel between keyframes
+const float UNCERTAINTY_LIMIT = 0.2f;  // position std (box heights) that forces a keyframe
+
+void smooth(double& average, double sample) {
+    average = average > 0 ? average + SMOOTHING * (sample - average) : sample;
+}
+
+} // namespace
+
+void KeyframeScheduler::setMaxInterval(int max_interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_frames = std::max(1, max_interval);
+    force_keyframe = true;
+    updateInterval();
+}
+
+bool KeyframeScheduler::nextFrame(int64_t timestamp_ns) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (last_timestamp_ns > 0 && timestamp_ns > last_timestamp_ns) {
+        double gap_ms = (timestamp_ns - last_timestamp_ns) / 1e6;
+        if (gap_ms < MAX_FRAME_GAP_MS) smooth(frame_ms, gap_ms);
+    }
+    last_timestamp_ns = timestamp_ns;
+
+    if (max_frames <= 1 || force_keyframe || ++frames_since_keyframe >= current_interval) {
+        frames_since_keyframe = 0;
+        force_keyframe = false;
+        current_interval = std::min(target_interval, current_interval + 1);
+        return true;
+    }
+    return false;
+}
+
+void KeyframeScheduler::reportDetectorLatency(double ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    smooth(detector_ms, ms);
+    updateInterval();
+}
+
+void KeyframeScheduler::reportTracks(const TrackMotion& tracks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    motion = tracks;
+    if (motion.max_uncertainty > UNCERTAINTY_LIMIT) force_keyframe = true;
+    updateInterval();
+}
+
+void KeyframeScheduler::requestKeyframe() {
+    std::lock_guard<std::mutex> lock(mutex);
+    force_keyframe = true;
+}
+
+int KeyframeScheduler::interval() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current_interval;
+}
+
+void KeyframeScheduler::updateInterval() {
+    // Frames one inference occupies at the current camera rate
+    int latency_frames = 1;
+    if (frame_ms > 0 && detector_ms > 0) latency_frames = (int)std::ceil(detector_ms / frame_ms);
+
+    // Frames until the fastest track has moved MOTION_BUDGET of its own height. Without
+    // tracks there is nothing to extrapolate, and a new track has no velocity yet, so then
+    // detect as often as the device keeps up.
+    int motion_frames = latency_frames;
+    if (motion.tracks > 0 && motion.new_tracks == 0) {
+        const double frame_s = (frame_ms > 0 ? frame_ms : NOMINAL_FRAME_MS) / 1000.0;
+        const double per_frame = motion.max_speed * frame_s;
+        motion_frames = max_frames;
+        if (per_frame > 0) motion_frames = (int)std::min<double>(max_frames, MOTION_BUDGET / per_frame);
+    }
+
+    target_interval = std::max(1, std::min(max_frames, std::max(motion_frames, latency_frames)));
+    current_interval = std::min(current_interval, target_interval);
+}
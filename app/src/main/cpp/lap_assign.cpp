@@ -0,0 +1,223 @@
+#include "lap_assign.h"
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+
+void SparseAssignment::reset(int rows, int cols) {
+    num_rows = rows;
+    num_cols = cols;
+    num_components = 0;
+    edge_row.clear();
+    edge_col.clear();
+    edge_cost.clear();
+}
+
+void SparseAssignment::add(int row, int col, float cost) {
+    edge_row.push_back(row);
+    edge_col.push_back(col);
+    edge_cost.push_back(cost);
+}
+
+int SparseAssignment::find(int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void SparseAssignment::solve(float cost_limit, std::vector<int>& row_to_col, std::vector<int>& col_to_row) {
+    row_to_col.assign(num_rows, -1);
+    col_to_row.assign(num_cols, -1);
+    num_components = 0;
+    const int num_edges = (int)edge_cost.size();
+    if (num_edges == 0) return;
+
+    // 1. Connected components of the gated pairs
+    const int num_nodes = num_rows + num_cols;
+    parent.resize(num_nodes);
+    for (int i = 0; i < num_nodes; i++) parent[i] = i;
+    for (int e = 0; e < num_edges; e++) {
+        int a = find(edge_row[e]);
+        int b = find(num_rows + edge_col[e]);
+        if (a != b) parent[a] = b;
+    }
+
+    // 2. Group edges by component (counting sort on the root)
+    component_of.assign(num_nodes, -1);
+    component_start.clear();
+    for (int e = 0; e < num_edges; e++) {
+        int root = find(edge_row[e]);
+        if (component_of[root] < 0) {
+            component_of[root] = num_components++;
+            component_start.push_back(0);
+        }
+        component_start[component_of[root]]++;
+    }
+    int offset = 0;
+    for (int c = 0; c < num_components; c++) {
+        int count = component_start[c];
+        component_start[c] = offset;
+        offset += count;
+    }
+    component_start.push_back(offset);
+
+    sorted_edges.resize(num_edges);
+    for (int e = 0; e < num_edges; e++) {
+        int c = component_of[find(edge_row[e])];
+        sorted_edges[component_start[c]++] = e;
+    }
+    for (int c = num_components; c > 0; c--) component_start[c] = component_start[c - 1];
+    component_start[0] = 0;
+
+    // 3. Solve each component independently
+    local_row.assign(num_rows, -1);
+    local_col.assign(num_cols, -1);
+    for (int c = 0; c < num_components; c++) {
+        solveComponent(component_start[c], component_start[c + 1], cost_limit, row_to_col, col_to_row);
+    }
+}
+
+void SparseAssignment::solveComponent(int begin, int end, float cost_limit,
+                                      std::vector<int>& row_to_col, std::vector<int>& col_to_row) {
+    // Single pair: take it, it was gated below the limit
+    if (end - begin == 1) {
+        int e = sorted_edges[begin];
+        row_to_col[edge_row[e]] = edge_col[e];
+        col_to_row[edge_col[e]] = edge_row[e];
+        return;
+    }
+
+    rows_in.clear();
+    cols_in.clear();
+    for (int k = begin; k < end; k++) {
+        int e = sorted_edges[k];
+        if (local_row[edge_row[e]] < 0) {
+            local_row[edge_row[e]] = (int)rows_in.size();
+            rows_in.push_back(edge_row[e]);
+        }
+        if (local_col[edge_col[e]] < 0) {
+            local_col[edge_col[e]] = (int)cols_in.size();
+            cols_in.push_back(edge_col[e]);
+        }
+    }
+
+    // Work in (cost - limit): a gated pair is negative and leaving a row or column unassigned
+    // is 0, so minimising the sum over assigned pairs is the extended problem. Each row gets
+    // a private zero-cost column (c + i) that stands for "unassigned", which makes every row
+    // assignable and the problem a rectangular one over the component's own edges.
+    const int r = (int)rows_in.size();
+    const int c = (int)cols_in.size();
+    const int num_cols_ext = c + r;
+
+    row_start.assign(r + 1, 0);
+    for (int k = begin; k < end; k++) row_start[local_row[edge_row[sorted_edges[k]]] + 1]++;
+    for (int i = 0; i < r; i++) row_start[i + 1] += row_start[i];
+    adj_col.resize(end - begin);
+    adj_cost.resize(end - begin);
+    fill_pos.assign(row_start.begin(), row_start.end() - 1);
+    for (int k = begin; k < end; k++) {
+        int e = sorted_edges[k];
+        int pos = fill_pos[local_row[edge_row[e]]]++;
+        adj_col[pos] = local_col[edge_col[e]];
+        adj_cost[pos] = edge_cost[e] - cost_limit;
+    }
+
+    // Potentials keep every reduced cost (cost + row_potential - col_potential) non-negative
+    row_potential.assign(r, 0.0f);
+    col_potential.assign(num_cols_ext, 0.0f);
+    for (int i = 0; i < r; i++) {
+        float lowest = 0.0f; // the private column
+        for (int k = row_start[i]; k < row_start[i + 1]; k++) lowest = std::min(lowest, adj_cost[k]);
+        row_potential[i] = -lowest;
+    }
+    row_assigned.assign(r, -1);
+    col_assigned.assign(num_cols_ext, -1);
+    dist.assign(num_cols_ext, FLT_MAX);
+    pred.assign(num_cols_ext, -1);
+    done.assign(num_cols_ext, 0);
+
+    // One shortest augmenting path per row; Dijkstra stops at the first free column
+    touched.clear();
+    for (int s = 0; s < r; s++) {
+        heap.clear();
+        settled.clear();
+        relax(s, 0.0f);
+
+        int sink = -1;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int> >());
+            std::pair<float, int> top = heap.back();
+            heap.pop_back();
+            int j = top.second;
+            if (done[j] || top.first > dist[j]) continue;
+            done[j] = 1;
+            settled.push_back(j);
+            if (col_assigned[j] < 0) {
+                sink = j;
+                break;
+            }
+            relax(col_assigned[j], top.first);
+        }
+
+        // Shift potentials of everything settled closer than the sink
+        const float d_sink = dist[sink];
+        row_potential[s] -= d_sink;
+        for (int j : settled) {
+            float shift = dist[j] - d_sink;
+            col_potential[j] += shift;
+            if (j != sink) row_potential[col_assigned[j]] += shift;
+        }
+
+        // Flip the path back to s
+        for (int j = sink;;) {
+            int i = pred[j];
+            int prev = row_assigned[i];
+            row_assigned[i] = j;
+            col_assigned[j] = i;
+            if (i == s) break;
+            j = prev;
+        }
+
+        for (int j : touched) {
+            dist[j] = FLT_MAX;
+            done[j] = 0;
+        }
+        touched.clear();
+    }
+
+    for (int i = 0; i < r; i++) {
+        int j = row_assigned[i];
+        if (j >= c) continue; // took its private column: unmatched
+        row_to_col[rows_in[i]] = cols_in[j];
+        col_to_row[cols_in[j]] = rows_in[i];
+    }
+
+    for (int row : rows_in) local_row[row] = -1;
+    for (int col : cols_in) local_col[col] = -1;
+}
+
+// Offers the columns adjacent to `row` (reached at reduced distance `base`) to the search
+void SparseAssignment::relax(int row, float base) {
+    const int private_col = (int)cols_in.size() + row;
+    float d = base + row_potential[row] - col_potential[private_col];
+    if (!done[private_col] && d < dist[private_col]) {
+        if (dist[private_col] == FLT_MAX) touched.push_back(private_col);
+        dist[private_col] = d;
+        pred[private_col] = row;
+        heap.push_back(std::make_pair(d, private_col));
+        std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int> >());
+    }
+    for (int k = row_start[row]; k < row_start[row + 1]; k++) {
+        int j = adj_col[k];
+        if (done[j]) continue;
+        d = base + adj_cost[k] + row_potential[row] - col_potential[j];
+        if (d < dist[j]) {
+            if (dist[j] == FLT_MAX) touched.push_back(j);
+            dist[j] = d;
+            pred[j] = row;
+            heap.push_back(std::make_pair(d, j));
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<float, int> >());
+        }
+    }
+}
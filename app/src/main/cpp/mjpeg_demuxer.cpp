@@ -0,0 +1,360 @@
+#include "mjpeg_demuxer.h"
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include "native_log.h"
+#include "simd_lanes.h"
+
+namespace {
+
+const size_t INITIAL_WINDOW = 256 * 1024;
+const size_t MAX_WINDOW = 16 * 1024 * 1024; // also bounds a single frame
+const size_t MIN_READ = 64 * 1024;          // free space kept behind the data before a read()
+const size_t SIDE_BYTES = 4096;             // longest HTTP header / chunk-size line
+const size_t LINE_READ = 256;               // small reads while looking for a line end
+const size_t MAX_PART_HEADER = 4096;
+
+// Checks the candidates of one lane block at a time; on a hit i is the match position.
+// Only starts up to `last` are examined, so the block never reads past the haystack.
+template<class B>
+bool find_from(const unsigned char* hay, size_t last, const unsigned char* needle, size_t m, size_t& i) {
+    const int gap = (int)m - 1;
+    for (; i + B::N - 1 <= last; i += B::N) {
+        int mask = B::match(hay + i, needle[0], needle[gap], gap);
+        while (mask) {
+            const int bit = __builtin_ctz(mask);
+            if (memcmp(hay + i + bit, needle, m) == 0) {
+                i += bit;
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return false;
+}
+
+// Offset of needle in [hay, hay + n), or n if it does not occur
+size_t find_bytes(const unsigned char* hay, size_t n, const std::string& needle) {
+    const size_t m = needle.size();
+    if (m == 0 || n < m) return n;
+    const unsigned char* nd = (const unsigned char*)needle.data();
+    const size_t last = n - m;
+    size_t i = 0;
+#if HAVE_SIMD_LANES
+    if (find_from<SimdBytes>(hay, last, nd, m, i)) return i;
+#endif
+    if (find_from<ScalarBytes>(hay, last, nd, m, i)) return i;
+    return n;
+}
+
+bool starts_with_nocase(const std::string& s, const char* prefix) {
+    return strncasecmp(s.c_str(), prefix, strlen(prefix)) == 0;
+}
+
+std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t\"");
+    if (a == std::string::npos) return std::string();
+    size_t b = s.find_last_not_of(" \t\"");
+    return s.substr(a, b - a + 1);
+}
+
+// Content-Length of a part header block, -1 if it has none
+long content_length(const unsigned char* p, size_t n) {
+    static const char KEY[] = "content-length:";
+    const size_t k = sizeof(KEY) - 1;
+    for (size_t i = 0; i + k <= n; i++) {
+        if ((i == 0 || p[i - 1] == '\n') && strncasecmp((const char*)p + i, KEY, k) == 0) {
+            char digits[24];
+            size_t len = 0;
+            for (size_t j = i + k; j < n && p[j] != '\r' && p[j] != '\n' && len + 1 < sizeof(digits); j++) {
+                digits[len++] = (char)p[j];
+            }
+            digits[len] = 0;
+            char* stop;
+            long value = strtol(digits, &stop, 10);
+            return stop != digits && value >= 0 ? value : -1;
+        }
+    }
+    return -1;
+}
+
+int64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+MjpegDemuxer::MjpegDemuxer(int fd, bool owns_fd)
+    : fd(fd), owns_fd(owns_fd), head_pending(true), side(SIDE_BYTES), window(INITIAL_WINDOW) {
+}
+
+MjpegDemuxer::MjpegDemuxer(int fd, const std::string& boundary, bool owns_fd)
+    : fd(fd), owns_fd(owns_fd), head_pending(false), side(SIDE_BYTES), window(INITIAL_WINDOW) {
+    setBoundary(boundary);
+}
+
+MjpegDemuxer::~MjpegDemuxer() {
+    if (owns_fd && fd >= 0) close(fd);
+}
+
+int MjpegDemuxer::connect(const char* host, int port, const char* path, int timeout_ms) {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    addrinfo* addrs = nullptr;
+    if (getaddrinfo(host, service, &hints, &addrs) != 0) {
+        LOGE("MJPEG: cannot resolve %s", host);
+        return -1;
+    }
+
+    timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    int sock = -1;
+    for (addrinfo* a = addrs; a && sock < 0; a = a->ai_next) {
+        sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (sock < 0) continue;
+        // SO_SNDTIMEO also bounds a blocking connect()
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (::connect(sock, a->ai_addr, a->ai_addrlen) != 0) {
+            close(sock);
+            sock = -1;
+        }
+    }
+    freeaddrinfo(addrs);
+    if (sock < 0) {
+        LOGE("MJPEG: cannot connect to %s:%d", host, port);
+        return -1;
+    }
+
+    std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: " + host + ":" + service +
+                          "\r\nConnection: close\r\n\r\n";
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(sock, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            close(sock);
+            return -1;
+        }
+        sent += n;
+    }
+    return sock;
+}
+
+void MjpegDemuxer::cancel() {
+    cancelled.store(true);
+    // Wakes a read() blocked on a socket; harmless on other descriptors
+    shutdown(fd, SHUT_RDWR);
+}
+
+void MjpegDemuxer::setBoundary(const std::string& boundary) {
+    boundary_name = boundary;
+    delimiter = "--" + boundary;
+    closing = "\r\n" + delimiter;
+}
+
+long MjpegDemuxer::readRaw(unsigned char* dst, size_t max) {
+    if (side_begin < side_end) {
+        size_t n = std::min(max, side_end - side_begin);
+        memcpy(dst, &side[side_begin], n);
+        side_begin += n;
+        return (long)n;
+    }
+    while (true) {
+        ssize_t n = read(fd, dst, max);
+        if (n < 0 && errno == EINTR && !cancelled.load()) continue;
+        if (n > 0) bytes_read += n;
+        return (long)n;
+    }
+}
+
+// One CRLF (or bare LF) terminated line from the side buffer, refilled with small reads
+bool MjpegDemuxer::readLine(std::string& line) {
+    while (true) {
+        const unsigned char* start = &side[side_begin];
+        const unsigned char* nl = (const unsigned char*)memchr(start, '\n', side_end - side_begin);
+        if (nl) {
+            size_t len = nl - start;
+            if (len > 0 && start[len - 1] == '\r') len--;
+            line.assign((const char*)start, len);
+            side_begin = nl - &side[0] + 1;
+            return true;
+        }
+        if (side_begin > 0) {
+            memmove(&side[0], &side[side_begin], side_end - side_begin);
+            side_end -= side_begin;
+            side_begin = 0;
+        }
+        if (side_end == side.size()) return false; // line longer than the side buffer
+        ssize_t n;
+        do {
+            n = read(fd, &side[side_end], std::min(LINE_READ, side.size() - side_end));
+        } while (n < 0 && errno == EINTR && !cancelled.load());
+        if (n <= 0) return false;
+        side_end += n;
+        bytes_read += n;
+    }
+}
+
+bool MjpegDemuxer::readResponseHead() {
+    std::string line;
+    int status = 0;
+    if (!readLine(line) || sscanf(line.c_str(), "HTTP/%*d.%*d %d", &status) != 1 || status != 200) {
+        LOGE("MJPEG: unexpected response '%s'", line.c_str());
+        return false;
+    }
+    while (readLine(line)) {
+        if (line.empty()) {
+            head_pending = false;
+            if (delimiter.empty()) LOGE("MJPEG: response has no multipart boundary");
+            return !delimiter.empty();
+        }
+        if (starts_with_nocase(line, "content-type:")) {
+            size_t at = line.find("boundary=");
+            if (at != std::string::npos) {
+                std::string value = line.substr(at + 9);
+                setBoundary(trim(value.substr(0, value.find(';'))));
+            }
+        } else if (starts_with_nocase(line, "transfer-encoding:")) {
+            chunked = line.find("chunked") != std::string::npos;
+        }
+    }
+    return false;
+}
+
+// Consumes a chunk-size line; false at the terminating zero-size chunk or on errors
+bool MjpegDemuxer::startChunk() {
+    std::string line;
+    if (chunk_trailer_crlf && (!readLine(line) || !line.empty())) return false;
+    if (!readLine(line)) return false;
+    char* stop;
+    unsigned long size = strtoul(line.c_str(), &stop, 16);
+    if (stop == line.c_str() || size == 0) return false;
+    chunk_left = size;
+    chunk_trailer_crlf = true;
+    return true;
+}
+
+long MjpegDemuxer::readBody(unsigned char* dst, size_t max) {
+    if (!chunked) return readRaw(dst, max);
+    if (chunk_left == 0 && !startChunk()) return 0;
+    long n = readRaw(dst, std::min(max, chunk_left));
+    if (n > 0) chunk_left -= n;
+    return n;
+}
+
+// Reads until at least `need` unparsed bytes are in the window. The window slides its
+// unparsed bytes to the front only when less than MIN_READ is free behind them, and
+// grows when need itself does not fit.
+bool MjpegDemuxer::fill(size_t need) {
+    while (end - begin < need) {
+        if (failed || cancelled.load()) return false;
+        if (need > MAX_WINDOW) {
+            LOGE("MJPEG: frame larger than %zu bytes", MAX_WINDOW);
+            failed = true;
+            return false;
+        }
+        if (window.size() - end < MIN_READ || begin + need > window.size()) {
+            if (begin > 0) {
+                memmove(&window[0], &window[begin], end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            if (window.size() < need + MIN_READ) {
+                window.resize(std::min(MAX_WINDOW + MIN_READ, std::max(window.size() * 2, need + MIN_READ)));
+            }
+        }
+        long n = readBody(&window[end], window.size() - end);
+        if (n <= 0) {
+            at_eof = n == 0;
+            failed = true;
+            return false;
+        }
+        end += n;
+    }
+    return true;
+}
+
+bool MjpegDemuxer::next(MjpegFrame& frame) {
+    if (failed || cancelled.load()) return false;
+    if (head_pending && !readResponseHead()) {
+        failed = true;
+        return false;
+    }
+
+    const size_t dlen = delimiter.size();
+    while (true) {
+        // Delimiter line; with Content-Length framing it follows the last payload directly
+        size_t at;
+        while ((at = find_bytes(&window[begin], end - begin, delimiter)) == end - begin) {
+            begin = end - std::min(end - begin, dlen - 1);
+            if (!fill(end - begin + 1)) return false;
+        }
+        begin += at;
+        if (!fill(dlen + 2)) return false;
+        if (window[begin + dlen] == '-' && window[begin + dlen + 1] == '-') {
+            failed = true; // close delimiter: the stream is over
+            return false;
+        }
+
+        // Part headers end at the first empty line
+        static const std::string BLANK_LINE("\r\n\r\n");
+        size_t header;
+        while ((header = find_bytes(&window[begin + dlen], end - begin - dlen, BLANK_LINE)) == end - begin - dlen) {
+            if (end - begin > MAX_PART_HEADER) {
+                LOGE("MJPEG: part header too long");
+                failed = true;
+                return false;
+            }
+            if (!fill(end - begin + 1)) return false;
+        }
+        const size_t payload = dlen + header + BLANK_LINE.size();
+        const long length = content_length(&window[begin + dlen], header + 2);
+
+        size_t size;
+        if (length >= 0) {
+            // Jump straight over the payload
+            if (!fill(payload + length)) return false;
+            size = length;
+        } else {
+            // No length: the payload runs up to CRLF + delimiter
+            size_t scanned = payload;
+            size_t k;
+            while ((k = find_bytes(&window[begin + scanned], end - begin - scanned, closing)) == end - begin - scanned) {
+                scanned = std::max(payload, end - begin - std::min(end - begin, closing.size() - 1));
+                if (!fill(end - begin + 1)) {
+                    // A recording may end right after its last JPEG (EOI marker) without a delimiter
+                    const size_t tail = end - begin;
+                    if (!at_eof || tail < payload + 2 || window[end - 2] != 0xFF || window[end - 1] != 0xD9) return false;
+                    k = tail - scanned;
+                    break;
+                }
+            }
+            size = scanned + k - payload;
+        }
+
+        const unsigned char* data = &window[begin + payload];
+        begin += payload + size;
+        // Anything that is not a JPEG (SOI marker first) is skipped
+        if (size >= 2 && data[0] == 0xFF && data[1] == 0xD8) {
+            frame.data = data;
+            frame.size = size;
+            frame.timestamp_ns = monotonic_ns();
+            return true;
+        }
+    }
+}
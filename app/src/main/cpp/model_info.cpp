@@ -0,0 +1,154 @@
+#include "model_info.h"
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+std::string unquote(const std::string& s) {
+    if (s.size() >= 2 && (s[0] == '\'' || s[0] == '"') && s[s.size() - 1] == s[0]) {
+        return s.substr(1, s.size() - 2);
+    }
+    return s;
+}
+
+// Integer value of "<id>=<value>" in a layer's parameter list, or fallback
+int layer_param(const std::vector<std::string>& params, int id, int fallback) {
+    for (const std::string& p : params) {
+        size_t eq = p.find('=');
+        if (eq == std::string::npos) continue;
+        if (std::atoi(p.substr(0, eq).c_str()) == id) return std::atoi(p.c_str() + eq + 1);
+    }
+    return fallback;
+}
+
+} // namespace
+
+bool parse_param_graph(const char* text, size_t len, ModelInfo& info) {
+    std::istringstream in(std::string(text, len));
+
+    int magic = 0;
+    int layer_count = 0;
+    int blob_count = 0;
+    if (!(in >> magic) || magic != 7767517) return false;
+    if (!(in >> layer_count >> blob_count)) return false;
+
+    std::set<std::string> produced;
+    std::set<std::string> consumed;
+    std::vector<std::string> produced_order;
+    std::string input_name;
+    int memory_anchors = 0;
+
+    std::string line;
+    std::getline(in, line); // rest of the header line
+    while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        std::string type, name;
+        int num_in = 0, num_out = 0;
+        if (!(ls >> type >> name >> num_in >> num_out)) continue;
+
+        for (int i = 0; i < num_in; i++) {
+            std::string blob;
+            ls >> blob;
+            consumed.insert(blob);
+        }
+        std::vector<std::string> outputs(num_out);
+        for (int i = 0; i < num_out; i++) {
+            ls >> outputs[i];
+            if (produced.insert(outputs[i]).second) produced_order.push_back(outputs[i]);
+        }
+        std::vector<std::string> params;
+        std::string p;
+        while (ls >> p) params.push_back(p);
+
+        if (type == "Input" && num_out > 0) {
+            input_name = outputs[0];
+            int w = layer_param(params, 0, 0);
+            int h = layer_param(params, 1, 0);
+            if (w > 0 && h > 0) {
+                info.input_w = w;
+                info.input_h = h;
+            }
+        } else if (type == "MemoryData") {
+            // pnnx folds the anchor grid / stride tensor into MemoryData with w = anchor count
+            int w = layer_param(params, 0, 0);
+            if (w > memory_anchors) memory_anchors = w;
+        }
+    }
+
+    if (!input_name.empty()) info.input_name = input_name;
+    for (const std::string& blob : produced_order) {
+        if (!consumed.count(blob)) {
+            info.output_name = blob;
+            break;
+        }
+    }
+    if (memory_anchors > 0) {
+        info.num_anchors = memory_anchors;
+        info.fixed_shape = true;
+    }
+    return true;
+}
+
+bool parse_metadata_yaml(const char* text, size_t len, ModelInfo& info) {
+    std::istringstream in(std::string(text, len));
+
+    std::string section;
+    std::vector<int> imgsz;
+    std::map<int, std::string> names;
+
+    std::string raw;
+    while (std::getline(in, raw)) {
+        if (raw.empty() || raw[0] == '#') continue;
+        const bool indented = raw[0] == ' ' || raw[0] == '\t' || raw[0] == '-';
+        std::string line = trim(raw);
+        if (line.empty()) continue;
+
+        if (!indented) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            section = trim(line.substr(0, colon));
+            std::string value = trim(line.substr(colon + 1));
+
+            if (section == "stride" && !value.empty()) {
+                info.stride = std::atoi(value.c_str());
+            } else if (section == "end2end") {
+                info.end2end = value == "true" || value == "True";
+            }
+            continue;
+        }
+
+        if (section == "imgsz" && line[0] == '-') {
+            imgsz.push_back(std::atoi(trim(line.substr(1)).c_str()));
+        } else if (section == "names") {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            names[std::atoi(line.substr(0, colon).c_str())] = unquote(trim(line.substr(colon + 1)));
+        }
+    }
+
+    // Ultralytics writes imgsz as [h, w] (or a single square size)
+    if (imgsz.size() == 1 && imgsz[0] > 0) {
+        info.input_w = info.input_h = imgsz[0];
+    } else if (imgsz.size() >= 2 && imgsz[0] > 0 && imgsz[1] > 0) {
+        info.input_h = imgsz[0];
+        info.input_w = imgsz[1];
+    }
+
+    if (!names.empty()) {
+        info.num_classes = names.rbegin()->first + 1;
+        info.class_names.assign(info.num_classes, std::string());
+        for (const auto& kv : names) {
+            if (kv.first >= 0) info.class_names[kv.first] = kv.second;
+        }
+    }
+    return true;
+}
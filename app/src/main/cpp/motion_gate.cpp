@@ -0,0 +1,108 @@
+#include "motion_gate.h"
+#include <algorithm>
+#include <cstring>
+#include "simd_lanes.h"
+
+namespace {
+
+const int SAMPLES = 4;             // per thumbnail cell and axis
+const int BLOCK_W = 8;             // SAD block, thumbnail pixels
+const int BLOCK_H = 6;
+const float MIN_THRESHOLD = 6.0f;  // luma levels, mean absolute difference of a block
+const float NOISE_FACTOR = 2.5f;
+const float NOISE_SMOOTHING = 0.05f;
+// Held frames only teach the noise estimate what is still below the threshold, so a slowly
+// rising change (someone approaching) would otherwise ratchet it up without bound
+const float MAX_NOISE = 4.0f;
+
+// Source coordinate of sample k of n spread evenly over [0, size)
+inline int sample_at(int k, int n, int size) {
+    return (int)(((int64_t)(2 * k + 1) * size) / (2 * n));
+}
+
+// Adds the row's absolute differences to the per-block sums
+template<class B>
+int sad_row(const unsigned char* a, const unsigned char* b, unsigned int* sums, int x, int n) {
+    for (; x + B::N <= n; x += B::N) B::sad(a + x, b + x, sums + x / BLOCK_W);
+    return x;
+}
+
+// Box-samples a THUMB_W x THUMB_H luma thumbnail; luma(row, x) reads one source pixel
+template<class Luma>
+void sample_thumbnail(unsigned char* thumb, int width, int height, const Luma& luma) {
+    const int cols = MotionGate::THUMB_W * SAMPLES;
+    const int rows = MotionGate::THUMB_H * SAMPLES;
+    int sx[cols];
+    for (int k = 0; k < cols; k++) sx[k] = sample_at(k, cols, width);
+
+    for (int ty = 0; ty < MotionGate::THUMB_H; ty++) {
+        unsigned int sums[MotionGate::THUMB_W] = {0};
+        for (int j = 0; j < SAMPLES; j++) {
+            const int y = sample_at(ty * SAMPLES + j, rows, height);
+            for (int k = 0; k < cols; k++) sums[k / SAMPLES] += luma(y, sx[k]);
+        }
+        for (int tx = 0; tx < MotionGate::THUMB_W; tx++) {
+            thumb[ty * MotionGate::THUMB_W + tx] = (unsigned char)(sums[tx] / (SAMPLES * SAMPLES));
+        }
+    }
+}
+
+} // namespace
+
+void MotionGate::setEnabled(bool enabled, int max_stale) {
+    max_stale_ms.store(std::max(0, max_stale), std::memory_order_relaxed);
+    is_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void MotionGate::sampleY(const unsigned char* y, int width, int height, int stride) {
+    sample_thumbnail(current, width, height, [y, stride](int row, int x) {
+        return (unsigned int)y[(size_t)row * stride + x];
+    });
+}
+
+void MotionGate::sampleRGBA(const unsigned char* rgba, int width, int height, int stride) {
+    sample_thumbnail(current, width, height, [rgba, stride](int row, int x) {
+        const unsigned char* p = rgba + (size_t)row * stride + x * 4;
+        return (unsigned int)(p[0] + 2 * p[1] + p[2]) >> 2;
+    });
+}
+
+// Worst block's mean absolute difference between current and reference
+float MotionGate::score() {
+    unsigned int worst = 0;
+    for (int by = 0; by < THUMB_H; by += BLOCK_H) {
+        memset(block_sad, 0, sizeof(block_sad));
+        for (int y = by; y < by + BLOCK_H; y++) {
+            const unsigned char* a = current + y * THUMB_W;
+            const unsigned char* b = reference + y * THUMB_W;
+            int x = 0;
+#if HAVE_SIMD_LANES
+            x = sad_row<SimdBytes>(a, b, block_sad, x, THUMB_W);
+#endif
+            sad_row<ScalarBytes>(a, b, block_sad, x, THUMB_W);
+        }
+        for (int bx = 0; bx < THUMB_W / BLOCK_W; bx++) worst = std::max(worst, block_sad[bx]);
+    }
+    return (float)worst / (BLOCK_W * BLOCK_H);
+}
+
+bool MotionGate::admit(int64_t timestamp_ns) {
+    bool pass = !has_reference || refresh.exchange(false, std::memory_order_relaxed);
+    if (!pass) {
+        last_score = score();
+        const float threshold = std::max(MIN_THRESHOLD, NOISE_FACTOR * noise);
+        const int64_t stale_ns = (int64_t)max_stale_ms.load(std::memory_order_relaxed) * 1000000;
+        if (last_score > threshold) {
+            pass = true;
+        } else {
+            noise = std::min(MAX_NOISE, noise + NOISE_SMOOTHING * (last_score - noise));
+            pass = timestamp_ns - reference_ns >= stale_ns || timestamp_ns < reference_ns;
+        }
+    }
+    if (pass) {
+        memcpy(reference, current, sizeof(reference));
+        reference_ns = timestamp_ns;
+        has_reference = true;
+    }
+    return pass;
+}
@@ -0,0 +1,161 @@
+#include "nms.h"
+#include <algorithm>
+#include "simd_lanes.h"
+
+namespace {
+
+// The SpatialGrid sweep replaces the SIMD pass over every later box when there are enough
+// candidates and a box is expected to intersect only a small fraction of the others (small
+// objects spread over the frame). When boxes are large relative to the frame most pairs
+// really do intersect, and the SIMD block pass is cheaper than the grid's scalar probes.
+const int GRID_MIN_CANDIDATES = 256;
+const float GRID_MAX_NEIGHBOUR_FRACTION = 1.0f / 32;
+
+bool grid_pays_off(const std::vector<float>& boxes, const int* order, int n) {
+    if (n < GRID_MIN_CANDIDATES) return false;
+    float min_x = boxes[order[0] * 4], min_y = boxes[order[0] * 4 + 1];
+    float max_x = min_x, max_y = min_y;
+    double sum_w = 0.0, sum_h = 0.0;
+    for (int k = 0; k < n; k++) {
+        const float* b = &boxes[order[k] * 4];
+        min_x = std::min(min_x, b[0]);
+        min_y = std::min(min_y, b[1]);
+        max_x = std::max(max_x, b[2]);
+        max_y = std::max(max_y, b[3]);
+        sum_w += b[2] - b[0];
+        sum_h += b[3] - b[1];
+    }
+    // Two boxes of mean size intersect when their centres are within (2w x 2h) of each other
+    double neighbourhood = 4.0 * (sum_w / n) * (sum_h / n);
+    double frame = (double)std::max(max_x - min_x, 1.0f) * std::max(max_y - min_y, 1.0f);
+    return neighbourhood < GRID_MAX_NEIGHBOUR_FRACTION * frame;
+}
+
+inline bool is_set(const uint32_t* mask, int i) { return (mask[i >> 5] >> (i & 31)) & 1u; }
+inline void set_bit(uint32_t* mask, int i) { mask[i >> 5] |= 1u << (i & 31); }
+
+// IoU of one box against [begin, end) of the sorted columns; boxes above the
+// threshold get their suppression bit set. inter > thr * union avoids the divide.
+template<class L>
+int suppress_block(float bx1, float by1, float bx2, float by2, float barea, float thr,
+                   const float* x1, const float* y1, const float* x2, const float* y2, const float* area,
+                   uint32_t* mask, int begin, int end) {
+    typedef typename L::V V;
+    const V vx1 = L::dup(bx1);
+    const V vy1 = L::dup(by1);
+    const V vx2 = L::dup(bx2);
+    const V vy2 = L::dup(by2);
+    const V varea = L::dup(barea);
+    const V vthr = L::dup(thr);
+    const V zero = L::dup(0.0f);
+
+    int j = begin;
+    for (; j + L::N <= end; j += L::N) {
+        V iw = L::max(zero, L::sub(L::min(vx2, L::load(x2 + j)), L::max(vx1, L::load(x1 + j))));
+        V ih = L::max(zero, L::sub(L::min(vy2, L::load(y2 + j)), L::max(vy1, L::load(y1 + j))));
+        V inter = L::mul(iw, ih);
+        V uni = L::sub(L::add(varea, L::load(area + j)), inter);
+        int hit = L::bits(L::gt(inter, L::mul(vthr, uni)));
+        for (int l = 0; hit; l++, hit >>= 1) {
+            if (hit & 1) set_bit(mask, j + l);
+        }
+    }
+    return j;
+}
+
+} // namespace
+
+void NmsEngine::run(const std::vector<float>& boxes, const std::vector<float>& scores, const std::vector<int>& class_ids,
+                    const NmsOptions& opt, std::vector<int>& keep) {
+    keep.clear();
+    const int total = (int)scores.size();
+    if (total == 0) return;
+
+    // 1. Top-K by score: partial selection first, then sort only the survivors
+    order.resize(total);
+    for (int i = 0; i < total; i++) order[i] = i;
+
+    auto by_score = [&](int a, int b) { return scores[a] > scores[b]; };
+    int n = total;
+    if (opt.max_candidates > 0 && n > opt.max_candidates) {
+        std::nth_element(order.begin(), order.begin() + opt.max_candidates, order.end(), by_score);
+        n = opt.max_candidates;
+    }
+    std::sort(order.begin(), order.begin() + n, by_score);
+
+    // 2. Gather into score-ordered columns, with the class offset applied if requested.
+    // The grid path keeps raw coordinates and compares class ids instead.
+    const bool use_grid = grid_pays_off(boxes, &order[0], n);
+    const bool offset_classes = opt.class_aware && !use_grid;
+    float offset_step = 0.0f;
+    if (offset_classes) {
+        for (int k = 0; k < n; k++) {
+            const float* b = &boxes[order[k] * 4];
+            offset_step = std::max(offset_step, std::max(b[2], b[3]));
+        }
+        offset_step += 1.0f;
+    }
+
+    x1.resize(n);
+    y1.resize(n);
+    x2.resize(n);
+    y2.resize(n);
+    area.resize(n);
+    for (int k = 0; k < n; k++) {
+        const int idx = order[k];
+        const float* b = &boxes[idx * 4];
+        const float off = offset_classes ? class_ids[idx] * offset_step : 0.0f;
+        x1[k] = b[0] + off;
+        y1[k] = b[1] + off;
+        x2[k] = b[2] + off;
+        y2[k] = b[3] + off;
+        area[k] = (b[2] - b[0]) * (b[3] - b[1]);
+    }
+
+    suppressed.assign((n + 31) / 32, 0u);
+    uint32_t* mask = &suppressed[0];
+
+    if (use_grid) {
+        sweepGrid(class_ids, opt, n, keep);
+        return;
+    }
+
+    // 3. Greedy sweep: each kept box knocks out later overlapping boxes in one block pass
+    for (int i = 0; i < n; i++) {
+        if (is_set(mask, i)) continue;
+        keep.push_back(order[i]);
+        if (opt.max_detections > 0 && (int)keep.size() >= opt.max_detections) break;
+
+        int j = i + 1;
+#if HAVE_SIMD_LANES
+        j = suppress_block<SimdLanes>(x1[i], y1[i], x2[i], y2[i], area[i], opt.iou_threshold,
+                                      &x1[0], &y1[0], &x2[0], &y2[0], &area[0], mask, j, n);
+#endif
+        suppress_block<ScalarLanes>(x1[i], y1[i], x2[i], y2[i], area[i], opt.iou_threshold,
+                                    &x1[0], &y1[0], &x2[0], &y2[0], &area[0], mask, j, n);
+    }
+}
+
+// Greedy sweep over a uniform grid: each kept box only tests the later boxes it actually
+// intersects, so boxes on opposite sides of the frame are never compared.
+void NmsEngine::sweepGrid(const std::vector<int>& class_ids, const NmsOptions& opt, int n, std::vector<int>& keep) {
+    uint32_t* mask = &suppressed[0];
+    grid.build(&x1[0], &y1[0], &x2[0], &y2[0], n);
+
+    for (int i = 0; i < n; i++) {
+        if (is_set(mask, i)) continue;
+        keep.push_back(order[i]);
+        if (opt.max_detections > 0 && (int)keep.size() >= opt.max_detections) break;
+
+        neighbours.clear();
+        grid.query(x1[i], y1[i], x2[i], y2[i], neighbours);
+        for (int j : neighbours) {
+            if (j <= i || is_set(mask, j)) continue;
+            if (opt.class_aware && class_ids[order[j]] != class_ids[order[i]]) continue;
+            float iw = std::min(x2[i], x2[j]) - std::max(x1[i], x1[j]);
+            float ih = std::min(y2[i], y2[j]) - std::max(y1[i], y1[j]);
+            float inter = iw * ih; // positive: the grid only reports intersecting boxes
+            if (inter > opt.iou_threshold * (area[i] + area[j] - inter)) set_bit(mask, j);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Keeps the cell count near the box count so build and query stay linear
+const int CELLS_PER_BOX = 4;
+// Boxes wider or taller than this many cells go to the oversize list
+const float OVERSIZE_CELLS = 2.0f;
+
+} // namespace
+
+int SpatialGrid::cellOf(float v, float origin, int cells) const {
+    // max(0, x) first so NaN coordinates land in cell 0 instead of an undefined cast
+    return (int)std::min(std::max(0.0f, (v - origin) * inv_cell), (float)(cells - 1));
+}
+
+void SpatialGrid::build(const float* x1, const float* y1, const float* x2, const float* y2, int count) {
+    bx1.assign(x1, x1 + count);
+    by1.assign(y1, y1 + count);
+    bx2.assign(x2, x2 + count);
+    by2.assign(y2, y2 + count);
+    oversize.clear();
+
+    if (count == 0) {
+        grid_w = grid_h = 0;
+        cell_start.assign(1, 0);
+        cell_items.clear();
+        return;
+    }
+
+    float min_x = x1[0], min_y = y1[0], max_x = x2[0], max_y = y2[0];
+    double sum_extent = 0.0;
+    for (int i = 0; i < count; i++) {
+        min_x = std::min(min_x, x1[i]);
+        min_y = std::min(min_y, y1[i]);
+        max_x = std::max(max_x, x2[i]);
+        max_y = std::max(max_y, y2[i]);
+        sum_extent += std::max(x2[i] - x1[i], y2[i] - y1[i]);
+    }
+    float span_x = std::max(max_x - min_x, 1.0f);
+    float span_y = std::max(max_y - min_y, 1.0f);
+
+    // Cell about the size of a typical box, grown if the frame would need too many cells
+    float cell = std::max((float)(sum_extent / count), 1.0f);
+    float cells = (span_x / cell + 1.0f) * (span_y / cell + 1.0f);
+    float max_cells = (float)(CELLS_PER_BOX * count);
+    if (cells > max_cells) cell *= std::sqrt(cells / max_cells);
+
+    origin_x = min_x;
+    origin_y = min_y;
+    inv_cell = 1.0f / cell;
+    grid_w = std::max(1, (int)(span_x * inv_cell) + 1);
+    grid_h = std::max(1, (int)(span_y * inv_cell) + 1);
+
+    // Counting sort of boxes by the cell of their top-left corner
+    const float oversize_extent = OVERSIZE_CELLS * cell;
+    reach_w = 0.0f;
+    reach_h = 0.0f;
+    cell_start.assign(grid_w * grid_h + 1, 0);
+    for (int i = 0; i < count; i++) {
+        float w = x2[i] - x1[i];
+        float h = y2[i] - y1[i];
+        if (w > oversize_extent || h > oversize_extent) continue;
+        reach_w = std::max(reach_w, w);
+        reach_h = std::max(reach_h, h);
+        cell_start[cellOf(y1[i], origin_y, grid_h) * grid_w + cellOf(x1[i], origin_x, grid_w) + 1]++;
+    }
+    for (int c = 0; c < grid_w * grid_h; c++) cell_start[c + 1] += cell_start[c];
+
+    cell_items.resize(cell_start.back());
+    cursor.assign(cell_start.begin(), cell_start.end() - 1);
+    for (int i = 0; i < count; i++) {
+        if (x2[i] - x1[i] > oversize_extent || y2[i] - y1[i] > oversize_extent) {
+            oversize.push_back(i);
+            continue;
+        }
+        cell_items[cursor[cellOf(y1[i], origin_y, grid_h) * grid_w + cellOf(x1[i], origin_x, grid_w)]++] = i;
+    }
+}
+
+void SpatialGrid::query(float x1, float y1, float x2, float y2, std::vector<int>& out) const {
+    if (bx1.empty()) return;
+
+    // A box anchored above or left of the query can still reach into it by up to reach_w/h
+    const int cx0 = cellOf(x1 - reach_w, origin_x, grid_w);
+    const int cx1 = cellOf(x2, origin_x, grid_w);
+    const int cy0 = cellOf(y1 - reach_h, origin_y, grid_h);
+    const int cy1 = cellOf(y2, origin_y, grid_h);
+    for (int cy = cy0; cy <= cy1; cy++) {
+        const int row = cy * grid_w;
+        for (int k = cell_start[row + cx0]; k < cell_start[row + cx1 + 1]; k++) {
+            const int j = cell_items[k];
+            if (overlaps(j, x1, y1, x2, y2)) out.push_back(j);
+        }
+    }
+    for (int j : oversize) {
+        if (overlaps(j, x1, y1, x2, y2)) out.push_back(j);
+    }
+}
@@ -0,0 +1,249 @@
+// InputPreprocessor rotation: a buffer sampled at 90/180/270 degrees must give the same blob
+// as the explicitly rotated buffer sampled upright (host builds, ctest).
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "image_preprocess.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+namespace {
+
+// Written past the end of every plane: a sample read out of bounds shows up in the blob
+const unsigned char GUARD = 255;
+const int GUARD_BYTES = 64;
+
+struct Size {
+    int w;
+    int h;
+};
+
+// Odd sizes put partial chroma blocks on the reversed axes; targets both up- and downscale
+const Size SOURCES[] = { { 37, 23 }, { 21, 16 }, { 40, 30 }, { 3, 5 } };
+const Size TARGETS[] = { { 64, 48 }, { 16, 12 } };
+
+unsigned char pattern(int x, int y, int salt) {
+    return (unsigned char)((x * 37 + y * 101 + salt * 53 + ((x * y) ^ salt) * 7) % 251);
+}
+
+// Buffer pixel behind upright pixel (ux, uy) of a w x h buffer turned upright by rot
+void buffer_pixel(int w, int h, int rot, int ux, int uy, int& bx, int& by) {
+    switch (rot) {
+    case 90:
+        bx = uy;
+        by = h - 1 - ux;
+        break;
+    case 180:
+        bx = w - 1 - ux;
+        by = h - 1 - uy;
+        break;
+    case 270:
+        bx = w - 1 - uy;
+        by = ux;
+        break;
+    default:
+        bx = ux;
+        by = uy;
+        break;
+    }
+}
+
+InputTransform make_transform(int upright_w, int upright_h, const Size& target, bool letterbox, int rot) {
+    InputTransform tf = letterbox ? InputTransform::letterbox(upright_w, upright_h, target.w, target.w, 8, false)
+                                  : InputTransform::stretch(upright_w, upright_h, target.w, target.h);
+    tf.rotation = rot;
+    return tf;
+}
+
+bool same_blob(const ncnn::Mat& a, const ncnn::Mat& b) {
+    if (a.w != b.w || a.h != b.h || a.c != b.c) return false;
+    for (int c = 0; c < a.c; c++) {
+        for (int y = 0; y < a.h; y++) {
+            const float* ra = a.channel(c).row(y);
+            const float* rb = b.channel(c).row(y);
+            for (int x = 0; x < a.w; x++) {
+                if (std::fabs(ra[x] - rb[x]) > 1e-5f) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// A camera frame in its own layout: row padding on every plane and either planar (I420) or
+// interleaved (NV12) chroma
+struct YuvFrame {
+    std::vector<unsigned char> y_plane;
+    std::vector<unsigned char> uv_plane;
+    YUV420Image img;
+
+    YuvFrame(int w, int h, int uv_pixel_stride) {
+        const int cw = (w + 1) / 2;
+        const int ch = (h + 1) / 2;
+        img.width = w;
+        img.height = h;
+        img.y_row_stride = w + 3;
+        img.uv_pixel_stride = uv_pixel_stride;
+        img.uv_row_stride = cw * uv_pixel_stride + 5;
+        y_plane.assign((size_t)img.y_row_stride * h + GUARD_BYTES, GUARD);
+        // Planar: U rows then V rows in one allocation. Interleaved: V is U shifted by one byte.
+        const size_t uv_bytes = (size_t)img.uv_row_stride * ch;
+        uv_plane.assign((uv_pixel_stride == 1 ? 2 * uv_bytes : uv_bytes) + GUARD_BYTES, GUARD);
+        img.y = &y_plane[0];
+        img.u = &uv_plane[0];
+        img.v = uv_pixel_stride == 1 ? &uv_plane[uv_bytes] : &uv_plane[1];
+    }
+
+    unsigned char& y(int x, int yy) { return y_plane[(size_t)yy * img.y_row_stride + x]; }
+    unsigned char& u(int cx, int cy) {
+        return uv_plane[(img.u - &uv_plane[0]) + (size_t)cy * img.uv_row_stride + (size_t)cx * img.uv_pixel_stride];
+    }
+    unsigned char& v(int cx, int cy) {
+        return uv_plane[(img.v - &uv_plane[0]) + (size_t)cy * img.uv_row_stride + (size_t)cx * img.uv_pixel_stride];
+    }
+};
+
+// On a reversed axis of odd length the chroma pairs of the buffer and of the upright image
+// straddle different luma pixels, so no 4:2:0 upright buffer holds the same samples. Chroma
+// is kept constant along such an axis; everywhere else it varies per sample.
+void check_yuv(const Size& src, int rot, int uv_pixel_stride) {
+    const bool x_reversed = rot == 180 || rot == 270;
+    const bool y_reversed = rot == 90 || rot == 180;
+    const bool vary_x = !(x_reversed && src.w % 2);
+    const bool vary_y = !(y_reversed && src.h % 2);
+
+    YuvFrame frame(src.w, src.h, uv_pixel_stride);
+    for (int y = 0; y < src.h; y++) {
+        for (int x = 0; x < src.w; x++) frame.y(x, y) = pattern(x, y, 1);
+    }
+    for (int cy = 0; cy < (src.h + 1) / 2; cy++) {
+        for (int cx = 0; cx < (src.w + 1) / 2; cx++) {
+            frame.u(cx, cy) = pattern(vary_x ? cx : 0, vary_y ? cy : 0, 2);
+            frame.v(cx, cy) = pattern(vary_x ? cx : 0, vary_y ? cy : 0, 3);
+        }
+    }
+
+    const int uw = InputTransform::uprightWidth(src.w, src.h, rot);
+    const int uh = InputTransform::uprightHeight(src.w, src.h, rot);
+    YuvFrame upright(uw, uh, 1);
+    for (int uy = 0; uy < uh; uy++) {
+        for (int ux = 0; ux < uw; ux++) {
+            int bx, by;
+            buffer_pixel(src.w, src.h, rot, ux, uy, bx, by);
+            upright.y(ux, uy) = frame.y(bx, by);
+            if (ux % 2 == 0 && uy % 2 == 0) {
+                upright.u(ux / 2, uy / 2) = frame.u(bx / 2, by / 2);
+                upright.v(ux / 2, uy / 2) = frame.v(bx / 2, by / 2);
+            }
+        }
+    }
+
+    for (const Size& target : TARGETS) {
+        for (int letterbox = 0; letterbox < 2; letterbox++) {
+            InputPreprocessor rotated, reference;
+            ncnn::Mat rotated_blob, reference_blob;
+            rotated.fromYUV420(frame.img, rotated_blob, make_transform(uw, uh, target, letterbox != 0, rot));
+            reference.fromYUV420(upright.img, reference_blob, make_transform(uw, uh, target, letterbox != 0, 0));
+            if (!same_blob(rotated_blob, reference_blob)) {
+                fprintf(stderr, "YUV %dx%d rot %d uv_pixel_stride %d -> %dx%d%s differs\n", src.w, src.h, rot,
+                        uv_pixel_stride, target.w, target.h, letterbox ? " letterboxed" : "");
+                g_failures++;
+            }
+        }
+    }
+}
+
+void check_rgba(const Size& src, int rot) {
+    const int stride = src.w * 4 + 12;
+    std::vector<unsigned char> frame((size_t)stride * src.h + GUARD_BYTES, GUARD);
+    for (int y = 0; y < src.h; y++) {
+        for (int x = 0; x < src.w; x++) {
+            for (int c = 0; c < 4; c++) frame[(size_t)y * stride + x * 4 + c] = pattern(x, y, c);
+        }
+    }
+
+    const int uw = InputTransform::uprightWidth(src.w, src.h, rot);
+    const int uh = InputTransform::uprightHeight(src.w, src.h, rot);
+    const int upright_stride = uw * 4;
+    std::vector<unsigned char> upright((size_t)upright_stride * uh + GUARD_BYTES, GUARD);
+    for (int uy = 0; uy < uh; uy++) {
+        for (int ux = 0; ux < uw; ux++) {
+            int bx, by;
+            buffer_pixel(src.w, src.h, rot, ux, uy, bx, by);
+            for (int c = 0; c < 4; c++) {
+                upright[(size_t)uy * upright_stride + ux * 4 + c] = frame[(size_t)by * stride + bx * 4 + c];
+            }
+        }
+    }
+
+    for (const Size& target : TARGETS) {
+        for (int letterbox = 0; letterbox < 2; letterbox++) {
+            InputPreprocessor rotated, reference;
+            ncnn::Mat rotated_blob, reference_blob;
+            rotated.fromRGBA(&frame[0], stride, rotated_blob, make_transform(uw, uh, target, letterbox != 0, rot));
+            reference.fromRGBA(&upright[0], upright_stride, reference_blob,
+                               make_transform(uw, uh, target, letterbox != 0, 0));
+            if (!same_blob(rotated_blob, reference_blob)) {
+                fprintf(stderr, "RGBA %dx%d rot %d -> %dx%d%s differs\n", src.w, src.h, rot, target.w, target.h,
+                        letterbox ? " letterboxed" : "");
+                g_failures++;
+            }
+        }
+    }
+}
+
+void test_rotations_match_rotated_buffer() {
+    const int rotations[] = { 0, 90, 180, 270 };
+    for (const Size& src : SOURCES) {
+        for (int rot : rotations) {
+            check_yuv(src, rot, 1);
+            check_yuv(src, rot, 2);
+            check_rgba(src, rot);
+        }
+    }
+}
+
+// The same preprocessor switching rotation between frames rebuilds its tables
+void test_tables_follow_rotation() {
+    const Size src = { 37, 23 };
+    InputPreprocessor shared;
+    YuvFrame frame(src.w, src.h, 2);
+    for (int y = 0; y < src.h; y++) {
+        for (int x = 0; x < src.w; x++) frame.y(x, y) = pattern(x, y, 1);
+    }
+    for (int cy = 0; cy < (src.h + 1) / 2; cy++) {
+        for (int cx = 0; cx < (src.w + 1) / 2; cx++) frame.u(cx, cy) = frame.v(cx, cy) = 128;
+    }
+    const int rotations[] = { 90, 0, 270, 180, 90 };
+    for (int rot : rotations) {
+        const int uw = InputTransform::uprightWidth(src.w, src.h, rot);
+        const int uh = InputTransform::uprightHeight(src.w, src.h, rot);
+        const InputTransform tf = make_transform(uw, uh, TARGETS[0], true, rot);
+        InputPreprocessor fresh;
+        ncnn::Mat shared_blob, fresh_blob;
+        shared.fromYUV420(frame.img, shared_blob, tf);
+        fresh.fromYUV420(frame.img, fresh_blob, tf);
+        CHECK(same_blob(shared_blob, fresh_blob));
+    }
+}
+
+} // namespace
+
+int main() {
+    test_rotations_match_rotated_buffer();
+    test_tables_follow_rotation();
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("image_preprocess_test: all passed\n");
+    return 0;
+}
@@ -0,0 +1,313 @@
+// JpegDecoder on small embedded frames against reference planes (host builds, ctest).
+//
+// The frames are a 35x19 synthetic image (partial MCUs on both axes) encoded by libjpeg with
+// its standard Huffman tables. The references are FNV-1a sums of the planes this decoder
+// produced when they were generated; those planes were checked against libjpeg's ISLOW raw
+// output at the same time: identical at scale 1, within one level at the reduced scales.
+
+#include <cstdio>
+#include <vector>
+#include "jpeg_decoder.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+namespace {
+
+// 4:2:0, restart interval of one MCU (five RST markers), DHT removed
+const unsigned char YCC420_RESTART_NO_DHT[568] = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+    0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x08, 0x06, 0x06, 0x07, 0x06, 0x05, 0x08,
+    0x07, 0x07, 0x07, 0x09, 0x09, 0x08, 0x0a, 0x0c, 0x14, 0x0d, 0x0c, 0x0b, 0x0b, 0x0c, 0x19, 0x12,
+    0x13, 0x0f, 0x14, 0x1d, 0x1a, 0x1f, 0x1e, 0x1d, 0x1a, 0x1c, 0x1c, 0x20, 0x24, 0x2e, 0x27, 0x20,
+    0x22, 0x2c, 0x23, 0x1c, 0x1c, 0x28, 0x37, 0x29, 0x2c, 0x30, 0x31, 0x34, 0x34, 0x34, 0x1f, 0x27,
+    0x39, 0x3d, 0x38, 0x32, 0x3c, 0x2e, 0x33, 0x34, 0x32, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x09, 0x09,
+    0x09, 0x0c, 0x0b, 0x0c, 0x18, 0x0d, 0x0d, 0x18, 0x32, 0x21, 0x1c, 0x21, 0x32, 0x32, 0x32, 0x32,
+    0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+    0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32,
+    0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0x32, 0xff, 0xc0,
+    0x00, 0x11, 0x08, 0x00, 0x13, 0x00, 0x23, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+    0x01, 0xff, 0xdd, 0x00, 0x04, 0x00, 0x01, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11,
+    0x03, 0x11, 0x00, 0x3f, 0x00, 0xf3, 0x9b, 0x4d, 0x17, 0xfb, 0x3b, 0x12, 0xff, 0x00, 0xac, 0xcf,
+    0xcb, 0x8c, 0x63, 0xdf, 0xfa, 0x56, 0xe5, 0xae, 0x8d, 0xe7, 0x11, 0x79, 0x8c, 0x63, 0xe6, 0xd9,
+    0x8f, 0x4f, 0x7f, 0xc2, 0xb6, 0xad, 0x34, 0x6f, 0xb0, 0xe2, 0x5f, 0xbf, 0x9f, 0x97, 0x18, 0xc7,
+    0xf9, 0xe9, 0x5b, 0x96, 0xba, 0x3f, 0x9a, 0x45, 0xde, 0x31, 0xfc, 0x5b, 0x71, 0xe9, 0xef, 0xf8,
+    0x56, 0xd5, 0x33, 0x34, 0x97, 0x25, 0xac, 0x96, 0xbc, 0xb7, 0xdb, 0xce, 0xfd, 0x7d, 0x0e, 0x5c,
+    0x2e, 0x67, 0xd3, 0xf0, 0xfd, 0x6e, 0x7f, 0xff, 0xd0, 0xa1, 0x6b, 0xa5, 0xfd, 0xbf, 0x1f, 0x2f,
+    0x97, 0xb3, 0xf1, 0xce, 0x7f, 0xfd, 0x55, 0x66, 0xf7, 0x4e, 0xf2, 0xc4, 0x17, 0x1b, 0x33, 0xf6,
+    0x4c, 0xae, 0xdf, 0xef, 0xe7, 0x0b, 0xf8, 0x57, 0x5b, 0x6b, 0xa5, 0xfd, 0xb7, 0x1f, 0x2e, 0xcd,
+    0x9f, 0x8e, 0x73, 0xff, 0x00, 0xea, 0xab, 0x37, 0xba, 0x77, 0x94, 0x20, 0xba, 0xd9, 0x9f, 0xb2,
+    0x64, 0x6d, 0xfe, 0xfe, 0xec, 0x2f, 0x5e, 0xd5, 0x9a, 0xcd, 0xaf, 0x52, 0xf7, 0xdf, 0x7f, 0x3f,
+    0x2f, 0x2b, 0xed, 0x7f, 0x99, 0xd7, 0x88, 0xcd, 0x3f, 0xd9, 0x65, 0x2b, 0xf6, 0x77, 0xf4, 0x69,
+    0xde, 0xdf, 0xdd, 0xb5, 0xed, 0xd6, 0xd6, 0xea, 0x7f, 0xff, 0xd1, 0x89, 0x6f, 0x3e, 0x51, 0xfe,
+    0x87, 0xff, 0x00, 0x8f, 0xff, 0x00, 0xf5, 0xa8, 0xae, 0xd9, 0x6f, 0xfe, 0x51, 0xfe, 0x85, 0xff,
+    0x00, 0x91, 0x3f, 0xfa, 0xd4, 0x54, 0xfd, 0x7a, 0x1f, 0xf3, 0xeb, 0xff, 0x00, 0x26, 0x39, 0xd7,
+    0x12, 0x7f, 0xd4, 0x77, 0xfe, 0x53, 0xff, 0x00, 0x80, 0x7f, 0xff, 0xd2, 0xd6, 0xd1, 0xe2, 0x4f,
+    0x38, 0xfc, 0xa3, 0xee, 0xff, 0x00, 0x51, 0x5b, 0xb0, 0xc6, 0x9f, 0x6e, 0x1f, 0x28, 0xfb, 0xcb,
+    0xfd, 0x28, 0xa2, 0xbe, 0x52, 0x4d, 0xf2, 0x23, 0xe1, 0x70, 0x8d, 0xfb, 0x28, 0xfa, 0x9f, 0xff,
+    0xd3, 0xd9, 0xf8, 0x8d, 0xae, 0x6a, 0x3a, 0x11, 0xd2, 0x7f, 0xb3, 0x6e, 0x04, 0x1e, 0x77, 0x9d,
+    0xe6, 0x7e, 0xed, 0x5b, 0x38, 0xd9, 0x8f, 0xbc, 0x0f, 0xa9, 0xae, 0x0e, 0xfb, 0xc4, 0xda, 0xe5,
+    0xce, 0xb3, 0xa5, 0xcd, 0x26, 0xad, 0x78, 0x19, 0x84, 0x99, 0x11, 0xca, 0x63, 0x5f, 0xb8, 0x07,
+    0x0a, 0xb8, 0x03, 0xf0, 0x14, 0x51, 0x4b, 0x27, 0xa3, 0x4d, 0xe1, 0xe1, 0x37, 0x15, 0x77, 0xcd,
+    0xad, 0xb5, 0xea, 0x7d, 0x0e, 0x55, 0x87, 0xa2, 0xf2, 0xe8, 0xd4, 0x70, 0x5c, 0xcd, 0xc7, 0x5b,
+    0x2b, 0xff, 0x00, 0x11, 0x75, 0x3f, 0xff, 0xd4, 0xc3, 0x58, 0x93, 0x68, 0xf9, 0x45, 0x14, 0x51,
+    0x5e, 0xa5, 0xd9, 0xfa, 0xb2, 0x6c, 0xff, 0xd9,
+};
+
+// 4:2:2
+const unsigned char YCC422[1282] = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+    0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x03, 0x02, 0x02, 0x03, 0x02, 0x02, 0x03,
+    0x03, 0x03, 0x03, 0x04, 0x03, 0x03, 0x04, 0x05, 0x08, 0x05, 0x05, 0x04, 0x04, 0x05, 0x0a, 0x07,
+    0x07, 0x06, 0x08, 0x0c, 0x0a, 0x0c, 0x0c, 0x0b, 0x0a, 0x0b, 0x0b, 0x0d, 0x0e, 0x12, 0x10, 0x0d,
+    0x0e, 0x11, 0x0e, 0x0b, 0x0b, 0x10, 0x16, 0x10, 0x11, 0x13, 0x14, 0x15, 0x15, 0x15, 0x0c, 0x0f,
+    0x17, 0x18, 0x16, 0x14, 0x18, 0x12, 0x14, 0x15, 0x14, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x03, 0x04,
+    0x04, 0x05, 0x04, 0x05, 0x09, 0x05, 0x05, 0x09, 0x14, 0x0d, 0x0b, 0x0d, 0x14, 0x14, 0x14, 0x14,
+    0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+    0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+    0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0xff, 0xc0,
+    0x00, 0x11, 0x08, 0x00, 0x13, 0x00, 0x23, 0x03, 0x01, 0x21, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+    0x01, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+    0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+    0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+    0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23,
+    0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+    0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+    0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+    0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+    0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5,
+    0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1,
+    0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xc4, 0x00, 0x1f, 0x01, 0x00, 0x03,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x11, 0x00,
+    0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+    0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+    0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15,
+    0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27,
+    0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+    0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6,
+    0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4,
+    0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9,
+    0xfa, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xf9,
+    0x17, 0xc3, 0xdf, 0x0c, 0x7f, 0xe1, 0x0d, 0x2b, 0x7a, 0x07, 0xdb, 0x3c, 0xcf, 0xdc, 0xec, 0xdb,
+    0xb3, 0x19, 0xe7, 0x39, 0xe7, 0xfb, 0xbf, 0xad, 0x7a, 0x4e, 0x81, 0xf0, 0xd3, 0xfb, 0x45, 0x97,
+    0x5d, 0xc7, 0x96, 0x47, 0xef, 0x7e, 0xcf, 0xb7, 0x3f, 0x73, 0x8c, 0x6e, 0xf7, 0xdb, 0xe9, 0xde,
+    0xbf, 0x4a, 0xc4, 0xe3, 0x15, 0x08, 0xff, 0x00, 0x64, 0xf3, 0xdd, 0x52, 0x7e, 0xd3, 0x9b, 0xbf,
+    0x95, 0xaf, 0xa6, 0xfb, 0xdd, 0xfa, 0x1e, 0xa6, 0x51, 0x98, 0xda, 0xd8, 0x7e, 0x6f, 0x87, 0xde,
+    0xbf, 0xe8, 0x7a, 0x56, 0x85, 0xe0, 0x3f, 0xf8, 0x4b, 0x76, 0x66, 0x2f, 0xb2, 0x7d, 0x9f, 0xdb,
+    0x7e, 0xed, 0xdf, 0x96, 0x3e, 0xef, 0xeb, 0x5a, 0xfe, 0x27, 0xf0, 0x6f, 0xd8, 0x97, 0x4c, 0xd4,
+    0xfc, 0x8d, 0xe3, 0x42, 0xf3, 0x22, 0xf2, 0xba, 0x79, 0xfb, 0xf6, 0xc7, 0x9c, 0xff, 0x00, 0x0e,
+    0x31, 0x9e, 0x86, 0xbc, 0x18, 0x67, 0x9e, 0xdb, 0x13, 0xed, 0xb6, 0xf6, 0xf7, 0x85, 0xbf, 0x97,
+    0x99, 0x72, 0x5f, 0xce, 0xd7, 0xbd, 0xb4, 0xed, 0x7e, 0xa7, 0xe8, 0x39, 0x96, 0x73, 0x6c, 0x9e,
+    0xae, 0x3a, 0xfb, 0x72, 0xd4, 0xb7, 0xfd, 0x79, 0x9c, 0x6a, 0x5a, 0xff, 0x00, 0xde, 0xe4, 0xb5,
+    0xed, 0xa5, 0xef, 0x67, 0x6b, 0x37, 0xc1, 0xe2, 0x31, 0xe5, 0x2f, 0xfc, 0x49, 0x3b, 0x7f, 0xcf,
+    0xc7, 0xff, 0x00, 0x61, 0x45, 0x6c, 0xf2, 0x68, 0xdf, 0xfd, 0xe7, 0xff, 0x00, 0x25, 0xff, 0x00,
+    0xed, 0x8f, 0x87, 0x5e, 0x39, 0x68, 0xbf, 0xd8, 0xbf, 0xf2, 0xa7, 0xff, 0x00, 0x73, 0x30, 0xbc,
+    0x3d, 0xf0, 0xd3, 0xfe, 0x11, 0x42, 0xb7, 0x60, 0x7d, 0xab, 0x7f, 0xee, 0xb6, 0x6d, 0xd9, 0x8c,
+    0xf3, 0x9c, 0xf3, 0xfd, 0xdf, 0xd6, 0xbd, 0x27, 0x41, 0xf8, 0x6d, 0xf6, 0xe6, 0x5d, 0x67, 0x6e,
+    0xc2, 0x3f, 0x7b, 0xe4, 0xed, 0xcf, 0xdc, 0xed, 0xbb, 0xdf, 0x6f, 0xa7, 0x7a, 0xfc, 0xa3, 0x15,
+    0x98, 0x2a, 0x31, 0xfa, 0x8f, 0x35, 0xd4, 0x3d, 0xeb, 0xf7, 0xf2, 0xb7, 0xcf, 0x7b, 0xfc, 0x8f,
+    0xc3, 0xf2, 0x8c, 0xc6, 0xd6, 0xc3, 0x73, 0x7c, 0x3e, 0xf5, 0xff, 0x00, 0x4b, 0x7e, 0xa7, 0xa5,
+    0x68, 0x5e, 0x03, 0xff, 0x00, 0x84, 0x9b, 0x66, 0x62, 0xfb, 0x37, 0x91, 0xed, 0xbf, 0x76, 0x7f,
+    0x2f, 0x4a, 0xd7, 0xf1, 0x3f, 0x82, 0xff, 0x00, 0xb3, 0xd7, 0x4c, 0xd6, 0x3c, 0x8f, 0x30, 0x68,
+    0x7e, 0x64, 0x7e, 0x4f, 0x4f, 0x3f, 0xcc, 0xdb, 0x1e, 0x77, 0x7f, 0x0e, 0x3a, 0xf4, 0x39, 0xe9,
+    0x5e, 0x0c, 0x33, 0xaf, 0x69, 0x89, 0xbd, 0xfe, 0x3b, 0xc7, 0xd3, 0x99, 0x72, 0xdf, 0xce, 0xd7,
+    0xb9, 0xfa, 0x16, 0x65, 0x9c, 0xff, 0x00, 0xc2, 0x3d, 0x5c, 0x75, 0xf6, 0xe5, 0xa9, 0x6f, 0xfa,
+    0xf3, 0x38, 0xd4, 0xb5, 0xff, 0x00, 0xbd, 0xc9, 0x6b, 0xdb, 0xdd, 0xbd, 0xec, 0xed, 0x66, 0xf8,
+    0x3c, 0x5a, 0x04, 0x2b, 0xff, 0x00, 0x12, 0x2e, 0xdf, 0xf3, 0xf3, 0xff, 0x00, 0xd8, 0x51, 0x5b,
+    0x7b, 0x18, 0xff, 0x00, 0xcf, 0xef, 0xc3, 0xfe, 0x09, 0xf0, 0xcb, 0xc6, 0xfd, 0x17, 0xfb, 0x17,
+    0xfe, 0x54, 0xff, 0x00, 0xed, 0x0f, 0x38, 0xf8, 0x6d, 0x63, 0x07, 0xdb, 0xdb, 0xf7, 0x4b, 0xfe,
+    0xa8, 0xff, 0x00, 0x31, 0x5e, 0x97, 0xa6, 0xd9, 0x41, 0xff, 0x00, 0x09, 0x1a, 0x7e, 0xe9, 0x7f,
+    0xd6, 0x47, 0xfc, 0x85, 0x7e, 0x7b, 0x52, 0xac, 0xfe, 0xaf, 0x15, 0x7e, 0xa7, 0xe3, 0xf9, 0x3d,
+    0x59, 0xfd, 0x52, 0x96, 0xbf, 0x6d, 0x1e, 0x75, 0xfb, 0x68, 0xfc, 0x53, 0xf1, 0x3f, 0xc2, 0x83,
+    0xe0, 0x5f, 0xf8, 0x45, 0x75, 0x25, 0xd2, 0xfe, 0xdf, 0xf6, 0xef, 0xb4, 0xff, 0x00, 0xa3, 0x43,
+    0x37, 0x99, 0xb3, 0xec, 0xfb, 0x3f, 0xd6, 0x23, 0x63, 0x1b, 0xdb, 0xa6, 0x3a, 0xfd, 0x2b, 0xe5,
+    0xff, 0x00, 0x15, 0xfc, 0x71, 0xf8, 0x83, 0xae, 0x78, 0xfb, 0xc1, 0x37, 0xb7, 0x3e, 0x33, 0xd6,
+    0xe3, 0x9a, 0x54, 0xb9, 0xdc, 0x96, 0x77, 0xaf, 0x6b, 0x10, 0xc4, 0x08, 0x06, 0xd8, 0xe2, 0x2a,
+    0x8b, 0xc0, 0x19, 0xc0, 0x19, 0x39, 0x27, 0x92, 0x4d, 0x7e, 0xe1, 0xc1, 0x99, 0x2e, 0x5d, 0x5f,
+    0x01, 0x43, 0x1d, 0x5a, 0x8a, 0x9d, 0x49, 0xaa, 0xa9, 0xb9, 0x7b, 0xcb, 0x4e, 0x74, 0xbd, 0xd7,
+    0x78, 0xa7, 0x64, 0xb5, 0x4a, 0xff, 0x00, 0x7b, 0x3f, 0xbf, 0x78, 0x4b, 0x87, 0x32, 0x9c, 0x4f,
+    0x0e, 0xc7, 0x31, 0xc4, 0x61, 0xe3, 0x3a, 0xb3, 0x9d, 0x14, 0xdc, 0xbd, 0xe5, 0xa6, 0x2a, 0x9a,
+    0x5e, 0xec, 0xaf, 0x14, 0xec, 0x92, 0xba, 0x49, 0xf9, 0xea, 0xef, 0xa7, 0x05, 0x8c, 0x1e, 0x4a,
+    0xfe, 0xe9, 0x7a, 0x51, 0x5f, 0xa7, 0x7b, 0x49, 0xf7, 0x3f, 0xac, 0x55, 0x59, 0xd9, 0x6a, 0x7f,
+    0xff, 0xd9,
+};
+
+// Greyscale
+const unsigned char GRAY[502] = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+    0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x0d, 0x09, 0x0a, 0x0b, 0x0a, 0x08, 0x0d,
+    0x0b, 0x0a, 0x0b, 0x0e, 0x0e, 0x0d, 0x0f, 0x13, 0x20, 0x15, 0x13, 0x12, 0x12, 0x13, 0x27, 0x1c,
+    0x1e, 0x17, 0x20, 0x2e, 0x29, 0x31, 0x30, 0x2e, 0x29, 0x2d, 0x2c, 0x33, 0x3a, 0x4a, 0x3e, 0x33,
+    0x36, 0x46, 0x37, 0x2c, 0x2d, 0x40, 0x57, 0x41, 0x46, 0x4c, 0x4e, 0x52, 0x53, 0x52, 0x32, 0x3e,
+    0x5a, 0x61, 0x5a, 0x50, 0x60, 0x4a, 0x51, 0x52, 0x4f, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00, 0x13,
+    0x00, 0x23, 0x01, 0x01, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+    0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00, 0x02, 0x01, 0x03,
+    0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00,
+    0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32,
+    0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35,
+    0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55,
+    0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94,
+    0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2,
+    0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+    0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6,
+    0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xda,
+    0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3f, 0x00, 0xe5, 0x20, 0xd3, 0xfe, 0xcb, 0xf3, 0xfd, 0xfc,
+    0xf1, 0x8c, 0x62, 0xb4, 0x60, 0xb0, 0xdf, 0x8b, 0x8e, 0x9d, 0xf6, 0xe3, 0xd2, 0xb4, 0x60, 0xb3,
+    0xfb, 0x4e, 0x38, 0xdb, 0xb7, 0xf1, 0xa9, 0x6e, 0x6d, 0x76, 0x79, 0x72, 0xed, 0xcf, 0xd9, 0xf2,
+    0x31, 0xfd, 0xec, 0xe0, 0x7e, 0x14, 0xa2, 0x7e, 0x07, 0xee, 0x3f, 0xf1, 0xef, 0xfe, 0xb5, 0x41,
+    0x05, 0x87, 0xd9, 0xbe, 0x7f, 0xbd, 0x9e, 0x31, 0x8c, 0x56, 0x8c, 0x16, 0x1b, 0xf1, 0x3f, 0x4e,
+    0xf8, 0xfa, 0x56, 0x8c, 0x16, 0x7f, 0x68, 0xc7, 0x1b, 0x76, 0xfe, 0x35, 0x35, 0xcd, 0xae, 0xcf,
+    0x2e, 0x7d, 0xb9, 0xfb, 0x3e, 0x46, 0x3f, 0xbd, 0x9c, 0x0f, 0xc2, 0x85, 0xb9, 0xe0, 0x7f, 0xa3,
+    0xff, 0x00, 0xe3, 0xdf, 0xfd, 0x6a, 0xcf, 0xd3, 0xd1, 0x7c, 0xce, 0x9d, 0xab, 0x46, 0x34, 0x5f,
+    0xb4, 0x8e, 0x3b, 0x8a, 0xcf, 0xf1, 0x76, 0xa3, 0x77, 0xa7, 0x7d, 0x8b, 0xec, 0x52, 0xf9, 0x7e,
+    0x66, 0xfd, 0xdf, 0x28, 0x39, 0xc6, 0xdc, 0x75, 0x1e, 0xe6, 0xb9, 0xab, 0xad, 0x5f, 0x52, 0x9b,
+    0x50, 0xb2, 0x91, 0xef, 0xae, 0x01, 0x21, 0xb8, 0x47, 0x2a, 0x3e, 0xe8, 0xec, 0x30, 0x2a, 0x55,
+    0x45, 0xc0, 0xe0, 0x57, 0xff, 0xd9,
+};
+
+struct Reference {
+    int scale;
+    int width;
+    int height;
+    uint32_t y_sum;
+    uint32_t u_sum;
+    uint32_t v_sum;
+};
+
+const Reference YCC420_RESTART_NO_DHT_REF[4] = {
+    { 1, 35, 19, 0x9bbf290au, 0xe1f37b6fu, 0x9d90d60cu },
+    { 2, 18, 10, 0xe377b21du, 0xa2730ef6u, 0xc9136b0bu },
+    { 4, 9, 5, 0xcd3e73bcu, 0x14b502feu, 0xc3f14a56u },
+    { 8, 5, 3, 0x9fdde3bau, 0xa86e35eeu, 0xbb62489cu },
+};
+
+const Reference YCC422_REF[4] = {
+    { 1, 35, 19, 0xd8581b7eu, 0xb21f7ee3u, 0x487b55c4u },
+    { 2, 18, 10, 0xa67d717cu, 0x574e15c7u, 0x450220f5u },
+    { 4, 9, 5, 0x2cca8a55u, 0xeb3d0a96u, 0x3537177bu },
+    { 8, 5, 3, 0x62ee8ac1u, 0x6dfff22fu, 0x3c45bf53u },
+};
+
+const Reference GRAY_REF[4] = {
+    { 1, 35, 19, 0x7772ca3bu, 0xe76449d5u, 0xe76449d5u },
+    { 2, 18, 10, 0xe6e31445u, 0xdf7269efu, 0xdf7269efu },
+    { 4, 9, 5, 0xf2664973u, 0x45d90a87u, 0x45d90a87u },
+    { 8, 5, 3, 0x997bc7b8u, 0xdf4e319du, 0xdf4e319du },
+};
+
+uint32_t fnv1a(uint32_t h, unsigned char b) {
+    return (h ^ b) * 16777619u;
+}
+
+// Sums the samples the detector reads: every luma pixel and the half-resolution chroma grid
+void plane_sums(const YUV420Image& img, uint32_t& y_sum, uint32_t& u_sum, uint32_t& v_sum) {
+    y_sum = u_sum = v_sum = 2166136261u;
+    for (int y = 0; y < img.height; y++) {
+        for (int x = 0; x < img.width; x++) y_sum = fnv1a(y_sum, img.y[(size_t)y * img.y_row_stride + x]);
+    }
+    for (int y = 0; y < (img.height + 1) / 2; y++) {
+        for (int x = 0; x < (img.width + 1) / 2; x++) {
+            const size_t i = (size_t)y * img.uv_row_stride + (size_t)x * img.uv_pixel_stride;
+            u_sum = fnv1a(u_sum, img.u[i]);
+            v_sum = fnv1a(v_sum, img.v[i]);
+        }
+    }
+}
+
+void check_frame(const char* name, const unsigned char* data, size_t size, const Reference* refs) {
+    JpegDecoder decoder;
+    CHECK(decoder.readHeader(data, size));
+    CHECK(decoder.width() == 35 && decoder.height() == 19);
+    for (int i = 0; i < 4; i++) {
+        YUV420Image img;
+        if (!decoder.decode(refs[i].scale, img)) {
+            fprintf(stderr, "%s: decode failed at scale %d\n", name, refs[i].scale);
+            g_failures++;
+            continue;
+        }
+        uint32_t y_sum, u_sum, v_sum;
+        plane_sums(img, y_sum, u_sum, v_sum);
+        const bool ok = img.width == refs[i].width && img.height == refs[i].height && y_sum == refs[i].y_sum &&
+                        u_sum == refs[i].u_sum && v_sum == refs[i].v_sum;
+        if (!ok) {
+            fprintf(stderr, "%s: scale %d gave %dx%d { 0x%08xu, 0x%08xu, 0x%08xu }\n", name, refs[i].scale, img.width,
+                    img.height, y_sum, u_sum, v_sum);
+            g_failures++;
+        }
+    }
+}
+
+void test_reference_planes() {
+    check_frame("4:2:0 restart", YCC420_RESTART_NO_DHT, sizeof(YCC420_RESTART_NO_DHT), YCC420_RESTART_NO_DHT_REF);
+    check_frame("4:2:2", YCC422, sizeof(YCC422), YCC422_REF);
+    check_frame("greyscale", GRAY, sizeof(GRAY), GRAY_REF);
+}
+
+// MJPEG demuxers may hand over a frame without its EOI; the entropy-coded data is complete
+void test_missing_eoi() {
+    check_frame("4:2:2 without EOI", YCC422, sizeof(YCC422) - 2, YCC422_REF);
+    check_frame("4:2:0 without EOI", YCC420_RESTART_NO_DHT, sizeof(YCC420_RESTART_NO_DHT) - 2, YCC420_RESTART_NO_DHT_REF);
+}
+
+// Every cut keeps the header, so only decode() can notice the scan ran out
+void test_truncated_scan_fails() {
+    const unsigned char* frames[3] = { YCC420_RESTART_NO_DHT, YCC422, GRAY };
+    const size_t sizes[3] = { sizeof(YCC420_RESTART_NO_DHT), sizeof(YCC422), sizeof(GRAY) };
+    for (int f = 0; f < 3; f++) {
+        const size_t cuts[3] = { sizes[f] - 3, sizes[f] - 12, sizes[f] * 3 / 4 }; // EOI and more
+        for (int c = 0; c < 3; c++) {
+            JpegDecoder decoder;
+            CHECK(decoder.readHeader(frames[f], cuts[c]));
+            for (int scale = 1; scale <= 8; scale *= 2) {
+                YUV420Image img;
+                CHECK(!decoder.decode(scale, img));
+            }
+        }
+    }
+}
+
+void test_oversized_frame_rejected() {
+    std::vector<unsigned char> frame(YCC422, YCC422 + sizeof(YCC422));
+    size_t i = 2;
+    while (i + 9 < frame.size() && frame[i + 1] != 0xC0) i += 2 + ((frame[i + 2] << 8) | frame[i + 3]);
+    CHECK(i + 9 < frame.size());
+    // SOF0: length, precision, height, width
+    frame[i + 5] = 8192 >> 8;
+    frame[i + 6] = 8192 & 0xFF;
+    JpegDecoder decoder;
+    CHECK(decoder.readHeader(&frame[0], frame.size()));
+    frame[i + 6] = 1; // 8193 high
+    CHECK(!decoder.readHeader(&frame[0], frame.size()));
+}
+
+} // namespace
+
+int main() {
+    test_reference_planes();
+    test_missing_eoi();
+    test_truncated_scan_fails();
+    test_oversized_frame_rejected();
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("jpeg_decoder_test: all passed\n");
+    return 0;
+}
@@ -0,0 +1,236 @@
+// SparseAssignment against exhaustive search and a dense Hungarian solver (host builds, ctest).
+
+#include <stdint.h>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "lap_assign.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+namespace {
+
+const float COST_LIMIT = 0.8f;
+const double FORBIDDEN = 1e6;
+
+// Deterministic across platforms, unlike rand()
+struct Rng {
+    uint32_t state;
+    explicit Rng(uint32_t seed) : state(seed) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    int below(int n) { return (int)(next() % (uint32_t)n); }
+    float unit() { return (next() >> 8) * (1.0f / 16777216.0f); }
+};
+
+struct Problem {
+    int rows;
+    int cols;
+    std::vector<float> cost; // rows x cols, < 0 where the pair is not gated
+};
+
+// Gated pairs cost below the limit, as ByteTracker only adds pairs above its IoU threshold
+Problem random_problem(Rng& rng, int rows, int cols, float density) {
+    Problem p;
+    p.rows = rows;
+    p.cols = cols;
+    p.cost.assign((size_t)rows * cols, -1.0f);
+    for (size_t k = 0; k < p.cost.size(); k++) {
+        if (rng.unit() < density) p.cost[k] = rng.unit() * COST_LIMIT;
+    }
+    return p;
+}
+
+// Like a tracker frame: rows and columns sit at positions on a line and only nearby pairs
+// are gated, so the edge graph falls apart into many components of varied size
+Problem clustered_problem(Rng& rng, int rows, int cols) {
+    Problem p;
+    p.rows = rows;
+    p.cols = cols;
+    p.cost.assign((size_t)rows * cols, -1.0f);
+    std::vector<float> row_pos(rows), col_pos(cols);
+    for (int i = 0; i < rows; i++) row_pos[i] = rng.unit() * 100.0f;
+    for (int j = 0; j < cols; j++) col_pos[j] = rng.unit() * 100.0f;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            const float d = std::fabs(row_pos[i] - col_pos[j]);
+            if (d < 2.0f) p.cost[(size_t)i * cols + j] = d / 2.0f * COST_LIMIT * 0.999f;
+        }
+    }
+    return p;
+}
+
+// Sum of (cost - limit) over the assignment, checking that it only uses gated pairs and
+// that the two directions agree; unassigned rows and columns contribute 0
+double solve_sparse(const Problem& p, SparseAssignment& solver, bool& valid) {
+    solver.reset(p.rows, p.cols);
+    for (int i = 0; i < p.rows; i++) {
+        for (int j = 0; j < p.cols; j++) {
+            if (p.cost[(size_t)i * p.cols + j] >= 0.0f) solver.add(i, j, p.cost[(size_t)i * p.cols + j]);
+        }
+    }
+    std::vector<int> row_to_col, col_to_row;
+    solver.solve(COST_LIMIT, row_to_col, col_to_row);
+
+    valid = (int)row_to_col.size() == p.rows && (int)col_to_row.size() == p.cols;
+    double total = 0.0;
+    for (int i = 0; valid && i < p.rows; i++) {
+        const int j = row_to_col[i];
+        if (j < 0) continue;
+        valid = j < p.cols && col_to_row[j] == i && p.cost[(size_t)i * p.cols + j] >= 0.0f;
+        if (valid) total += p.cost[(size_t)i * p.cols + j] - COST_LIMIT;
+    }
+    for (int j = 0; valid && j < p.cols; j++) {
+        valid = col_to_row[j] < 0 || row_to_col[col_to_row[j]] == j;
+    }
+    return total;
+}
+
+void brute_force(const Problem& p, int row, std::vector<char>& used, double total, double& best) {
+    if (row == p.rows) {
+        if (total < best) best = total;
+        return;
+    }
+    brute_force(p, row + 1, used, total, best); // row left unassigned
+    for (int j = 0; j < p.cols; j++) {
+        const float c = p.cost[(size_t)row * p.cols + j];
+        if (c < 0.0f || used[j]) continue;
+        used[j] = 1;
+        brute_force(p, row + 1, used, total + c - COST_LIMIT, best);
+        used[j] = 0;
+    }
+}
+
+// Minimum-cost perfect matching of a square matrix (Hungarian method with potentials)
+double hungarian(const std::vector<double>& a, int n) {
+    std::vector<double> u(n + 1, 0.0), v(n + 1, 0.0), minv(n + 1);
+    std::vector<int> p(n + 1, 0), way(n + 1, 0);
+    std::vector<char> used(n + 1);
+    for (int i = 1; i <= n; i++) {
+        p[0] = i;
+        int j0 = 0;
+        minv.assign(n + 1, 1e18);
+        used.assign(n + 1, 0);
+        do {
+            used[j0] = 1;
+            const int i0 = p[j0];
+            double delta = 1e18;
+            int j1 = 0;
+            for (int j = 1; j <= n; j++) {
+                if (used[j]) continue;
+                const double cur = a[(size_t)(i0 - 1) * n + (j - 1)] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            const int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+    double total = 0.0;
+    for (int j = 1; j <= n; j++) total += a[(size_t)(p[j] - 1) * n + (j - 1)];
+    return total;
+}
+
+// The extended square problem ByteTrack hands to lapjv: every row and column may instead
+// take a private dummy at cost_limit / 2. Shifted to the sparse solver's (cost - limit) sum.
+double solve_dense(const Problem& p) {
+    const int n = p.rows + p.cols;
+    std::vector<double> a((size_t)n * n, FORBIDDEN);
+    for (int i = 0; i < p.rows; i++) {
+        for (int j = 0; j < p.cols; j++) {
+            if (p.cost[(size_t)i * p.cols + j] >= 0.0f) a[(size_t)i * n + j] = p.cost[(size_t)i * p.cols + j];
+        }
+        a[(size_t)i * n + p.cols + i] = COST_LIMIT / 2.0;
+    }
+    for (int j = 0; j < p.cols; j++) {
+        a[(size_t)(p.rows + j) * n + j] = COST_LIMIT / 2.0;
+        for (int i = 0; i < p.rows; i++) a[(size_t)(p.rows + j) * n + p.cols + i] = 0.0;
+    }
+    return hungarian(a, n) - (p.rows + p.cols) * (COST_LIMIT / 2.0);
+}
+
+void test_matches_brute_force() {
+    Rng rng(12345);
+    SparseAssignment solver; // reused, as the tracker does
+    int mismatches = 0;
+    for (int t = 0; t < 3000; t++) {
+        const Problem p = random_problem(rng, rng.below(7), rng.below(7), 0.15f + 0.7f * rng.unit());
+        bool valid = false;
+        const double sparse = solve_sparse(p, solver, valid);
+        std::vector<char> used(p.cols, 0);
+        double best = 0.0;
+        brute_force(p, 0, used, 0.0, best);
+        if (!valid || std::fabs(sparse - best) > 1e-4) {
+            if (mismatches++ < 5) {
+                fprintf(stderr, "problem %d (%dx%d): sparse %f, optimum %f, valid %d\n", t, p.rows, p.cols, sparse,
+                        best, valid);
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+void test_matches_dense() {
+    Rng rng(777);
+    SparseAssignment solver;
+    int mismatches = 0;
+    for (int t = 0; t < 500; t++) {
+        const int rows = 1 + rng.below(120);
+        const int cols = 1 + rng.below(120);
+        const Problem p = t % 2 ? clustered_problem(rng, rows, cols)
+                                : random_problem(rng, rows, cols, 0.02f + 0.3f * rng.unit());
+        bool valid = false;
+        const double sparse = solve_sparse(p, solver, valid);
+        const double dense = solve_dense(p);
+        if (!valid || std::fabs(sparse - dense) > 1e-3) {
+            if (mismatches++ < 5) {
+                fprintf(stderr, "problem %d (%dx%d): sparse %f, dense %f, valid %d\n", t, rows, cols, sparse, dense,
+                        valid);
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+} // namespace
+
+int main() {
+    test_matches_brute_force();
+    test_matches_dense();
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("lap_assign_test: all passed\n");
+    return 0;
+}
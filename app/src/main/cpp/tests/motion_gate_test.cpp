@@ -0,0 +1,85 @@
+// MotionGate thresholds on synthetic luma frames (host builds, ctest).
+
+#include <cstdio>
+#include <vector>
+#include "motion_gate.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+namespace {
+
+// Four source pixels per thumbnail pixel and axis, so a 4x4 source block sets exactly one
+// thumbnail pixel
+const int WIDTH = MotionGate::THUMB_W * 4;
+const int HEIGHT = MotionGate::THUMB_H * 4;
+const int64_t FRAME_NS = 33000000;
+
+void set_cell(std::vector<unsigned char>& frame, int tx, int ty, unsigned char value) {
+    for (int y = ty * 4; y < ty * 4 + 4; y++) {
+        for (int x = tx * 4; x < tx * 4 + 4; x++) frame[(size_t)y * WIDTH + x] = value;
+    }
+}
+
+void test_static_scene_is_held() {
+    MotionGate gate;
+    gate.setEnabled(true, 1000);
+    std::vector<unsigned char> frame((size_t)WIDTH * HEIGHT, 100);
+    gate.sampleY(&frame[0], WIDTH, HEIGHT, WIDTH);
+    CHECK(gate.admit(0));
+    for (int i = 1; i < 20; i++) {
+        gate.sampleY(&frame[0], WIDTH, HEIGHT, WIDTH);
+        CHECK(!gate.admit(i * FRAME_NS));
+    }
+    // Staleness bound
+    gate.sampleY(&frame[0], WIDTH, HEIGHT, WIDTH);
+    CHECK(gate.admit(1000000000));
+}
+
+// One 8x6 block brightens by one luma level in one more thumbnail pixel per frame, so the
+// score climbs by 1/48 per frame. Every held frame feeds the noise estimate; without a
+// ceiling the threshold outran the score and the change was held until the stale bound.
+void test_slow_change_is_admitted() {
+    MotionGate gate;
+    gate.setEnabled(true, 60000);
+    std::vector<unsigned char> frame((size_t)WIDTH * HEIGHT, 100);
+    std::vector<unsigned char> level(48, 100);
+    gate.sampleY(&frame[0], WIDTH, HEIGHT, WIDTH);
+    CHECK(gate.admit(0));
+
+    int admitted_at = -1;
+    float admitted_score = 0.0f;
+    for (int i = 1; i < 1200 && admitted_at < 0; i++) {
+        const int cell = (i - 1) % 48;
+        set_cell(frame, cell % 8, cell / 8, ++level[cell]);
+        gate.sampleY(&frame[0], WIDTH, HEIGHT, WIDTH);
+        if (gate.admit(i * FRAME_NS)) {
+            admitted_at = i;
+            admitted_score = gate.lastScore();
+        }
+    }
+    CHECK(admitted_at > 0);
+    // Well before the 60 s stale bound, once the score clears the capped threshold
+    CHECK(admitted_at * FRAME_NS < 30000000000LL);
+    CHECK(admitted_score < 11.0f);
+}
+
+} // namespace
+
+int main() {
+    test_static_scene_is_held();
+    test_slow_change_is_admitted();
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("motion_gate_test: all passed\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+// YOLODetector::postprocess() on a synthetic end-to-end head: confidence threshold, class
+// filter and the inverse letterbox mapping (host builds, ctest).
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "yolo_detector.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+namespace {
+
+const int HEAD_ROWS = 300;
+const int INPUT_SIZE = 64;
+
+// A graph whose out0 is a 300x6 MemoryData blob, so the head probe in loadModel() sees the
+// shape of an NMS-free export. The Noop only consumes in0, which would otherwise be the
+// first unconsumed blob and taken for the output.
+const char PARAM[] =
+    "7767517\n"
+    "3 4\n"
+    "Input in0 0 1 in0 0=64 1=64 2=3\n"
+    "MemoryData head 0 1 head 0=6 1=300\n"
+    "Noop pass 2 2 head in0 out0 image\n";
+
+bool load_end2end_model(YOLODetector& detector) {
+    const std::vector<float> weights((size_t)HEAD_ROWS * 6, 0.0f);
+    const unsigned char* param_mem = (const unsigned char*)PARAM;
+    const unsigned char* bin_mem = (const unsigned char*)&weights[0];
+    ncnn::DataReaderFromMemory param_reader(param_mem);
+    ncnn::DataReaderFromMemory bin_reader(bin_mem);
+    return detector.loadModel(param_reader, bin_reader, "end2end.ncnn.param",
+                              [](const std::string& name, std::string& contents) {
+                                  if (name != "end2end.ncnn.param") return false;
+                                  contents = PARAM;
+                                  return true;
+                              });
+}
+
+// Runs one frame so that settings made through the setters take effect
+void apply_settings(YOLODetector& detector) {
+    const std::vector<unsigned char> grey((size_t)INPUT_SIZE * INPUT_SIZE * 4, 114);
+    detector.detectRGBA(&grey[0], INPUT_SIZE, INPUT_SIZE, INPUT_SIZE * 4);
+}
+
+// x1, y1, x2, y2 in network input pixels, then score and class; unused rows stay zero
+struct Head {
+    ncnn::Mat mat;
+    int rows;
+
+    Head() : mat(6, HEAD_ROWS), rows(0) { mat.fill(0.0f); }
+
+    void add(float x1, float y1, float x2, float y2, float score, int class_id) {
+        float* row = mat.row(rows++);
+        row[0] = x1;
+        row[1] = y1;
+        row[2] = x2;
+        row[3] = y2;
+        row[4] = score;
+        row[5] = (float)class_id;
+    }
+};
+
+bool near(float a, float b) { return std::fabs(a - b) < 1e-3f; }
+
+bool box_is(const DetectionResult& det, int class_id, float x, float y, float w, float h) {
+    return det.classId == class_id && near(det.x, x) && near(det.y, y) && near(det.width, w) &&
+           near(det.height, h);
+}
+
+// Rows below 0.25 are dropped, rows at it kept. Overlapping boxes survive: the head is
+// already deduplicated, so no NMS runs on it.
+void test_confidence_threshold(YOLODetector& detector) {
+    // 1280x720 into 640x640: scale 0.5, 140 rows of padding above and below
+    const InputTransform tf = InputTransform::letterbox(1280, 720, 640, 640, 32, false);
+    Head head;
+    head.add(100, 200, 300, 400, 0.9f, 0);
+    head.add(104, 204, 304, 404, 0.8f, 0);
+    head.add(400, 300, 500, 340, 0.25f, 2);
+    head.add(10, 150, 50, 190, 0.2499f, 2);
+    head.add(10, 150, 50, 190, 0.9f, 80); // no such class
+
+    const std::vector<DetectionResult>& results = detector.postprocess(head.mat, tf);
+    CHECK(results.size() == 3);
+    if (results.size() != 3) return;
+    CHECK(box_is(results[0], 0, 200, 120, 400, 400));
+    CHECK(near(results[0].confidence, 0.9f));
+    CHECK(box_is(results[1], 0, 208, 128, 400, 400));
+    CHECK(box_is(results[2], 2, 800, 320, 200, 80));
+    CHECK(near(results[2].confidence, 0.25f));
+}
+
+void test_class_filter(YOLODetector& detector) {
+    const InputTransform tf = InputTransform::letterbox(640, 640, 640, 640, 32, false);
+    Head head;
+    head.add(10, 10, 50, 50, 0.9f, 0);
+    head.add(60, 10, 100, 50, 0.9f, 2);
+    head.add(110, 10, 150, 50, 0.9f, 7);
+    head.add(160, 10, 200, 50, 0.9f, 9);
+
+    std::vector<int> classes;
+    classes.push_back(7);
+    classes.push_back(2);
+    detector.setClassFilter(classes);
+    apply_settings(detector);
+    const std::vector<DetectionResult>& filtered = detector.postprocess(head.mat, tf);
+    CHECK(filtered.size() == 2);
+    if (filtered.size() == 2) {
+        CHECK(box_is(filtered[0], 2, 60, 10, 40, 40));
+        CHECK(box_is(filtered[1], 7, 110, 10, 40, 40));
+    }
+
+    detector.setClassFilter(std::vector<int>());
+    apply_settings(detector);
+    CHECK(detector.postprocess(head.mat, tf).size() == 4);
+}
+
+// Padding is subtracted before the scale is undone, and boxes are clamped to the source
+void test_letterbox_mapping(YOLODetector& detector) {
+    // Portrait 960x1280 into 640x640: scale 0.5, 80 columns of padding left and right
+    const InputTransform portrait = InputTransform::letterbox(960, 1280, 640, 640, 32, false);
+    CHECK(portrait.pad_x == 80 && portrait.pad_y == 0);
+    Head head;
+    head.add(180, 40, 280, 140, 0.9f, 1);
+    head.add(40, 300, 600, 660, 0.9f, 3); // reaches into both side bars and past the bottom
+    head.add(0, 300, 70, 400, 0.9f, 4);   // inside the left bar: empty after clamping
+
+    const std::vector<DetectionResult>& results = detector.postprocess(head.mat, portrait);
+    CHECK(results.size() == 2);
+    if (results.size() == 2) {
+        CHECK(box_is(results[0], 1, 200, 80, 200, 200));
+        CHECK(box_is(results[1], 3, 0, 600, 959, 679));
+    }
+
+    // Rect letterbox: 640x480 pads to 640x480 at stride 32 and maps 1:1
+    const InputTransform rect = InputTransform::letterbox(640, 480, 640, 640, 32, true);
+    CHECK(rect.pad_x == 0 && rect.pad_y == 0);
+    Head same;
+    same.add(12, 34, 56, 78, 0.5f, 5);
+    const std::vector<DetectionResult>& mapped = detector.postprocess(same.mat, rect);
+    CHECK(mapped.size() == 1);
+    if (mapped.size() == 1) CHECK(box_is(mapped[0], 5, 12, 34, 44, 44));
+}
+
+} // namespace
+
+int main() {
+    YOLODetector detector;
+    const bool loaded = load_end2end_model(detector);
+    CHECK(loaded);
+    if (loaded) {
+        CHECK(detector.modelInfo().output_name == "out0");
+        test_confidence_threshold(detector);
+        test_class_filter(detector);
+        test_letterbox_mapping(detector);
+    }
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("postprocess_test: all passed\n");
+    return 0;
+}
@@ -0,0 +1,314 @@
+// Local stand-in for the ESP32-CAM stream server (host builds).
+//
+//   mjpeg_replay (--frames DIR | --recording FILE.mjpeg) [--port 8081] [--fps 10] [--loops 0]
+//                [--identity] [--no-length] [--chunk-bytes N] [--verify]
+//
+// Serves GET <any path> as multipart/x-mixed-replace the way the ESP32 sketch does: HTTP/1.1
+// chunked transfer coding with the boundary line, the part header and the JPEG each sent as
+// their own chunk. --frames replays a directory of JPEG files in name order, --recording a
+// captured multipart body (e.g. `curl -s http://<esp32>:81/stream > clip.mjpeg`; the
+// boundary is taken from its first line). --loops 0 repeats forever.
+//
+// Variations for the demuxer's other paths: --identity sends the body without chunked
+// coding, --no-length leaves Content-Length out of the part headers, --chunk-bytes N splits
+// every JPEG over chunks of at most N bytes.
+//
+// --verify serves on an ephemeral loopback port, reads the stream back through MjpegDemuxer
+// as fast as possible and checks every frame byte for byte. Prints a JSON report with the
+// demuxer's CPU time per frame; exits 1 on any mismatch.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "mjpeg_demuxer.h"
+
+namespace {
+
+const char* BOUNDARY = "123456789000000000000987654321"; // the ESP32 sketch's PART_BOUNDARY
+
+struct Args {
+    std::string frames;
+    std::string recording;
+    int port = 8081;
+    double fps = 10;
+    int loops = 0;
+    bool identity = false;
+    bool no_length = false;
+    size_t chunk_bytes = 0;
+    bool verify = false;
+};
+
+typedef std::vector<unsigned char> Bytes;
+
+bool parse_args(int argc, char** argv, Args& a) {
+    for (int i = 1; i < argc; i++) {
+        std::string k = argv[i];
+        if (k == "--identity") { a.identity = true; continue; }
+        if (k == "--no-length") { a.no_length = true; continue; }
+        if (k == "--verify") { a.verify = true; continue; }
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) return false;
+        if (k == "--frames") a.frames = v;
+        else if (k == "--recording") a.recording = v;
+        else if (k == "--port") a.port = atoi(v);
+        else if (k == "--fps") a.fps = atof(v);
+        else if (k == "--loops") a.loops = atoi(v);
+        else if (k == "--chunk-bytes") a.chunk_bytes = (size_t)atol(v);
+        else return false;
+        i++;
+    }
+    return a.frames.empty() != a.recording.empty();
+}
+
+bool ends_with(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool read_file(const std::string& path, Bytes& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+bool load_directory(const std::string& dir, std::vector<Bytes>& frames) {
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return false;
+    while (dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (ends_with(lower, ".jpg") || ends_with(lower, ".jpeg")) files.push_back(dir + "/" + name);
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    for (const std::string& path : files) {
+        frames.push_back(Bytes());
+        if (!read_file(path, frames.back())) return false;
+    }
+    return true;
+}
+
+// Splits a recorded multipart body with the demuxer itself
+bool load_recording(const std::string& path, std::vector<Bytes>& frames) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char line[256] = {0};
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) found = strncmp(line, "--", 2) == 0;
+    fclose(f);
+    if (!found) return false;
+    std::string boundary = line + 2;
+    boundary.erase(boundary.find_last_not_of("\r\n") + 1);
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    MjpegDemuxer demuxer(fd, boundary);
+    MjpegFrame frame;
+    while (demuxer.next(frame)) frames.push_back(Bytes(frame.data, frame.data + frame.size));
+    return true;
+}
+
+bool send_all(int fd, const void* data, size_t size) {
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+class StreamWriter {
+public:
+    StreamWriter(int fd, bool chunked) : fd(fd), chunked(chunked) {}
+
+    bool write(const void* data, size_t size) {
+        if (!chunked) return send_all(fd, data, size);
+        char head[32];
+        int n = snprintf(head, sizeof(head), "%zx\r\n", size);
+        return send_all(fd, head, n) && send_all(fd, data, size) && send_all(fd, "\r\n", 2);
+    }
+    bool write(const std::string& s) { return write(s.data(), s.size()); }
+    bool finish() { return !chunked || send_all(fd, "0\r\n\r\n", 5); }
+
+private:
+    int fd;
+    bool chunked;
+};
+
+// Streams the frames to one client; returns when the client leaves or the loops are done
+void serve_client(int client, const Args& a, const std::vector<Bytes>& frames) {
+    std::string head = std::string("HTTP/1.1 200 OK\r\nContent-Type: multipart/x-mixed-replace;boundary=") +
+                       BOUNDARY + "\r\n" + (a.identity ? "" : "Transfer-Encoding: chunked\r\n") + "\r\n";
+    if (!send_all(client, head.data(), head.size())) return;
+
+    StreamWriter out(client, !a.identity);
+    const std::string delimiter = std::string("\r\n--") + BOUNDARY + "\r\n";
+    std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now();
+    const std::chrono::nanoseconds period((int64_t)(a.fps > 0 ? 1e9 / a.fps : 0));
+    for (int loop = 0; a.loops == 0 || loop < a.loops; loop++) {
+        for (const Bytes& jpeg : frames) {
+            char part[96];
+            if (a.no_length) snprintf(part, sizeof(part), "Content-Type: image/jpeg\r\n\r\n");
+            else snprintf(part, sizeof(part), "Content-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n", jpeg.size());
+            if (!out.write(delimiter) || !out.write(part, strlen(part))) return;
+            const size_t step = a.chunk_bytes > 0 ? a.chunk_bytes : jpeg.size();
+            for (size_t at = 0; at < jpeg.size(); at += step) {
+                if (!out.write(&jpeg[at], std::min(step, jpeg.size() - at))) return;
+            }
+            if (period.count() > 0) {
+                due += period;
+                std::this_thread::sleep_until(due);
+            }
+        }
+    }
+    out.write(std::string("\r\n--") + BOUNDARY + "--\r\n");
+    out.finish();
+}
+
+int listen_on(int port, bool loopback, int& bound_port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(loopback ? INADDR_LOOPBACK : INADDR_ANY);
+    socklen_t len = sizeof(addr);
+    if (bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(sock, 4) != 0 ||
+        getsockname(sock, (sockaddr*)&addr, &len) != 0) {
+        close(sock);
+        return -1;
+    }
+    bound_port = ntohs(addr.sin_port);
+    return sock;
+}
+
+// Discards the request head; any GET gets the stream
+void skip_request(int client) {
+    std::string req;
+    char buf[512];
+    while (req.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(client, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        req.append(buf, n);
+    }
+}
+
+double thread_cpu_ms() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int verify(const Args& a, const std::vector<Bytes>& frames) {
+    int port = 0;
+    int listener = listen_on(0, true, port);
+    if (listener < 0) {
+        fprintf(stderr, "cannot listen\n");
+        return 1;
+    }
+    Args served = a;
+    served.fps = 0;
+    if (served.loops == 0) served.loops = 1;
+    std::thread server([&] {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) return;
+        skip_request(client);
+        serve_client(client, served, frames);
+        close(client);
+    });
+
+    int fd = MjpegDemuxer::connect("127.0.0.1", port, "/stream", 5000);
+    int received = 0;
+    int mismatches = 0;
+    int64_t bytes = 0;
+    double cpu_ms = 0;
+    double wall_ms = 0;
+    if (fd >= 0) {
+        MjpegDemuxer demuxer(fd);
+        MjpegFrame frame;
+        double cpu_start = thread_cpu_ms();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (demuxer.next(frame)) {
+            const Bytes& expected = frames[received % frames.size()];
+            if (frame.size != expected.size() || memcmp(frame.data, &expected[0], frame.size) != 0) mismatches++;
+            received++;
+        }
+        cpu_ms = thread_cpu_ms() - cpu_start;
+        wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        bytes = demuxer.bytesRead();
+    }
+    server.join();
+    close(listener);
+
+    const int expected = (int)frames.size() * served.loops;
+    printf("{\n");
+    printf("  \"source\": \"%s\",\n", a.frames.empty() ? a.recording.c_str() : a.frames.c_str());
+    printf("  \"chunked\": %s,\n", a.identity ? "false" : "true");
+    printf("  \"content_length\": %s,\n", a.no_length ? "false" : "true");
+    printf("  \"chunk_bytes\": %zu,\n", a.chunk_bytes);
+    printf("  \"frames_expected\": %d,\n", expected);
+    printf("  \"frames_received\": %d,\n", received);
+    printf("  \"mismatches\": %d,\n", mismatches);
+    printf("  \"bytes\": %lld,\n", (long long)bytes);
+    printf("  \"wall_ms\": %.3f,\n", wall_ms);
+    printf("  \"cpu_us_per_frame\": %.3f\n", received > 0 ? cpu_ms * 1e3 / received : 0.0);
+    printf("}\n");
+    return received == expected && mismatches == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Args a;
+    if (!parse_args(argc, argv, a)) {
+        fprintf(stderr, "usage: %s (--frames DIR | --recording FILE.mjpeg) [--port N] [--fps F] [--loops N]\n"
+                        "       [--identity] [--no-length] [--chunk-bytes N] [--verify]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Bytes> frames;
+    bool ok = a.frames.empty() ? load_recording(a.recording, frames) : load_directory(a.frames, frames);
+    if (!ok || frames.empty()) {
+        fprintf(stderr, "no JPEG frames in %s\n", a.frames.empty() ? a.recording.c_str() : a.frames.c_str());
+        return 1;
+    }
+    if (a.verify) return verify(a, frames);
+
+    int port = 0;
+    int listener = listen_on(a.port, false, port);
+    if (listener < 0) {
+        fprintf(stderr, "cannot listen on port %d\n", a.port);
+        return 1;
+    }
+    fprintf(stderr, "serving %zu frames on http://0.0.0.0:%d/stream\n", frames.size(), port);
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        skip_request(client);
+        serve_client(client, a, frames);
+        close(client);
+    }
+}
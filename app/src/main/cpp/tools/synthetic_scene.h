@@ -0,0 +1,169 @@
+#ifndef SYNTHETIC_SCENE_H
+#define SYNTHETIC_SCENE_H
+
+// Deterministic synthetic load for the host microbenchmarks: dense YOLO heads with a chosen
+// number of anchors above threshold and a chosen overlap density, NMS candidate sets, and
+// moving-object scenes with births and deaths for the tracker.
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "mat.h"
+#include "ByteTracker.h"
+
+// xorshift32: fast, reproducible, and identical across platforms
+class SceneRng {
+public:
+    explicit SceneRng(uint32_t seed) : state(seed ? seed : 1u) {}
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    int below(int n) { return (int)(next() % (uint32_t)n); }
+
+private:
+    uint32_t state;
+};
+
+// Candidate boxes (xyxy) grouped into clusters. overlap in [0, 1]: 0 spreads every box
+// on its own, 1 stacks all of them on a handful of objects (the crowded-scene worst case
+// for greedy NMS, where each kept box still has to test everything after it).
+// Object sizes are drawn from [16, max_box]; max_box <= 0 means image_size / 4.
+struct CandidateSet {
+    std::vector<float> boxes;
+    std::vector<float> scores;
+    std::vector<int> class_ids;
+};
+
+inline void make_candidates(int count, float overlap, int num_classes, float image_size, uint32_t seed,
+                            CandidateSet& out, float max_box = 0.0f) {
+    SceneRng rng(seed);
+    const int clusters = std::max(1, (int)(count * (1.0f - overlap)));
+    const float size_hi = max_box > 0.0f ? max_box : image_size / 4;
+    std::vector<float> centers(clusters * 4);
+    for (int c = 0; c < clusters; c++) {
+        float w = rng.uniform(16.0f, size_hi);
+        float h = rng.uniform(16.0f, size_hi);
+        centers[c * 4 + 0] = rng.uniform(w / 2, image_size - w / 2);
+        centers[c * 4 + 1] = rng.uniform(h / 2, image_size - h / 2);
+        centers[c * 4 + 2] = w;
+        centers[c * 4 + 3] = h;
+    }
+
+    out.boxes.resize(count * 4);
+    out.scores.resize(count);
+    out.class_ids.resize(count);
+    for (int i = 0; i < count; i++) {
+        const float* c = &centers[rng.below(clusters) * 4];
+        float jitter = 0.08f;
+        float cx = c[0] + rng.uniform(-jitter, jitter) * c[2];
+        float cy = c[1] + rng.uniform(-jitter, jitter) * c[3];
+        float w = c[2] * rng.uniform(0.9f, 1.1f);
+        float h = c[3] * rng.uniform(0.9f, 1.1f);
+        out.boxes[i * 4 + 0] = cx - w / 2;
+        out.boxes[i * 4 + 1] = cy - h / 2;
+        out.boxes[i * 4 + 2] = cx + w / 2;
+        out.boxes[i * 4 + 3] = cy + h / 2;
+        out.scores[i] = rng.uniform(0.3f, 0.95f);
+        out.class_ids[i] = rng.below(num_classes);
+    }
+}
+
+// Dense head blob (4 + num_classes) x num_anchors in network input coordinates, with exactly
+// `above` anchors whose best class clears conf_threshold; the rest stay below it.
+inline void make_dense_head(int num_anchors, int num_classes, int above, float overlap, float conf_threshold,
+                            float input_size, uint32_t seed, ncnn::Mat& out) {
+    CandidateSet set;
+    make_candidates(above, overlap, num_classes, input_size, seed, set);
+
+    out.create(num_anchors, 4 + num_classes);
+    SceneRng rng(seed ^ 0x9e3779b9u);
+    for (int row = 0; row < out.h; row++) {
+        float* p = out.row(row);
+        for (int a = 0; a < num_anchors; a++) {
+            p[a] = row < 4 ? rng.uniform(0.0f, input_size) : rng.uniform(0.0f, conf_threshold * 0.8f);
+        }
+    }
+
+    // Scatter the above-threshold anchors over the anchor range
+    for (int i = 0; i < above && i < num_anchors; i++) {
+        int a = (int)((int64_t)i * num_anchors / std::max(1, above));
+        const float* b = &set.boxes[i * 4];
+        out.row(0)[a] = (b[0] + b[2]) / 2;
+        out.row(1)[a] = (b[1] + b[3]) / 2;
+        out.row(2)[a] = b[2] - b[0];
+        out.row(3)[a] = b[3] - b[1];
+        out.row(4 + set.class_ids[i])[a] = std::max(set.scores[i], conf_threshold + 0.01f);
+    }
+}
+
+// Objects moving at constant velocity inside the frame. Each step some objects leave
+// (death) and new ones enter (birth) so the population hovers around the target count;
+// detections carry box noise and are occasionally missed, as a real detector's would be.
+class MovingScene {
+public:
+    MovingScene(int target_count, float width, float height, uint32_t seed)
+        : target(target_count), frame_w(width), frame_h(height), rng(seed) {
+        for (int i = 0; i < target; i++) spawn();
+    }
+
+    void step(float death_rate, float miss_rate, std::vector<Object>& detections) {
+        for (size_t i = 0; i < actors.size();) {
+            Actor& a = actors[i];
+            a.x += a.vx;
+            a.y += a.vy;
+            bool gone = a.x + a.w < 0 || a.y + a.h < 0 || a.x > frame_w || a.y > frame_h;
+            if (gone || rng.uniform() < death_rate) {
+                actors[i] = actors.back();
+                actors.pop_back();
+            } else {
+                i++;
+            }
+        }
+        while ((int)actors.size() < target) spawn();
+
+        detections.clear();
+        for (const Actor& a : actors) {
+            if (rng.uniform() < miss_rate) continue;
+            Object o;
+            o.x = a.x + rng.uniform(-1.5f, 1.5f);
+            o.y = a.y + rng.uniform(-1.5f, 1.5f);
+            o.width = a.w * rng.uniform(0.97f, 1.03f);
+            o.height = a.h * rng.uniform(0.97f, 1.03f);
+            o.label = a.label;
+            o.prob = rng.uniform(0.3f, 0.95f);
+            detections.push_back(o);
+        }
+    }
+
+private:
+    struct Actor {
+        float x, y, w, h, vx, vy;
+        int label;
+    };
+
+    void spawn() {
+        Actor a;
+        a.w = rng.uniform(12.0f, frame_w / 8);
+        a.h = rng.uniform(12.0f, frame_h / 6);
+        a.x = rng.uniform(0.0f, frame_w - a.w);
+        a.y = rng.uniform(0.0f, frame_h - a.h);
+        a.vx = rng.uniform(-6.0f, 6.0f);
+        a.vy = rng.uniform(-4.0f, 4.0f);
+        a.label = rng.below(8);
+        actors.push_back(a);
+    }
+
+    int target;
+    float frame_w;
+    float frame_h;
+    SceneRng rng;
+    std::vector<Actor> actors;
+};
+
+#endif // SYNTHETIC_SCENE_H
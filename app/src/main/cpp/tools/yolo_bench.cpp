@@ -0,0 +1,324 @@
+// Per-stage latency benchmark for the detection core (host builds).
+//
+//   yolo_bench --param model.ncnn.param --bin model.ncnn.bin
+//              [--images ncnn_models/trial_photos] [--sequence frames_dir | --sequence clip.yuv --size 640x480]
+//              [--format i420|nv21|jpeg] [--input 640x640] [--threads 4] [--warmup 5] [--repeat 20] [--out run.json]
+//              [--keyframes 4]
+//
+// --images runs every photo in the directory --repeat times; --sequence runs a recorded clip
+// once, in order, so the tracker sees real motion (a directory of JPEG/PNG frames sorted by
+// name, or raw YUV 4:2:0 frames back to back). Reports p50/p90/p99/max per stage as JSON.
+// --keyframes N turns on keyframe mode (best with --sequence); the detector stages are then
+// only sampled on keyframes, track and total on every frame.
+// --format jpeg feeds image files as compressed bytes to detectJPEG(), like the ESP32 stream,
+// and adds the native decode as a "jpeg" stage; files the decoder rejects are decoded by
+// OpenCV instead, as the app falls back to BitmapFactory.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "yolo_detector.h"
+
+namespace {
+
+struct Args {
+    std::string param;
+    std::string bin;
+    std::string images;
+    std::string sequence;
+    std::string format = "i420";
+    std::string out;
+    int seq_w = 0;
+    int seq_h = 0;
+    int input_w = 0;
+    int input_h = 0;
+    int threads = 0;
+    int warmup = 5;
+    int repeat = 20;
+    int keyframes = 1;
+};
+
+struct Samples {
+    const char* name;
+    std::vector<double> ms;
+};
+
+enum Stage { JPEG = 0, PREPROCESS, EXTRACT, DECODE, NMS, TRACK, TOTAL, NUM_STAGES };
+
+bool parse_size(const char* s, int& w, int& h) {
+    return sscanf(s, "%dx%d", &w, &h) == 2 && w > 0 && h > 0;
+}
+
+bool parse_args(int argc, char** argv, Args& a) {
+    for (int i = 1; i < argc; i++) {
+        std::string k = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) return false;
+        if (k == "--param") a.param = v;
+        else if (k == "--bin") a.bin = v;
+        else if (k == "--images") a.images = v;
+        else if (k == "--sequence") a.sequence = v;
+        else if (k == "--format") a.format = v;
+        else if (k == "--out") a.out = v;
+        else if (k == "--size") { if (!parse_size(v, a.seq_w, a.seq_h)) return false; }
+        else if (k == "--input") { if (!parse_size(v, a.input_w, a.input_h)) return false; }
+        else if (k == "--threads") a.threads = atoi(v);
+        else if (k == "--warmup") a.warmup = atoi(v);
+        else if (k == "--repeat") a.repeat = atoi(v);
+        else if (k == "--keyframes") a.keyframes = atoi(v);
+        else return false;
+        i++;
+    }
+    return !a.param.empty() && !a.bin.empty() && (!a.images.empty() || !a.sequence.empty());
+}
+
+bool ends_with(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+std::vector<std::string> list_images(const std::string& dir) {
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return files;
+    while (dirent* e = readdir(d)) {
+        std::string name = e->d_name;
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (ends_with(lower, ".jpg") || ends_with(lower, ".jpeg") || ends_with(lower, ".png")) {
+            files.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool load_rgba(const std::string& path, cv::Mat& rgba) {
+    cv::Mat bgr = cv::imread(path, cv::IMREAD_COLOR);
+    if (bgr.empty()) return false;
+    cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
+    return true;
+}
+
+bool read_file(const std::string& path, std::vector<unsigned char>& bytes) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    bytes.clear();
+    unsigned char chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) bytes.insert(bytes.end(), chunk, chunk + n);
+    fclose(fp);
+    return !bytes.empty();
+}
+
+// A still frame in the form --format asks for: the file's bytes if the native JPEG decoder
+// takes them, plus RGBA pixels for the fallback
+struct Frame {
+    std::vector<unsigned char> jpeg;
+    cv::Mat rgba;
+};
+
+bool load_frame(const std::string& path, const Args& a, Frame& frame) {
+    frame.jpeg.clear();
+    if (a.format == "jpeg" && read_file(path, frame.jpeg)) {
+        JpegDecoder probe;
+        if (probe.readHeader(&frame.jpeg[0], frame.jpeg.size())) {
+            load_rgba(path, frame.rgba);
+            return true;
+        }
+        fprintf(stderr, "%s: not decodable natively, using OpenCV\n", path.c_str());
+        frame.jpeg.clear();
+    }
+    return load_rgba(path, frame.rgba);
+}
+
+void detect_frame(YOLODetector& detector, const Frame& frame) {
+    std::vector<DetectionResult> results;
+    if (!frame.jpeg.empty() && detector.detectJPEG(&frame.jpeg[0], frame.jpeg.size(), results)) return;
+    if (!frame.rgba.empty()) {
+        detector.detectRGBA(frame.rgba.data, frame.rgba.cols, frame.rgba.rows, (int)frame.rgba.step);
+    }
+}
+
+void record(YOLODetector& detector, double total_ms, std::vector<Samples>& samples) {
+    const StageTimings& t = detector.lastTimings();
+    if (t.jpeg_ms > 0) samples[JPEG].ms.push_back(t.jpeg_ms);
+    if (t.keyframe) {
+        samples[PREPROCESS].ms.push_back(t.preprocess_ms);
+        samples[EXTRACT].ms.push_back(t.extract_ms);
+        samples[DECODE].ms.push_back(t.decode_ms);
+        samples[NMS].ms.push_back(t.nms_ms);
+    }
+    samples[TRACK].ms.push_back(t.track_ms);
+    samples[TOTAL].ms.push_back(total_ms);
+}
+
+template<class F>
+double timed(F fn) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nearest-rank percentile of an already sorted sample
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+    rank = std::min(std::max(rank, (size_t)1), sorted.size());
+    return sorted[rank - 1];
+}
+
+bool run_images(YOLODetector& detector, const Args& a, std::vector<Samples>& samples, int& frames) {
+    std::vector<std::string> files = list_images(a.images);
+    if (files.empty()) {
+        fprintf(stderr, "no images in %s\n", a.images.c_str());
+        return false;
+    }
+    for (const std::string& file : files) {
+        Frame frame;
+        if (!load_frame(file, a, frame)) {
+            fprintf(stderr, "cannot decode %s\n", file.c_str());
+            return false;
+        }
+        for (int i = 0; i < a.warmup + a.repeat; i++) {
+            double total = timed([&] { detect_frame(detector, frame); });
+            if (i >= a.warmup) {
+                record(detector, total, samples);
+                frames++;
+            }
+        }
+    }
+    return true;
+}
+
+bool run_sequence(YOLODetector& detector, const Args& a, std::vector<Samples>& samples, int& frames) {
+    if (!ends_with(a.sequence, ".yuv")) {
+        std::vector<std::string> files = list_images(a.sequence);
+        if (files.empty()) {
+            fprintf(stderr, "no frames in %s\n", a.sequence.c_str());
+            return false;
+        }
+        for (size_t i = 0; i < files.size(); i++) {
+            Frame frame;
+            if (!load_frame(files[i], a, frame)) continue;
+            double total = timed([&] { detect_frame(detector, frame); });
+            if ((int)i >= a.warmup) {
+                record(detector, total, samples);
+                frames++;
+            }
+        }
+        return true;
+    }
+
+    if (a.seq_w <= 0 || a.seq_h <= 0 || (a.seq_w & 1) || (a.seq_h & 1)) {
+        fprintf(stderr, "--sequence *.yuv needs an even --size WxH\n");
+        return false;
+    }
+    FILE* fp = fopen(a.sequence.c_str(), "rb");
+    if (!fp) {
+        fprintf(stderr, "cannot open %s\n", a.sequence.c_str());
+        return false;
+    }
+    const size_t y_size = (size_t)a.seq_w * a.seq_h;
+    std::vector<unsigned char> buf(y_size * 3 / 2);
+    const bool nv21 = a.format == "nv21";
+
+    YUV420Image img;
+    img.width = a.seq_w;
+    img.height = a.seq_h;
+    img.y = &buf[0];
+    img.y_row_stride = a.seq_w;
+    if (nv21) {
+        img.v = &buf[y_size];
+        img.u = &buf[y_size + 1];
+        img.uv_row_stride = a.seq_w;
+        img.uv_pixel_stride = 2;
+    } else {
+        img.u = &buf[y_size];
+        img.v = &buf[y_size + y_size / 4];
+        img.uv_row_stride = a.seq_w / 2;
+        img.uv_pixel_stride = 1;
+    }
+
+    for (int i = 0; fread(&buf[0], 1, buf.size(), fp) == buf.size(); i++) {
+        double total = timed([&] { detector.detectYUV420(img); });
+        if (i >= a.warmup) {
+            record(detector, total, samples);
+            frames++;
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+void write_json(FILE* f, const Args& a, const YOLODetector& detector, int frames, std::vector<Samples>& samples) {
+    const ModelInfo& info = detector.modelInfo();
+    AllocStats alloc = detector.allocatorStats();
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"model\": \"%s\",\n", a.param.c_str());
+    fprintf(f, "  \"source\": \"%s\",\n", a.images.empty() ? a.sequence.c_str() : a.images.c_str());
+    fprintf(f, "  \"input\": [%d, %d],\n", info.input_w, info.input_h);
+    fprintf(f, "  \"threads\": %d,\n", a.threads);
+    fprintf(f, "  \"frames\": %d,\n", frames);
+    fprintf(f, "  \"keyframes\": %d,\n", (int)samples[EXTRACT].ms.size());
+    fprintf(f, "  \"system_allocs\": %lld,\n", (long long)alloc.system_allocs);
+    fprintf(f, "  \"stages_ms\": {\n");
+    for (int s = 0; s < NUM_STAGES; s++) {
+        std::vector<double>& v = samples[s].ms;
+        std::sort(v.begin(), v.end());
+        double mean = 0.0;
+        for (double x : v) mean += x;
+        if (!v.empty()) mean /= v.size();
+        fprintf(f, "    \"%s\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f}%s\n",
+                samples[s].name, percentile(v, 50), percentile(v, 90), percentile(v, 99),
+                v.empty() ? 0.0 : v.back(), mean, s + 1 < NUM_STAGES ? "," : "");
+    }
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Args a;
+    if (!parse_args(argc, argv, a)) {
+        fprintf(stderr, "usage: %s --param P --bin B (--images DIR | --sequence DIR|FILE.yuv [--size WxH] [--format i420|nv21|jpeg])\n"
+                        "       [--input WxH] [--threads N] [--warmup N] [--repeat N] [--out FILE] [--keyframes N]\n", argv[0]);
+        return 2;
+    }
+
+    YOLODetector detector;
+    if (a.threads > 0) detector.setNumThreads(a.threads);
+    if (a.input_w > 0) detector.setInputSize(a.input_w, a.input_h);
+    detector.setKeyframeInterval(a.keyframes);
+    if (!detector.loadModel(a.param.c_str(), a.bin.c_str())) {
+        fprintf(stderr, "failed to load %s\n", a.param.c_str());
+        return 1;
+    }
+
+    std::vector<Samples> samples(NUM_STAGES);
+    const char* names[NUM_STAGES] = { "jpeg", "preprocess", "extract", "decode", "nms", "track", "total" };
+    for (int s = 0; s < NUM_STAGES; s++) samples[s].name = names[s];
+
+    int frames = 0;
+    bool ok = a.images.empty() ? run_sequence(detector, a, samples, frames) : run_images(detector, a, samples, frames);
+    if (!ok) return 1;
+
+    FILE* f = a.out.empty() ? stdout : fopen(a.out.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", a.out.c_str());
+        return 1;
+    }
+    write_json(f, a, detector, frames, samples);
+    if (f != stdout) fclose(f);
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Microbenchmarks for the per-frame CPU hot spots under synthetic load (host builds):
+// NmsEngine::run, YOLODetector::postprocess (decode + NMS) and BYTETracker::update.
+//
+//   yolo_microbench [--filter nms|postprocess|tracker] [--min-ms 200]
+//
+// Reports time per call and heap allocations per call. Allocations are counted through
+// every replaceable operator new, i.e. STL containers; ncnn::Mat buffers are not included.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include "nms.h"
+#include "yolo_detector.h"
+#include "synthetic_scene.h"
+
+static std::atomic<long long> g_allocations(0);
+
+// Every replaceable form goes through these two. They stay out of line so that, after
+// inlining, the compiler never sees a replaced operator new paired with free()
+// (-Wmismatched-new-delete).
+__attribute__((noinline)) static void* counted_alloc(size_t size, size_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t)) return malloc(size);
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+__attribute__((noinline)) static void counted_free(void* p) {
+    free(p);
+}
+
+static void* counted_new(size_t size, size_t alignment = 0) {
+    void* p = counted_alloc(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return counted_new(size); }
+void* operator new[](size_t size) { return counted_new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete(void* p, size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t al) { return counted_new(size, (size_t)al); }
+void* operator new[](size_t size, std::align_val_t al) { return counted_new(size, (size_t)al); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_alloc(size, (size_t)al);
+}
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_alloc(size, (size_t)al);
+}
+void operator delete(void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { counted_free(p); }
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double g_min_ms = 200.0;
+std::string g_filter;
+
+struct Measurement {
+    double us_per_call;
+    double allocs_per_call;
+    long long calls;
+};
+
+void report(const char* name, const std::string& params, const Measurement& m) {
+    printf("%-12s %-40s %12.2f %14.2f %10lld\n", name, params.c_str(), m.us_per_call, m.allocs_per_call, m.calls);
+    fflush(stdout);
+}
+
+bool enabled(const char* name) {
+    return g_filter.empty() || g_filter == name;
+}
+
+// Runs setup() untimed and call() timed until min_ms of timed work has accumulated
+template<class Setup, class Call>
+Measurement measure(Setup setup, Call call) {
+    double total_ms = 0.0;
+    long long allocs = 0;
+    long long calls = 0;
+    while (total_ms < g_min_ms || calls < 10) {
+        setup();
+        long long a0 = g_allocations.load(std::memory_order_relaxed);
+        Clock::time_point t0 = Clock::now();
+        call();
+        total_ms += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        allocs += g_allocations.load(std::memory_order_relaxed) - a0;
+        calls++;
+    }
+    Measurement m;
+    m.us_per_call = total_ms * 1000.0 / calls;
+    m.allocs_per_call = (double)allocs / calls;
+    m.calls = calls;
+    return m;
+}
+
+void bench_nms() {
+    const int counts[] = { 10, 100, 500, 1000, 2000, 5000 };
+    const float overlaps[] = { 0.0f, 0.5f, 0.9f };
+    // Objects up to a quarter of the frame, and small distant objects as in a street scene
+    const float max_boxes[] = { 160.0f, 32.0f };
+    NmsEngine engine;
+    NmsOptions opt;
+    std::vector<int> keep;
+
+    for (float max_box : max_boxes) {
+        for (int n : counts) {
+            for (float overlap : overlaps) {
+                CandidateSet set;
+                make_candidates(n, overlap, 80, 640.0f, 1234u + n, set, max_box);
+                engine.run(set.boxes, set.scores, set.class_ids, opt, keep); // warm the buffers
+
+                Measurement m = measure([] {}, [&] { engine.run(set.boxes, set.scores, set.class_ids, opt, keep); });
+                char params[64];
+                snprintf(params, sizeof(params), "n=%d box<=%d overlap=%.1f kept=%d", n, (int)max_box, overlap, (int)keep.size());
+                report("nms", params, m);
+            }
+        }
+    }
+}
+
+void bench_postprocess() {
+    const int above[] = { 10, 100, 1000, 5000 };
+    const float overlaps[] = { 0.5f, 0.9f };
+    const int anchors = 8400;
+    const int classes = 80;
+    YOLODetector detector;
+    InputTransform tf = InputTransform::letterbox(1280, 720, 640, 640, 32, false);
+
+    for (int n : above) {
+        for (float overlap : overlaps) {
+            ncnn::Mat head;
+            make_dense_head(anchors, classes, n, overlap, 0.25f, 640.0f, 99u + n, head);
+            std::vector<DetectionResult> results = detector.postprocess(head, tf);
+
+            Measurement m = measure([] {}, [&] { results = detector.postprocess(head, tf); });
+            char params[64];
+            snprintf(params, sizeof(params), "above=%d overlap=%.1f out=%d", n, overlap, (int)results.size());
+            report("postprocess", params, m);
+        }
+    }
+}
+
+void bench_tracker() {
+    const int counts[] = { 1, 10, 50, 100, 250, 500 };
+    for (int n : counts) {
+        BYTETracker tracker(30, 30);
+        MovingScene scene(n, 1280.0f, 720.0f, 7u + n);
+        std::vector<Object> detections;
+        std::vector<Object> tracked;
+
+        // Let tracks establish before timing so births, deaths and matches are all in play
+        for (int i = 0; i < 30; i++) {
+            scene.step(0.02f, 0.05f, detections);
+            tracker.update(detections, tracked);
+        }
+
+        Measurement m = measure([&] { scene.step(0.02f, 0.05f, detections); },
+                                [&] { tracker.update(detections, tracked); });
+        char params[64];
+        snprintf(params, sizeof(params), "objects=%d tracked=%d", n, (int)tracked.size());
+        report("tracker", params, m);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--filter")) g_filter = argv[i + 1];
+        else if (!strcmp(argv[i], "--min-ms")) g_min_ms = atof(argv[i + 1]);
+        else {
+            fprintf(stderr, "usage: %s [--filter nms|postprocess|tracker] [--min-ms N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("%-12s %-40s %12s %14s %10s\n", "benchmark", "case", "us/call", "allocs/call", "calls");
+    if (enabled("nms")) bench_nms();
+    if (enabled("postprocess")) bench_postprocess();
+    if (enabled("tracker")) bench_tracker();
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(int num_threads)
+    : job(nullptr), job_tasks(0), next_task(0), pending_tasks(0), generation(0), stopping(false) {
+    for (int i = 1; i < num_threads; i++) {
+        threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void WorkerPool::parallel_for(int num_tasks, const std::function<void(int)>& fn) {
+    if (num_tasks <= 0) return;
+    if (threads.empty() || num_tasks == 1) {
+        for (int i = 0; i < num_tasks; i++) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        job_tasks = num_tasks;
+        next_task = 0;
+        pending_tasks = num_tasks;
+        generation++;
+    }
+    work_cv.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return pending_tasks == 0; });
+    job = nullptr;
+}
+
+// Claims and runs tasks of the current job until none are left
+void WorkerPool::runTasks() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (job && next_task < job_tasks) {
+        int task = next_task++;
+        const std::function<void(int)>* fn = job;
+        lock.unlock();
+
+        (*fn)(task);
+
+        lock.lock();
+        if (--pending_tasks == 0) done_cv.notify_all();
+    }
+}
+
+void WorkerPool::workerLoop() {
+    unsigned int seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runTasks();
+    }
+}
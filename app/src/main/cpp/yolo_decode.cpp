@@ -0,0 +1,129 @@
+#include "yolo_decode.h"
+#include <algorithm>
+#include "simd_lanes.h"
+
+namespace {
+
+// Anchors processed per tile: max/argmax for a tile stay in L1 while every class row streams through
+const int TILE_ANCHORS = 256;
+
+// Anchors below this are decoded on the calling thread, waking workers costs more than it saves
+const int MIN_ANCHORS_PER_CHUNK = 1024;
+
+// Running max/argmax update of one class row over [begin, end) of a tile
+template<class L>
+int argmax_row(const float* scores, float class_id, float* max_buf, float* idx_buf, int begin, int end) {
+    typedef typename L::V V;
+    typedef typename L::M M;
+    const V vid = L::dup(class_id);
+
+    int i = begin;
+    for (; i + L::N <= end; i += L::N) {
+        V s = L::load(scores + i);
+        V m = L::load(max_buf + i);
+        M better = L::gt(s, m);
+        L::store(max_buf + i, L::select(better, s, m));
+        L::store(idx_buf + i, L::select(better, vid, L::load(idx_buf + i)));
+    }
+    return i;
+}
+
+} // namespace
+
+DenseHeadDecoder::DenseHeadDecoder(int num_threads) : pool(std::max(1, num_threads)) {
+    chunk_candidates.resize(pool.size());
+    chunk_scratch.resize(pool.size());
+}
+
+void DenseHeadDecoder::decodeRange(const ncnn::Mat& output, const std::vector<int>& class_ids, float conf_threshold,
+                                   int begin, int end, std::vector<float>& scratch, std::vector<Candidate>& out) {
+    out.clear();
+    scratch.resize(TILE_ANCHORS * 2);
+    float* max_buf = &scratch[0];
+    float* idx_buf = max_buf + TILE_ANCHORS;
+
+    const float* cx_row = output.row(0);
+    const float* cy_row = output.row(1);
+    const float* w_row = output.row(2);
+    const float* h_row = output.row(3);
+
+    for (int t0 = begin; t0 < end; t0 += TILE_ANCHORS) {
+        const int n = std::min(TILE_ANCHORS, end - t0);
+
+        // Scores start at 0 like the scalar decoder: an anchor whose classes are all 0 keeps the first class
+        std::fill(max_buf, max_buf + n, 0.0f);
+        std::fill(idx_buf, idx_buf + n, (float)class_ids[0]);
+
+        for (size_t k = 0; k < class_ids.size(); k++) {
+            const int c = class_ids[k];
+            const float* scores = (const float*)output.row(4 + c) + t0;
+            int i = 0;
+#if HAVE_SIMD_LANES
+            i = argmax_row<SimdLanes>(scores, (float)c, max_buf, idx_buf, i, n);
+#endif
+            argmax_row<ScalarLanes>(scores, (float)c, max_buf, idx_buf, i, n);
+        }
+
+        // Only anchors above threshold ever read their box rows
+        for (int i = 0; i < n; i++) {
+            if (max_buf[i] < conf_threshold) continue;
+            const int a = t0 + i;
+            Candidate cand;
+            cand.cx = cx_row[a];
+            cand.cy = cy_row[a];
+            cand.w = w_row[a];
+            cand.h = h_row[a];
+            cand.score = max_buf[i];
+            cand.class_id = (int)idx_buf[i];
+            out.push_back(cand);
+        }
+    }
+}
+
+void DenseHeadDecoder::decode(const ncnn::Mat& output, const std::vector<int>& class_ids, float conf_threshold, std::vector<Candidate>& candidates) {
+    candidates.clear();
+    const int num_anchors = output.w;
+    if (num_anchors <= 0 || class_ids.empty() || class_ids.back() >= output.h - 4) return;
+
+    int num_chunks = std::min(pool.size(), std::max(1, num_anchors / MIN_ANCHORS_PER_CHUNK));
+    // Chunk boundaries on SIMD-friendly multiples of 4 anchors
+    const int chunk = ((num_anchors + num_chunks - 1) / num_chunks + 3) & ~3;
+
+    pool.parallel_for(num_chunks, [&](int k) {
+        const int begin = std::min(num_anchors, k * chunk);
+        const int end = std::min(num_anchors, begin + chunk);
+        decodeRange(output, class_ids, conf_threshold, begin, end, chunk_scratch[k], chunk_candidates[k]);
+    });
+
+    // Merge in chunk order so the result matches a single-threaded anchor scan
+    for (int k = 0; k < num_chunks; k++) {
+        candidates.insert(candidates.end(), chunk_candidates[k].begin(), chunk_candidates[k].end());
+    }
+}
+
+HeadType detect_head_type(const ncnn::Mat& output) {
+    if (output.dims == 2 && output.w == 6 && output.h > 0) return HEAD_END2END;
+    return HEAD_DENSE;
+}
+
+void decode_end2end(const ncnn::Mat& output, const std::vector<int>& class_ids, float conf_threshold,
+                    std::vector<Candidate>& candidates) {
+    candidates.clear();
+    for (int i = 0; i < output.h; i++) {
+        const float* row = output.row(i);
+        const float score = row[4];
+        if (score < conf_threshold) continue;
+
+        const int class_id = (int)row[5];
+        if (!std::binary_search(class_ids.begin(), class_ids.end(), class_id)) continue;
+
+        Candidate cand;
+        cand.cx = (row[0] + row[2]) * 0.5f;
+        cand.cy = (row[1] + row[3]) * 0.5f;
+        cand.w = row[2] - row[0];
+        cand.h = row[3] - row[1];
+        cand.score = score;
+        cand.class_id = class_id;
+        candidates.push_back(cand);
+    }
+}
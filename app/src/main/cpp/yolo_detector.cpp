@@ -1,37 +1,51 @@
     #include "yolo_detector.h"
-    #include <android/asset_manager.h>
-    #include <android/log.h>
-    #include <android/asset_manager_jni.h>
     #include <vector>
-    #include <android/log.h>
     #include <algorithm>
-    #include <android/hardware_buffer.h>
     #include <chrono>
+    #include <fstream>
+    #include <sstream>
     #include "cpu.h"
-#define LOG_TAG "YOLO_NATIVE"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+    #include "native_log.h"
 
 const float CONF_THRESHOLD = 0.25f;
 const float NMS_THRESHOLD = 0.70f;
-const int INPUT_SIZE = 640;
-const int NUM_CLASSES = 80;
+const int NMS_MAX_CANDIDATES = 1024; // Bounds worst-case NMS cost in cluttered scenes
+const int NMS_MAX_DETECTIONS = 300;
+const bool NMS_CLASS_AWARE = false;
 
-YOLODetector::YOLODetector() : modelLoaded(false) {
+typedef std::chrono::steady_clock StageClock;
+
+static double elapsed_ms(StageClock::time_point since) {
+    return std::chrono::duration<double, std::milli>(StageClock::now() - since).count();
+}
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(StageClock::now().time_since_epoch()).count();
+}
+
+// Clockwise degrees folded into [0, 360); anything but a right angle is treated as upright
+static int normalize_rotation(int degrees) {
+    degrees %= 360;
+    if (degrees < 0) degrees += 360;
+    return degrees % 90 == 0 ? degrees : 0;
+}
+
+YOLODetector::YOLODetector()
+    : modelLoaded(false), decoder(std::min(4, std::max(1, ncnn::get_big_cpu_count()))) {
     tracker = new BYTETracker(30, 30);
+    nms_options.iou_threshold = NMS_THRESHOLD;
+    nms_options.max_candidates = NMS_MAX_CANDIDATES;
+    nms_options.max_detections = NMS_MAX_DETECTIONS;
+    nms_options.class_aware = NMS_CLASS_AWARE;
+    for (int c = 0; c < model_info.num_classes; c++) active_classes.push_back(c);
 }
 
 YOLODetector::~YOLODetector() {
+    stopPipeline();
     net.clear();
     if (tracker) delete tracker;
 }
 
-
-struct Detection {
-    std::vector<float> boxes; // [x1, y1, x2, y2, x1, y1, x2, y2, ...]
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-};
 // --- Class Names (COCO 80 classes) ---
 const std::vector<std::string> CLASS_NAMES = {
         "person", "bicycle", "car", "motorcycle", "airplane", "bus", "train", "truck", "boat", "traffic light",
@@ -46,28 +60,31 @@ const std::vector<std::string> CLASS_NAMES = {
 };
 
 
-bool YOLODetector::loadModel(AAssetManager* mgr, const char* param, const char* bin) {
-        LOGD("Loading model: %s, %s", param, bin);
-
-        if (!mgr) {
-            LOGE("AssetManager is null");
-            return false;
-        }
+bool YOLODetector::loadModel(const ncnn::DataReader& param_reader, const ncnn::DataReader& bin_reader,
+                             const char* param_name, const ModelFileReader& read_file) {
+        LOGD("Loading model: %s", param_name);
 
         // --- Optimize Performance ---
         // Use big cores for performance and to avoid starving the UI thread.
         int big_cores = ncnn::get_big_cpu_count();
         net.opt.num_threads = big_cores > 0 ? big_cores : 4; // Use big cores if available, otherwise default to 4
+        if (num_threads_override > 0) net.opt.num_threads = num_threads_override;
         net.opt.use_vulkan_compute = true; // Enable GPU acceleration
         net.opt.use_fp16_arithmetic = true;
         net.opt.use_fp16_packed = true;
         net.opt.use_fp16_storage = true;
+        // Per-detector pools: intermediate blobs and scratch memory are recycled across frames
+        net.opt.blob_allocator = &blob_pool;
+        net.opt.workspace_allocator = &workspace_pool;
         
         LOGD("NCNN Options: Threads=%d, Vulkan=%d", net.opt.num_threads, net.opt.use_vulkan_compute);
 
+        // 0. Describe the model: blob names, input shape, class count, baked anchors
+        loadModelInfo(param_name, read_file);
+
         // 1. Load param (Corrected previously)
         LOGD("Loading param to ncnn...");
-        int ret1 = net.load_param(mgr, param);
+        int ret1 = net.load_param(param_reader);
 
         if (ret1 != 0) {
             LOGE("Failed to load param to ncnn, error: %d", ret1);
@@ -75,10 +92,9 @@ bool YOLODetector::loadModel(AAssetManager* mgr, const char* param, const char*
         }
         LOGD("Param loaded successfully");
 
-        // 2. FIX: Load bin directly from AssetManager
-        // This uses the correct NCNN API to handle asset streaming for large weight files.
-        LOGD("Loading model weights directly from asset manager...");
-        int ret2 = net.load_model(mgr, bin); // <--- Use this API
+        // 2. Load weights through the reader (streams large weight files, e.g. from an Android asset)
+        LOGD("Loading model weights...");
+        int ret2 = net.load_model(bin_reader);
 
         if (ret2 != 0) {
             LOGE("Failed to load model weights, error: %d", ret2);
@@ -87,185 +103,323 @@ bool YOLODetector::loadModel(AAssetManager* mgr, const char* param, const char*
         } else {
             LOGD("Model loaded successfully!");
             modelLoaded = true;
+            probeHeadType();
         }
 
         return modelLoaded;
 }
 
+static bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) return false;
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    out = contents.str();
+    return true;
+}
 
+bool YOLODetector::loadModel(const char* param_path, const char* bin_path) {
+    FILE* param_fp = fopen(param_path, "rb");
+    FILE* bin_fp = fopen(bin_path, "rb");
+    bool loaded = false;
+    if (param_fp && bin_fp) {
+        ncnn::DataReaderFromStdio param_reader(param_fp);
+        ncnn::DataReaderFromStdio bin_reader(bin_fp);
+        loaded = loadModel(param_reader, bin_reader, param_path, read_file);
+    } else {
+        LOGE("Cannot open model files %s, %s", param_path, bin_path);
+    }
+    if (param_fp) fclose(param_fp);
+    if (bin_fp) fclose(bin_fp);
+    return loaded;
+}
 
-std::vector<int> nms(const std::vector<float>& boxes, const std::vector<float>& scores, float iou_threshold) {
-    std::vector<int> indices;
-    for (size_t i = 0; i < scores.size(); i++) indices.push_back(i);  // Use scores.size()
-
-    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
-        return scores[a] > scores[b];
-    });
-
-    std::vector<int> keep;
-    while (!indices.empty()) {
-        int current = indices[0];
-        keep.push_back(current);
-
-        std::vector<int> rest;
-        for (size_t i = 1; i < indices.size(); i++) {
-            int idx = indices[i];
-
-            // Extract boxes (each box is 4 values: x1,y1,x2,y2)
-            float x1_a = boxes[current * 4];
-            float y1_a = boxes[current * 4 + 1];
-            float x2_a = boxes[current * 4 + 2];
-            float y2_a = boxes[current * 4 + 3];
-
-            float x1_b = boxes[idx * 4];
-            float y1_b = boxes[idx * 4 + 1];
-            float x2_b = boxes[idx * 4 + 2];
-            float y2_b = boxes[idx * 4 + 3];
-
-            // Calculate intersection
-            float inter_x1 = std::max(x1_a, x1_b);
-            float inter_y1 = std::max(y1_a, y1_b);
-            float inter_x2 = std::min(x2_a, x2_b);
-            float inter_y2 = std::min(y2_a, y2_b);
-
-            float inter_area = std::max(0.0f, inter_x2 - inter_x1) * std::max(0.0f, inter_y2 - inter_y1);
-            float area_a = (x2_a - x1_a) * (y2_a - y1_a);
-            float area_b = (x2_b - x1_b) * (y2_b - y1_b);
-            float union_area = area_a + area_b - inter_area;
+void YOLODetector::loadModelInfo(const char* param_name, const ModelFileReader& read_file) {
+    model_info = ModelInfo();
+
+    // metadata.yaml next to the model: <stem>_metadata.yaml, <stem>.yaml, then the shared metadata.yaml
+    std::string stem(param_name);
+    const size_t slash = stem.rfind('/');
+    const std::string dir = slash == std::string::npos ? std::string() : stem.substr(0, slash + 1);
+    size_t dot = stem.find(".ncnn", dir.size());
+    if (dot == std::string::npos) dot = stem.rfind('.');
+    if (dot != std::string::npos && dot > dir.size()) stem = stem.substr(0, dot);
+
+    const std::string yaml_candidates[] = { stem + "_metadata.yaml", stem + ".yaml", dir + "metadata.yaml" };
+    std::string text;
+    for (const std::string& path : yaml_candidates) {
+        if (read_file(path, text)) {
+            parse_metadata_yaml(text.data(), text.size(), model_info);
+            LOGD("Model metadata from %s", path.c_str());
+            break;
+        }
+    }
 
-            float iou = (union_area > 0) ? (inter_area / union_area) : 0.0f;
+    // The graph has the final say on blob names and baked shapes
+    if (read_file(param_name, text)) {
+        parse_param_graph(text.data(), text.size(), model_info);
+    }
 
-            if (iou <= iou_threshold) {
-                rest.push_back(idx);
-            }
+    if (input_w_override > 0 && input_h_override > 0) {
+        if (model_info.fixed_shape) {
+            LOGE("Model has a baked anchor grid, ignoring input size %dx%d", input_w_override, input_h_override);
+        } else {
+            model_info.input_w = input_w_override;
+            model_info.input_h = input_h_override;
         }
-        indices = rest;
     }
-    return keep;
+
+    LOGD("Model info: in=%s out=%s %dx%d stride=%d classes=%d anchors=%d fixed=%d end2end=%d",
+         model_info.input_name.c_str(), model_info.output_name.c_str(), model_info.input_w, model_info.input_h,
+         model_info.stride, model_info.num_classes, model_info.num_anchors, model_info.fixed_shape, model_info.end2end);
+
+    // Rebuild the class list for this model's class count on the next frame
+    std::lock_guard<std::mutex> lock(config_mutex);
+    classes_dirty = true;
 }
 
 
-std::vector<DetectionResult> YOLODetector::detect(JNIEnv* env, jobject bitmap) {
+
+std::vector<DetectionResult> YOLODetector::detectRGBA(const unsigned char* pixels, int width, int height, int stride,
+                                                     int64_t timestamp_ns, int rotation) {
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<DetectionResult> results;
     if (!modelLoaded) return results;
-
-    AndroidBitmapInfo info;
-    void* pixels;
-
-    if (AndroidBitmap_getInfo(env, bitmap, &info) < 0) return results;
-    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) return results;
+    applyPendingConfig();
+    if (timestamp_ns <= 0) timestamp_ns = now_ns();
+    FrameMode mode = planFrame(timestamp_ns, pixels, width, height, stride, true);
+    if (mode == FRAME_EXTRAPOLATE) return extrapolate(timestamp_ns);
+    if (mode == FRAME_HOLD) return hold();
+    stage_timings.keyframe = true;
 
     // --- Optimized Preprocessing ---
-    preprocess(env, bitmap, info, pixels);
+    // Fused RGBA->RGB + resize + normalize (+ letterbox) straight into resized_input
+    StageClock::time_point stage_start = StageClock::now();
+    this->input_transform = makeInputTransform(width, height, rotation);
+    input_preprocessor.fromRGBA(pixels, stride, this->resized_input, this->input_transform);
+    stage_timings.preprocess_ms = elapsed_ms(stage_start);
     
     // --- Inference ---
     ncnn::Mat output;
-    ncnn::Extractor ex = net.create_extractor();
-    ex.input("in0", this->resized_input);  // Use your input layer name
-    ex.extract("out0", output);  // Use your output layer name
+    extract(this->resized_input, output);
     LOGD("output.w: %d, output.h: %d", output.w, output.h);
 
-    std::vector<DetectionResult> raw_detections = postprocess(output, info.width, info.height);
-    
-    // --- Optimized ByteTrack Integration ---
-    std::vector<Object> tracker_objects;
-    for(const auto& det : raw_detections) {
-        Object obj;
-        obj.x = det.x;
-        obj.y = det.y;
-        obj.width = det.width;
-        obj.height = det.height;
-        obj.label = det.classId;
-        obj.prob = det.confidence;
-        tracker_objects.push_back(obj);
-    }
+    const std::vector<DetectionResult>& raw_detections = postprocess(output, this->input_transform);
     
-    frame_counter++;
-    std::vector<Object> tracked_objects;
-    if (frame_counter >= TRACKER_FRAME_SKIP) {
-        tracked_objects = tracker->update(tracker_objects);
-        last_tracked_objects = tracked_objects;
-        frame_counter = 0; // Reset counter
-    } else {
-        tracked_objects = last_tracked_objects; // Use stale tracks
-    }
-    
-    for(const auto& t_obj : tracked_objects) {
-        DetectionResult res;
-        res.classId = t_obj.label;
-        res.confidence = t_obj.prob;
-        res.x = t_obj.x;
-        res.y = t_obj.y;
-        res.width = t_obj.width;
-        res.height = t_obj.height;
-        res.trackId = t_obj.track_id;
-        results.push_back(res);
-    }
-
-    AndroidBitmap_unlockPixels(env, bitmap);
+    results = track(raw_detections, this->input_transform, timestamp_ns);
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
     float fps = 1000.0f / (duration > 0 ? duration : 1);
-    LOGD("Inference time: %lld ms, FPS: %.2f", duration, fps);
+    LOGD("Inference time: %lld ms, FPS: %.2f", (long long)duration, fps);
 
     return results;
 }
 
-void YOLODetector::preprocess(JNIEnv* env, jobject bitmap, AndroidBitmapInfo& info, void* pixels) {
-    // Now you have access to the actual pixel data
-    ncnn::Mat input = ncnn::Mat::from_pixels(
-            (unsigned char*)pixels,
-            ncnn::Mat::PIXEL_RGBA2RGB,
-            info.width,
-            info.height
-    );
+void YOLODetector::setLetterbox(bool enabled, bool rect) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    letterbox_enabled = enabled;
+    rect_input = rect;
+}
 
-    // Resize using ncnn (no OpenCV) and store in the class member
-    ncnn::resize_bilinear(input, this->resized_input, 640, 640);
+void YOLODetector::extract(const ncnn::Mat& input, ncnn::Mat& output) {
+    StageClock::time_point stage_start = StageClock::now();
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input(model_info.input_name.c_str(), input);
+    ex.extract(model_info.output_name.c_str(), output);
+    stage_timings.extract_ms = elapsed_ms(stage_start);
+    keyframes.reportDetectorLatency(stage_timings.extract_ms);
+}
 
-    // Normalize
-    const float norm_vals[3] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
-    this->resized_input.substract_mean_normalize(nullptr, norm_vals);
+void YOLODetector::setKeyframeInterval(int max_frames) {
+    keyframes.setMaxInterval(max_frames);
 }
 
-std::vector<DetectionResult> YOLODetector::postprocess(const ncnn::Mat& output, int img_w, int img_h) {
-    std::vector<DetectionResult> results;
-    Detection det;
+void YOLODetector::setMotionGate(bool enabled, int max_stale_ms) {
+    motion_gate.setEnabled(enabled, max_stale_ms);
+}
 
-    // Transpose for better memory access
-    this->transposed_output.create(output.h, output.w);
-    for (int i = 0; i < output.h; i++) {
-        for (int j = 0; j < output.w; j++) {
-            this->transposed_output.row(j)[i] = output.row(i)[j];
+// Keyframe scheduler first, then the motion gate may still veto inference on a keyframe
+FrameMode YOLODetector::planFrame(int64_t timestamp_ns, const unsigned char* pixels, int width, int height,
+                                  int stride, bool rgba) {
+    if (!keyframes.nextFrame(timestamp_ns)) return FRAME_EXTRAPOLATE;
+    if (!motion_gate.enabled()) return FRAME_DETECT;
+    if (rgba) motion_gate.sampleRGBA(pixels, width, height, stride);
+    else motion_gate.sampleY(pixels, width, height, stride);
+    return motion_gate.admit(timestamp_ns) ? FRAME_DETECT : FRAME_HOLD;
+}
+
+// planFrame() for compressed frames. The header is parsed first: a JPEG the decoder does not
+// support returns false before the keyframe scheduler or the motion gate have seen the frame,
+// so the caller's fallback (decode elsewhere, detectRGBA/submitRGBA) plans it exactly once.
+// Then the keyframe decision, so extrapolated frames are never decoded, and the motion gate
+// samples the decoded luma. The IDCT scale is the largest that still covers the resized
+// window, so the bilinear pass only ever shrinks. A supported frame whose data turns out to
+// be corrupt is held and the next frame becomes a keyframe.
+bool YOLODetector::planJPEG(int64_t timestamp_ns, JpegDecoder& jpeg, const unsigned char* data, size_t size,
+                            int rotation, FrameMode& mode, YUV420Image& img, double& decode_ms) {
+    decode_ms = 0;
+    StageClock::time_point stage_start = StageClock::now();
+    if (!jpeg.readHeader(data, size)) {
+        int64_t failures;
+        {
+            std::lock_guard<std::mutex> lock(jpeg_stats_mutex);
+            failures = ++jpeg_stats.failures;
         }
+        // A stream the decoder does not support fails on every frame; say so once
+        if (failures == 1) LOGE("JPEG frame of %zu bytes not decodable natively, caller falls back", size);
+        return false;
     }
 
-    int num_boxes = this->transposed_output.h;     // 8400
-    int num_features = this->transposed_output.w;  // 84
+    if (!keyframes.nextFrame(timestamp_ns)) {
+        std::lock_guard<std::mutex> lock(jpeg_stats_mutex);
+        jpeg_stats.skipped++;
+        mode = FRAME_EXTRAPOLATE;
+        return true;
+    }
 
-    // Process detections
-    for (int i = 0; i < num_boxes; i++) {
-        const float* box_features = this->transposed_output.row(i);
-        
-        float cx = box_features[0];
-        float cy = box_features[1];
-        float w = box_features[2];
-        float h = box_features[3];
-
-        // Get class scores
-        const float* class_scores = box_features + 4;
-        float max_conf = 0.0f;
-        int class_id = 0;
-        for (int j = 0; j < NUM_CLASSES; j++) {
-            if (class_scores[j] > max_conf) {
-                max_conf = class_scores[j];
-                class_id = j;
-            }
+    InputTransform tf = makeInputTransform(jpeg.width(), jpeg.height(), rotation);
+    const int scale = jpeg.scaleFor(InputTransform::uprightWidth(tf.resized_w, tf.resized_h, tf.rotation),
+                                    InputTransform::uprightHeight(tf.resized_w, tf.resized_h, tf.rotation));
+    const bool ok = jpeg.decode(scale, img);
+    decode_ms = elapsed_ms(stage_start);
+    {
+        std::lock_guard<std::mutex> lock(jpeg_stats_mutex);
+        if (ok) {
+            jpeg_stats.frames++;
+            jpeg_stats.last_us = (int64_t)(decode_ms * 1000.0);
+            jpeg_stats.total_us += jpeg_stats.last_us;
+            jpeg_stats.last_scale = scale;
+        } else {
+            jpeg_stats.failures++;
         }
+    }
+    if (!ok) {
+        LOGE("Corrupt JPEG frame of %zu bytes, holding the last boxes", size);
+        keyframes.requestKeyframe();
+        mode = FRAME_HOLD;
+        return true;
+    }
 
-        if (max_conf < CONF_THRESHOLD) continue;
+    mode = FRAME_DETECT;
+    if (motion_gate.enabled()) {
+        motion_gate.sampleY(img.y, img.width, img.height, img.y_row_stride);
+        if (!motion_gate.admit(timestamp_ns)) mode = FRAME_HOLD;
+    }
+    return true;
+}
+
+void YOLODetector::setNumThreads(int num_threads) {
+    num_threads_override = num_threads;
+}
+
+void YOLODetector::setInputSize(int width, int height) {
+    input_w_override = width;
+    input_h_override = height;
+}
+
+// One warm-up pass on a blank letterboxed frame: primes ncnn (first inference is slow)
+// and tells us from the output shape which head the model was exported with.
+void YOLODetector::probeHeadType() {
+    ncnn::Mat blank(model_info.input_w, model_info.input_h, 3);
+    blank.fill(114.0f / 255.0f);
+
+    ncnn::Mat output;
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input(model_info.input_name.c_str(), blank);
+    if (ex.extract(model_info.output_name.c_str(), output) != 0) {
+        LOGE("Warm-up inference failed, assuming %s head", model_info.end2end ? "end-to-end" : "dense");
+        head_type = model_info.end2end ? HEAD_END2END : HEAD_DENSE;
+        return;
+    }
+
+    head_type = detect_head_type(output);
+    if (head_type == HEAD_DENSE && output.h > 4 && output.h - 4 != model_info.num_classes) {
+        // The dense head carries one row per class, trust it over missing or stale metadata
+        LOGD("Head has %d classes, metadata said %d", output.h - 4, model_info.num_classes);
+        model_info.num_classes = output.h - 4;
+        model_info.class_names.resize(model_info.num_classes);
+    }
+    LOGD("Output head: %s (%s %d x %d)", head_type == HEAD_END2END ? "end-to-end" : "dense",
+         model_info.output_name.c_str(), output.w, output.h);
+}
+
+void YOLODetector::setClassFilter(const std::vector<int>& class_ids) {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    pending_classes = class_ids;
+    classes_dirty = true;
+}
+
+void YOLODetector::applyPendingConfig() {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    if (!classes_dirty) return;
+    classes_dirty = false;
+
+    active_classes.clear();
+    if (pending_classes.empty()) {
+        for (int c = 0; c < model_info.num_classes; c++) active_classes.push_back(c);
+    } else {
+        for (int c : pending_classes) {
+            if (c >= 0 && c < model_info.num_classes) active_classes.push_back(c);
+        }
+        std::sort(active_classes.begin(), active_classes.end());
+        active_classes.erase(std::unique(active_classes.begin(), active_classes.end()), active_classes.end());
+    }
+    // Tracks of classes that are now filtered out must not be extrapolated: re-detect
+    keyframes.requestKeyframe();
+    motion_gate.requestRefresh();
+}
+
+// img_w x img_h is the buffer as delivered; the network sees it turned upright.
+// Runs on the submitting thread in pipelined mode, so the letterbox settings are read under
+// config_mutex; boxes are normalized to the upright frame, so a change between frames does
+// not disturb the tracks.
+InputTransform YOLODetector::makeInputTransform(int img_w, int img_h, int rotation) const {
+    rotation = normalize_rotation(rotation);
+    const int w = InputTransform::uprightWidth(img_w, img_h, rotation);
+    const int h = InputTransform::uprightHeight(img_w, img_h, rotation);
+    bool letterbox, rect_requested;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        letterbox = letterbox_enabled;
+        rect_requested = rect_input;
+    }
+    InputTransform tf;
+    if (!letterbox) {
+        tf = InputTransform::stretch(w, h, model_info.input_w, model_info.input_h);
+    } else {
+        // A graph with a baked anchor grid only accepts its export shape
+        bool rect = rect_requested && !model_info.fixed_shape;
+        tf = InputTransform::letterbox(w, h, model_info.input_w, model_info.input_h, model_info.stride, rect);
+    }
+    tf.rotation = rotation;
+    return tf;
+}
+
+const std::vector<DetectionResult>& YOLODetector::postprocess(const ncnn::Mat& output, const InputTransform& tf) {
+    const int img_w = tf.src_w;
+    const int img_h = tf.src_h;
+    this->box_corners.clear();
+    this->box_scores.clear();
+    this->box_classes.clear();
+    this->nms_results.clear();
+    StageClock::time_point stage_start = StageClock::now();
+
+    if (head_type == HEAD_END2END) {
+        // One-to-one head: rows are already the final top-K set
+        decode_end2end(output, this->active_classes, CONF_THRESHOLD, this->candidates);
+    } else {
+        // Argmax + threshold straight on the class-major head, no transpose
+        decoder.decode(output, this->active_classes, CONF_THRESHOLD, this->candidates);
+    }
+
+    for (const Candidate& cand : this->candidates) {
+        float cx = cand.cx;
+        float cy = cand.cy;
+        float w = cand.w;
+        float h = cand.h;
+        float max_conf = cand.score;
+        int class_id = cand.class_id;
 
         // Convert center to corners
         float x1 = cx - w / 2.0f;
@@ -273,14 +427,11 @@ std::vector<DetectionResult> YOLODetector::postprocess(const ncnn::Mat& output,
         float x2 = cx + w / 2.0f;
         float y2 = cy + h / 2.0f;
 
-        // Scale from 640x640 to original image size
-        float scale_x = (float)img_w / INPUT_SIZE;
-        float scale_y = (float)img_h / INPUT_SIZE;
-
-        int x1_orig = static_cast<int>(x1 * scale_x);
-        int y1_orig = static_cast<int>(y1 * scale_y);
-        int x2_orig = static_cast<int>(x2 * scale_x);
-        int y2_orig = static_cast<int>(y2 * scale_y);
+        // Undo resize and letterbox padding back to original image size
+        int x1_orig = static_cast<int>(tf.toSrcX(x1));
+        int y1_orig = static_cast<int>(tf.toSrcY(y1));
+        int x2_orig = static_cast<int>(tf.toSrcX(x2));
+        int y2_orig = static_cast<int>(tf.toSrcY(y2));
 
         // Clamp to image boundaries
         x1_orig = std::max(0, std::min(x1_orig, img_w - 1));
@@ -292,115 +443,315 @@ std::vector<DetectionResult> YOLODetector::postprocess(const ncnn::Mat& output,
         int box_height = y2_orig - y1_orig;
 
         if (box_width > 0 && box_height > 0) {
-            det.boxes.push_back(x1_orig);
-            det.boxes.push_back(y1_orig);
-            det.boxes.push_back(x2_orig);
-            det.boxes.push_back(y2_orig);
-            det.class_ids.push_back(class_id);
-            det.confidences.push_back(max_conf);
+            this->box_corners.push_back(x1_orig);
+            this->box_corners.push_back(y1_orig);
+            this->box_corners.push_back(x2_orig);
+            this->box_corners.push_back(y2_orig);
+            this->box_classes.push_back(class_id);
+            this->box_scores.push_back(max_conf);
         }
     }
 
+    stage_timings.decode_ms = elapsed_ms(stage_start);
+    stage_start = StageClock::now();
+
     // Apply NMS and convert to DetectionResult
-    if (!det.boxes.empty()) {
-        std::vector<int> keep = nms(det.boxes, det.confidences, NMS_THRESHOLD);
+    if (!this->box_corners.empty()) {
+        if (head_type == HEAD_END2END) {
+            // NMS-free: keep every row in model order
+            this->nms_keep.resize(this->box_scores.size());
+            for (size_t i = 0; i < this->nms_keep.size(); i++) this->nms_keep[i] = (int)i;
+        } else {
+            nms_engine.run(this->box_corners, this->box_scores, this->box_classes, nms_options, this->nms_keep);
+        }
 
-        for (int idx : keep) {
+        for (int idx : this->nms_keep) {
             DetectionResult result;
-            result.classId = det.class_ids[idx];
-            result.confidence = det.confidences[idx];
-            result.x = det.boxes[idx * 4];
-            result.y = det.boxes[idx * 4 + 1];
-            result.width = det.boxes[idx * 4 + 2] - det.boxes[idx * 4];
-            result.height = det.boxes[idx * 4 + 3] - det.boxes[idx * 4 + 1];
+            result.classId = this->box_classes[idx];
+            result.confidence = this->box_scores[idx];
+            result.x = this->box_corners[idx * 4];
+            result.y = this->box_corners[idx * 4 + 1];
+            result.width = this->box_corners[idx * 4 + 2] - this->box_corners[idx * 4];
+            result.height = this->box_corners[idx * 4 + 3] - this->box_corners[idx * 4 + 1];
             result.trackId = -1; // Default
-            results.push_back(result);
+            this->nms_results.push_back(result);
         }
     }
 
+    stage_timings.nms_ms = elapsed_ms(stage_start);
+    return this->nms_results;
+}
+// Feeds keyframe detections (upright pixels of the frame tf describes) to ByteTrack and
+// returns the tracked set
+std::vector<DetectionResult> YOLODetector::track(const std::vector<DetectionResult>& raw_detections,
+                                                 const InputTransform& tf, int64_t timestamp_ns) {
+    tracker_objects.clear();
+    for(const auto& det : raw_detections) {
+        Object obj;
+        obj.x = det.x;
+        obj.y = det.y;
+        obj.width = det.width;
+        obj.height = det.height;
+        obj.label = det.classId;
+        obj.prob = det.confidence;
+        tracker_objects.push_back(obj);
+    }
+
+    StageClock::time_point stage_start = StageClock::now();
+    {
+        std::lock_guard<std::mutex> lock(tracker_mutex);
+        tracker->update(tracker_objects, tracked_objects, timestamp_ns);
+        keyframes.reportTracks(tracker->motion());
+        output_scale_x = 1.0f / tf.src_w;
+        output_scale_y = 1.0f / tf.src_h;
+    }
+    stage_timings.track_ms = elapsed_ms(stage_start);
+    return toResults(tracked_objects, output_scale_x, output_scale_y);
+}
+
+// Frames between keyframes: no inference, the tracks advance by their motion model
+std::vector<DetectionResult> YOLODetector::extrapolate(int64_t timestamp_ns) {
+    StageClock::time_point stage_start = StageClock::now();
+    {
+        std::lock_guard<std::mutex> lock(tracker_mutex);
+        tracker->extrapolate(tracked_objects, timestamp_ns);
+        keyframes.reportTracks(tracker->motion());
+    }
+    stage_timings = StageTimings();
+    stage_timings.keyframe = false;
+    stage_timings.track_ms = elapsed_ms(stage_start);
+    return toResults(tracked_objects, output_scale_x, output_scale_y);
+}
+
+// Scene unchanged: the tracker stays put and the next detection integrates the whole gap
+std::vector<DetectionResult> YOLODetector::hold() {
+    stage_timings = StageTimings();
+    stage_timings.keyframe = false;
+    return toResults(tracked_objects, output_scale_x, output_scale_y);
+}
+
+std::vector<DetectionResult> YOLODetector::predictTo(int64_t timestamp_ns) {
+    std::vector<Object> predicted;
+    float scale_x, scale_y;
+    {
+        std::lock_guard<std::mutex> lock(tracker_mutex);
+        tracker->predict_to(timestamp_ns, predicted);
+        scale_x = output_scale_x;
+        scale_y = output_scale_y;
+    }
+    return toResults(predicted, scale_x, scale_y);
+}
+
+// Tracker boxes are in upright frame pixels; results are normalized to that frame
+std::vector<DetectionResult> YOLODetector::toResults(const std::vector<Object>& objects, float scale_x, float scale_y) {
+    std::vector<DetectionResult> results;
+    results.reserve(objects.size());
+    for(const auto& t_obj : objects) {
+        DetectionResult res;
+        res.classId = t_obj.label;
+        res.confidence = t_obj.prob;
+        res.x = t_obj.x * scale_x;
+        res.y = t_obj.y * scale_y;
+        res.width = t_obj.width * scale_x;
+        res.height = t_obj.height * scale_y;
+        res.trackId = t_obj.track_id;
+        results.push_back(res);
+    }
     return results;
 }
-    std::vector<DetectionResult> YOLODetector::detectFromImageProxy(JNIEnv* env, jobject imageProxy) {
-        auto start = std::chrono::high_resolution_clock::now();
-        std::vector<DetectionResult> results;
-        if (!modelLoaded) return results;
 
-        // Get ImageProxy width and height
-        jclass imageProxyClass = env->GetObjectClass(imageProxy);
-        jmethodID getWidth = env->GetMethodID(imageProxyClass, "getWidth", "()I");
-        jmethodID getHeight = env->GetMethodID(imageProxyClass, "getHeight", "()I");
-        int width = env->CallIntMethod(imageProxy, getWidth);
-        int height = env->CallIntMethod(imageProxy, getHeight);
+// --- Pipelined detection ---
+
+void YOLODetector::startPipeline(const ResultCallback& callback) {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    releasePipeline();
+    if (!modelLoaded) return;
+
+    pipeline_callback = callback;
+    pipeline = new FramePipeline(
+            [this](const PipelineFrame& frame, PipelineOutput& out) {
+                StageClock::time_point stage_start = StageClock::now();
+                ncnn::Extractor ex = net.create_extractor();
+                ex.input(model_info.input_name.c_str(), frame.input);
+                ex.extract(model_info.output_name.c_str(), out.output);
+                keyframes.reportDetectorLatency(elapsed_ms(stage_start));
+            },
+            [this](const PipelineOutput& out) {
+                applyPendingConfig();
+                std::vector<DetectionResult> results;
+                if (out.mode == FRAME_DETECT) {
+                    results = track(postprocess(out.output, out.transform), out.transform, out.timestamp_ns);
+                }
+                else if (out.mode == FRAME_EXTRAPOLATE) results = extrapolate(out.timestamp_ns);
+                else results = hold();
+                pipeline_callback(results, out.frame_id, out.timestamp_ns);
+            });
+    LOGD("Pipeline started");
+}
 
-        // Get Y plane (YUV_420_888)
-        jmethodID getPlanes = env->GetMethodID(imageProxyClass, "getPlanes", "()[Landroid/media/Image$Plane;");
-        jobjectArray planes = (jobjectArray)env->CallObjectMethod(imageProxy, getPlanes);
-        jobject yPlane = env->GetObjectArrayElement(planes, 0);
+void YOLODetector::stopPipeline() {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    releasePipeline();
+}
 
-        jclass planeClass = env->GetObjectClass(yPlane);
-        jmethodID getBuffer = env->GetMethodID(planeClass, "getBuffer", "()Ljava/nio/ByteBuffer;");
-        jobject yBuffer = env->CallObjectMethod(yPlane, getBuffer);
+void YOLODetector::releasePipeline() {
+    if (!pipeline) return;
+    AllocStats alloc = allocatorStats();
+    LOGD("Pipeline stopped: %lld submitted, %lld dropped, %lld finished, %lld/%lld allocations from system",
+         (long long)pipeline->framesSubmitted(), (long long)pipeline->framesDropped(),
+         (long long)pipeline->framesFinished(), (long long)alloc.system_allocs, (long long)alloc.requests);
+    delete pipeline; // joins the stage threads
+    pipeline = nullptr;
+    pipeline_callback = ResultCallback();
+}
 
-        unsigned char* yData = (unsigned char*)env->GetDirectBufferAddress(yBuffer);
-        if (!yData) return results;
+JpegStats YOLODetector::jpegStats() const {
+    std::lock_guard<std::mutex> lock(jpeg_stats_mutex);
+    return jpeg_stats;
+}
 
-        // --- Optimized Preprocessing ---
-        // Convert YUV420SP to RGB (reusing rgb_mat)
-        ncnn::yuv420sp2rgb(yData, width, height, this->rgb_mat);
+AllocStats YOLODetector::allocatorStats() const {
+    AllocStats blob = blob_pool.stats();
+    AllocStats workspace = workspace_pool.stats();
+    AllocStats total;
+    total.requests = blob.requests + workspace.requests;
+    total.system_allocs = blob.system_allocs + workspace.system_allocs;
+    total.system_frees = blob.system_frees + workspace.system_frees;
+    total.bytes_held = blob.bytes_held + workspace.bytes_held;
+    return total;
+}
+
+bool YOLODetector::submitRGBA(const unsigned char* pixels, int width, int height, int stride, int64_t timestamp_ns,
+                              int rotation) {
+    // Held while preprocessing so stopPipeline() cannot free the frame being written
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    if (!pipeline) return false;
+
+    PipelineFrame& frame = pipeline->beginFrame();
+    frame.mode = planFrame(timestamp_ns, pixels, width, height, stride, true);
+    if (frame.mode == FRAME_DETECT) {
+        frame.transform = makeInputTransform(width, height, rotation);
+        pipeline_preprocessor.fromRGBA(pixels, stride, frame.input, frame.transform);
+    }
+
+    pipeline->submitFrame(timestamp_ns);
+    return true;
+}
+
+bool YOLODetector::submitYUV420(const YUV420Image& img, int64_t timestamp_ns, int rotation) {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    if (!pipeline) return false;
+
+    PipelineFrame& frame = pipeline->beginFrame();
+    frame.mode = planFrame(timestamp_ns, img.y, img.width, img.height, img.y_row_stride, false);
+    if (frame.mode == FRAME_DETECT) {
+        frame.transform = makeInputTransform(img.width, img.height, rotation);
+        pipeline_preprocessor.fromYUV420(img, frame.input, frame.transform);
+    }
+
+    pipeline->submitFrame(timestamp_ns);
+    return true;
+}
+
+bool YOLODetector::submitJPEG(const unsigned char* data, size_t size, int64_t timestamp_ns, int rotation) {
+    std::lock_guard<std::mutex> lock(pipeline_mutex);
+    if (!pipeline) return false;
+
+    // Planned before a pipeline slot is taken: a JPEG the decoder rejects is not submitted and
+    // has not advanced the scheduler, so the caller's fallback submits it as a fresh frame
+    FrameMode mode;
+    YUV420Image img;
+    double decode_ms;
+    if (!planJPEG(timestamp_ns, pipeline_jpeg_decoder, data, size, rotation, mode, img, decode_ms)) return false;
+
+    PipelineFrame& frame = pipeline->beginFrame();
+    frame.mode = mode;
+    if (frame.mode == FRAME_DETECT) {
+        frame.transform = makeInputTransform(img.width, img.height, rotation);
+        pipeline_preprocessor.fromYUV420(img, frame.input, frame.transform);
+    }
+
+    pipeline->submitFrame(timestamp_ns);
+    return true;
+}
+
+    std::vector<DetectionResult> YOLODetector::detectYUV420(const YUV420Image& img, int64_t timestamp_ns, int rotation) {
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<DetectionResult> results;
+        if (!modelLoaded) return results;
+        applyPendingConfig();
+        if (timestamp_ns <= 0) timestamp_ns = now_ns();
+        FrameMode mode = planFrame(timestamp_ns, img.y, img.width, img.height, img.y_row_stride, false);
+        if (mode == FRAME_EXTRAPOLATE) return extrapolate(timestamp_ns);
+        if (mode == FRAME_HOLD) return hold();
+        stage_timings.keyframe = true;
+
+        const int width = img.width;
+        const int height = img.height;
 
-        // Preprocess: resize + normalize (reusing resized_input)
-        ncnn::resize_bilinear(this->rgb_mat, this->resized_input, INPUT_SIZE, INPUT_SIZE);
-        const float norm_vals[3] = {1.f/255.f, 1.f/255.f, 1.f/255.f};
-        this->resized_input.substract_mean_normalize(nullptr, norm_vals);
+        // --- Optimized Preprocessing ---
+        // Fused YUV->RGB + resize + normalize (+ letterbox) straight into resized_input
+        StageClock::time_point stage_start = StageClock::now();
+        this->input_transform = makeInputTransform(width, height, rotation);
+        input_preprocessor.fromYUV420(img, this->resized_input, this->input_transform);
+        stage_timings.preprocess_ms = elapsed_ms(stage_start);
 
         // Run inference
         ncnn::Mat output;
-        ncnn::Extractor ex = net.create_extractor();
-        ex.input("in0", this->resized_input);
-        ex.extract("out0", output);
+        extract(this->resized_input, output);
 
         // Postprocess detections
-        std::vector<DetectionResult> raw_detections = postprocess(output, width, height);
-
-        // --- Optimized ByteTrack Integration ---
-        std::vector<Object> tracker_objects;
-        for(const auto& det : raw_detections) {
-            Object obj;
-            obj.x = det.x;
-            obj.y = det.y;
-            obj.width = det.width;
-            obj.height = det.height;
-            obj.label = det.classId;
-            obj.prob = det.confidence;
-            tracker_objects.push_back(obj);
-        }
-        
-        frame_counter++;
-        std::vector<Object> tracked_objects;
-        if (frame_counter >= TRACKER_FRAME_SKIP) {
-            tracked_objects = tracker->update(tracker_objects);
-            last_tracked_objects = tracked_objects;
-            frame_counter = 0; // Reset counter
-        } else {
-            tracked_objects = last_tracked_objects; // Use stale tracks
-        }
-        
-        for(const auto& t_obj : tracked_objects) {
-            DetectionResult res;
-            res.classId = t_obj.label;
-            res.confidence = t_obj.prob;
-            res.x = t_obj.x;
-            res.y = t_obj.y;
-            res.width = t_obj.width;
-            res.height = t_obj.height;
-            res.trackId = t_obj.track_id;
-            results.push_back(res);
-        }
+        const std::vector<DetectionResult>& raw_detections = postprocess(output, this->input_transform);
+
+        results = track(raw_detections, this->input_transform, timestamp_ns);
 
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
         float fps = 1000.0f / (duration > 0 ? duration : 1);
-        LOGD("ImageProxy Inference time: %lld ms, FPS: %.2f", duration, fps);
+        LOGD("YUV Inference time: %lld ms, FPS: %.2f", (long long)duration, fps);
 
         return results;
-    }
\ No newline at end of file
+    }
+
+bool YOLODetector::detectJPEG(const unsigned char* data, size_t size, std::vector<DetectionResult>& results,
+                              int64_t timestamp_ns, int rotation) {
+    auto start = std::chrono::high_resolution_clock::now();
+    results.clear();
+    if (!modelLoaded) return true;
+    applyPendingConfig();
+    if (timestamp_ns <= 0) timestamp_ns = now_ns();
+    FrameMode mode;
+    YUV420Image img;
+    double decode_ms;
+    if (!planJPEG(timestamp_ns, jpeg_decoder, data, size, rotation, mode, img, decode_ms)) return false;
+    if (mode == FRAME_EXTRAPOLATE) {
+        results = extrapolate(timestamp_ns);
+        return true;
+    }
+    if (mode == FRAME_HOLD) {
+        results = hold();
+        stage_timings.jpeg_ms = decode_ms;
+        return true;
+    }
+    stage_timings.keyframe = true;
+    stage_timings.jpeg_ms = decode_ms;
+
+    // Fused YUV->RGB + resize + normalize (+ letterbox) from the decoder's planes; boxes come
+    // out normalized, so the IDCT scale does not show in the results
+    StageClock::time_point stage_start = StageClock::now();
+    this->input_transform = makeInputTransform(img.width, img.height, rotation);
+    input_preprocessor.fromYUV420(img, this->resized_input, this->input_transform);
+    stage_timings.preprocess_ms = elapsed_ms(stage_start);
+
+    ncnn::Mat output;
+    extract(this->resized_input, output);
+    const std::vector<DetectionResult>& raw_detections = postprocess(output, this->input_transform);
+    results = track(raw_detections, this->input_transform, timestamp_ns);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    LOGD("JPEG %dx%d decode: %.2f ms, inference time: %lld ms", img.width, img.height, decode_ms,
+         (long long)duration);
+
+    return true;
+}
\ No newline at end of file
@@ -29,6 +29,7 @@ import androidx.compose.ui.unit.dp
 import androidx.compose.ui.viewinterop.AndroidView
 import androidx.core.content.ContextCompat
 import java.util.*
+import java.util.concurrent.Executors
 import android.util.Log
 import androidx.compose.ui.graphics.nativeCanvas
 
@@ -36,11 +37,23 @@ import androidx.compose.ui.graphics.nativeCanvas
 fun CameraPreview(
     detector: YOLODetector,
     selectedObject: String,
-    onDetections: (List<DetectionResult>, Int) -> Unit
+    onDetections: PackedDetectionListener
 ) {
     val context = LocalContext.current
     val lifecycleOwner = LocalLifecycleOwner.current
     val previewView = remember { PreviewView(context) }
+    val analysisExecutor = remember { Executors.newSingleThreadExecutor() }
+    val latestOnDetections by rememberUpdatedState(onDetections)
+
+    DisposableEffect(detector) {
+        detector.startPipeline(DetectionBuffer()) { results, frameId, timestampNs ->
+            latestOnDetections.onDetections(results, frameId, timestampNs)
+        }
+        onDispose {
+            detector.stopPipeline()
+            analysisExecutor.shutdown()
+        }
+    }
 
     LaunchedEffect(previewView) {
         val cameraProviderFuture = ProcessCameraProvider.getInstance(context)
@@ -53,12 +66,13 @@ fun CameraPreview(
 
                 val imageAnalysis = ImageAnalysis.Builder()
                     .setBackpressureStrategy(ImageAnalysis.STRATEGY_KEEP_ONLY_LATEST)
+                    .setOutputImageFormat(ImageAnalysis.OUTPUT_IMAGE_FORMAT_YUV_420_888)
                     .build()
 
-                imageAnalysis.setAnalyzer(ContextCompat.getMainExecutor(context)) { imageProxy ->
-                    val bitmap = imageProxy.toBitmap()
-                    val detections = detector.detect(bitmap)
-                    onDetections(detections, imageProxy.imageInfo.rotationDegrees)
+                // The analyzer only hands the YUV planes over; rotation is applied natively and results
+                // come back upright through the pipeline listener
+                imageAnalysis.setAnalyzer(analysisExecutor) { imageProxy ->
+                    detector.submit(imageProxy)
                     imageProxy.close()
                 }
 
@@ -11,9 +11,11 @@ import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.platform.LocalContext
 import androidx.compose.ui.unit.dp
+import java.nio.ByteBuffer
 
 @Composable
 fun CameraScreen(
+    onJpeg: (jpeg: ByteBuffer, timestampNs: Long) -> Boolean = { _, _ -> false },
     onFrame: (Bitmap) -> Unit
 ) {
     val context = LocalContext.current
@@ -44,7 +46,7 @@ fun CameraScreen(
                 val service = discoveryState.second
                 if (service != null) {
                     // We found the service, now connect to the stream
-                    ESP32CameraStream(streamUrl = service.getStreamUrl(), onFrame = onFrame)
+                    ESP32CameraStream(streamUrl = service.getStreamUrl(), onJpeg = onJpeg, onFrame = onFrame)
                 } else {
                     // This case should ideally not happen if status is FOUND
                     ErrorView(message = "Service found but information is missing.") {
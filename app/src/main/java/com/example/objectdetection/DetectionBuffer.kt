@@ -0,0 +1,52 @@
+package com.example.objectdetection
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+// Reusable native-ordered result buffer: the detector writes packed records straight into it,
+// so a frame's results cost no Java allocations. Record layout (RECORD_BYTES each):
+// int classId, float confidence, x, y, width, height, int trackId
+class DetectionBuffer(val capacity: Int = 64) {
+    val buffer: ByteBuffer = ByteBuffer.allocateDirect(capacity * RECORD_BYTES).order(ByteOrder.nativeOrder())
+
+    // Detections of the last frame; may exceed capacity, in which case only the first
+    // capacity records were written
+    var count: Int = 0
+        internal set
+
+    val size: Int get() = minOf(count, capacity)
+
+    fun classId(i: Int): Int = buffer.getInt(i * RECORD_BYTES)
+    fun confidence(i: Int): Float = buffer.getFloat(i * RECORD_BYTES + 4)
+    fun x(i: Int): Float = buffer.getFloat(i * RECORD_BYTES + 8)
+    fun y(i: Int): Float = buffer.getFloat(i * RECORD_BYTES + 12)
+    fun width(i: Int): Float = buffer.getFloat(i * RECORD_BYTES + 16)
+    fun height(i: Int): Float = buffer.getFloat(i * RECORD_BYTES + 20)
+    fun trackId(i: Int): Int = buffer.getInt(i * RECORD_BYTES + 24)
+
+    // Copies other's records with absolute gets and puts, so no buffer views are created
+    fun copyFrom(other: DetectionBuffer) {
+        val n = minOf(other.size, capacity)
+        for (offset in 0 until n * RECORD_BYTES step 4) buffer.putInt(offset, other.buffer.getInt(offset))
+        count = if (n < capacity) n else other.count
+    }
+
+    fun toList(): List<DetectionResult> = List(size) {
+        DetectionResult(classId(it), confidence(it), x(it), y(it), width(it), height(it), trackId(it))
+    }
+
+    companion object {
+        const val RECORD_BYTES = 28
+    }
+}
+
+// Pipelined results written into a DetectionBuffer. Called on a native worker thread; the
+// buffer is overwritten by the next frame, so copy out what must outlive the callback.
+fun interface PackedDetectionListener {
+    fun onDetections(results: DetectionBuffer, frameId: Long, timestampNs: Long)
+}
+
+// Native side of PackedDetectionListener; only the record count crosses JNI
+internal fun interface PackedResultsCallback {
+    fun onPackedResults(count: Int, frameId: Long, timestampNs: Long)
+}
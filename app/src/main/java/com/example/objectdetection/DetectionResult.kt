@@ -1,5 +1,6 @@
 package com.example.objectdetection
 
+// Box in normalized [0, 1] coordinates of the upright frame (camera rotation already applied)
 data class DetectionResult(
     val classId: Int,
     val confidence: Float,
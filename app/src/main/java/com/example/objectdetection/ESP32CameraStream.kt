@@ -14,12 +14,13 @@ import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.asImageBitmap
 import androidx.compose.ui.unit.dp
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.awaitCancellation
+import kotlinx.coroutines.cancelAndJoin
 import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
-import java.io.BufferedInputStream
-import java.io.ByteArrayOutputStream
-import java.net.HttpURLConnection
-import java.net.URL
+import java.nio.ByteBuffer
 
 enum class StreamState {
     CONNECTING,
@@ -30,6 +31,9 @@ enum class StreamState {
 @Composable
 fun ESP32CameraStream(
     streamUrl: String, // The URL is now a parameter
+    // Sees every JPEG as the native frame view, only valid during the call, before it is decoded
+    // for display; returning true means it was consumed there and onFrame is skipped
+    onJpeg: (jpeg: ByteBuffer, timestampNs: Long) -> Boolean = { _, _ -> false },
     onFrame: (Bitmap) -> Unit
 ) {
     var bitmap by remember { mutableStateOf<Bitmap?>(null) }
@@ -39,49 +43,39 @@ fun ESP32CameraStream(
     LaunchedEffect(streamUrl, retryTrigger) {
         streamState = StreamState.CONNECTING
         withContext(Dispatchers.IO) {
-            var connection: HttpURLConnection? = null
+            val stream = MjpegStream()
+            if (!stream.open(streamUrl)) {
+                streamState = StreamState.ERROR
+                return@withContext
+            }
+            // Leaving the effect unblocks a read in progress instead of waiting out the timeout
+            val canceller = launch {
+                try {
+                    awaitCancellation()
+                } finally {
+                    stream.cancel()
+                }
+            }
             try {
-                val url = URL(streamUrl)
-                connection = url.openConnection() as HttpURLConnection
-                connection.connectTimeout = 5000
-                connection.readTimeout = 5000
-                connection.doInput = true
-                connection.connect()
-
-                val responseCode = connection.responseCode
-                if (responseCode == HttpURLConnection.HTTP_OK) {
-                    val inputStream = BufferedInputStream(connection.inputStream)
-                    val boundary = "--" + connection.contentType.substringAfter("boundary=").trim()
-                    val boundaryBytes = boundary.toByteArray(Charsets.UTF_8)
-                    
-                    streamState = StreamState.CONNECTED
+                // Frames are split natively; only the JPEG itself is copied out for decoding
+                var jpeg = ByteArray(0)
+                var frames = 0
+                while (isActive) {
+                    val frame = stream.next() ?: break
+                    val consumed = onJpeg(frame, System.nanoTime())
+                    val size = frame.remaining()
+                    if (jpeg.size < size) jpeg = ByteArray(size + size / 2)
+                    frame.get(jpeg, 0, size)
 
-                    while (isActive) {
-                        // Find the start of the next part
-                        val frameBytes = findNextFrame(inputStream, boundaryBytes)
-                        if (frameBytes != null) {
-                            // Find the start of the JPEG image data
-                            val jpegStart = findJpegStart(frameBytes)
-                            if (jpegStart != -1) {
-                                val newBitmap = BitmapFactory.decodeByteArray(frameBytes, jpegStart, frameBytes.size - jpegStart)
-                                if (newBitmap != null) {
-                                    bitmap = newBitmap
-                                    onFrame(newBitmap)
-                                }
-                            }
-                        } else {
-                            // End of stream
-                            break
-                        }
-                    }
-                } else {
-                    streamState = StreamState.ERROR
+                    val newBitmap = BitmapFactory.decodeByteArray(jpeg, 0, size) ?: continue
+                    if (frames++ == 0) streamState = StreamState.CONNECTED
+                    bitmap = newBitmap
+                    if (!consumed) onFrame(newBitmap)
                 }
-            } catch (e: Exception) {
-                e.printStackTrace()
-                streamState = StreamState.ERROR
+                if (frames == 0 && isActive) streamState = StreamState.ERROR
             } finally {
-                connection?.disconnect()
+                withContext(NonCancellable) { canceller.cancelAndJoin() }
+                stream.release()
             }
         }
     }
@@ -117,37 +111,3 @@ fun ESP32CameraStream(
         }
     }
 }
-
-private fun findNextFrame(inputStream: BufferedInputStream, boundary: ByteArray): ByteArray? {
-    val buffer = ByteArrayOutputStream()
-    var matchCount = 0
-    var b: Int
-
-    while (true) {
-        b = inputStream.read()
-        if (b == -1) {
-            return null // End of stream
-        }
-        buffer.write(b)
-
-        if (b == boundary[matchCount].toInt()) {
-            matchCount++
-            if (matchCount == boundary.size) {
-                // Found a boundary, return the frame data collected so far (excluding the boundary)
-                val frameData = buffer.toByteArray()
-                return frameData.copyOfRange(0, frameData.size - boundary.size)
-            }
-        } else {
-            matchCount = 0
-        }
-    }
-}
-
-private fun findJpegStart(data: ByteArray): Int {
-    for (i in 0 until data.size - 1) {
-        if (data[i] == 0xFF.toByte() && data[i + 1] == 0xD8.toByte()) {
-            return i
-        }
-    }
-    return -1
-}
@@ -0,0 +1,45 @@
+package com.example.objectdetection
+
+import androidx.compose.runtime.mutableIntStateOf
+import java.util.concurrent.atomic.AtomicInteger
+
+// Newest pipelined results for the UI, handed from the native worker thread to the main thread
+// without per-frame objects. Three preallocated buffers rotate as in the native FrameSlot: the
+// worker copies into its back buffer and publishes it as the middle one, the main thread swaps
+// the middle one in as front. A frame the UI has not taken yet is replaced by the next one.
+class LatestDetections(capacity: Int = 64) {
+    private val slots = Array(3) { DetectionBuffer(capacity) }
+    private val middle = AtomicInteger(1) // index | FRESH
+    private var back = 2                  // worker thread only
+    private var frontIndex = 0            // main thread only
+    private val versionState = mutableIntStateOf(0)
+
+    // Main thread. Reading it while composing or drawing subscribes to updates.
+    val front: DetectionBuffer
+        get() {
+            versionState.intValue // the read is the subscription
+            return slots[frontIndex]
+        }
+
+    // Main thread. Changes whenever front does, e.g. as an effect key.
+    val version: Int get() = versionState.intValue
+
+    // Worker thread, e.g. from a PackedDetectionListener
+    fun publish(results: DetectionBuffer) {
+        slots[back].copyFrom(results)
+        back = middle.getAndSet(back or FRESH) and INDEX
+    }
+
+    // Main thread. Returns false when nothing new was published.
+    fun swap(): Boolean {
+        if ((middle.get() and FRESH) == 0) return false
+        frontIndex = middle.getAndSet(frontIndex) and INDEX
+        versionState.intValue++
+        return true
+    }
+
+    private companion object {
+        const val INDEX = 3
+        const val FRESH = 4
+    }
+}
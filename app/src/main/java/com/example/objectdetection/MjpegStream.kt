@@ -0,0 +1,47 @@
+package com.example.objectdetection
+
+import java.net.URI
+import java.nio.ByteBuffer
+
+// multipart/x-mixed-replace MJPEG client (ESP32-CAM /stream) backed by the native demuxer.
+// Frames are split without copying; the buffer returned by next() is a view of native memory
+// that is only valid until the following next() or release().
+class MjpegStream {
+    private var nativePtr: Long = 0
+
+    private external fun openStream(host: String, port: Int, path: String, timeoutMs: Int): Long
+    private external fun nextFrame(nativePtr: Long): ByteBuffer?
+    private external fun cancelStream(nativePtr: Long)
+    private external fun releaseStream(nativePtr: Long)
+
+    // timeoutMs bounds the connect and every read, so a silent camera ends the stream
+    fun open(url: String, timeoutMs: Int = 5000): Boolean {
+        val uri = URI(url)
+        val host = uri.host ?: return false
+        val port = if (uri.port != -1) uri.port else 80
+        val path = (uri.rawPath?.takeIf { it.isNotEmpty() } ?: "/") + (uri.rawQuery?.let { "?$it" } ?: "")
+        nativePtr = openStream(host, port, path, timeoutMs)
+        return nativePtr != 0L
+    }
+
+    // Next JPEG, or null at the end of the stream, on errors and after cancel(). Blocks.
+    fun next(): ByteBuffer? {
+        return if (nativePtr != 0L) nextFrame(nativePtr) else null
+    }
+
+    // Unblocks a next() in progress on another thread; release() must still follow
+    fun cancel() {
+        if (nativePtr != 0L) cancelStream(nativePtr)
+    }
+
+    fun release() {
+        if (nativePtr != 0L) releaseStream(nativePtr)
+        nativePtr = 0
+    }
+
+    companion object {
+        init {
+            System.loadLibrary("yolo11ncnn")
+        }
+    }
+}
@@ -37,63 +37,23 @@ data class TransformedBox(
 )
 
 /**
- * Transforms the bounding box coordinates from the detector's coordinate system
- * (based on the rotated bitmap) to the screen's coordinate system (Canvas overlay).
+ * Scales a detection to the screen's coordinate system (Canvas overlay). The detector
+ * already returns boxes normalized to the upright frame, so only the overlay size matters.
  * * @param det The raw detection result.
- * @param srcWidth The width of the source bitmap (ImageProxy.width).
- * @param srcHeight The height of the source bitmap (ImageProxy.height).
- * @param rotationDegrees The rotation of the image (ImageProxy.imageInfo.rotationDegrees).
  * @param targetWidth The width of the Canvas overlay.
  * @param targetHeight The height of the Canvas overlay.
  */
 fun transformCoordinates(
     det: DetectionResult,
-    srcWidth: Int,
-    srcHeight: Int,
-    rotationDegrees: Int,
     targetWidth: Float,
     targetHeight: Float
 ): TransformedBox {
-    // 1. Normalize Bounding Box coordinates based on source dimensions
-    val normalizedLeft = det.x / srcWidth
-    val normalizedTop = det.y / srcHeight
-    val normalizedRight = (det.x + det.width) / srcWidth
-    val normalizedBottom = (det.y + det.height) / srcHeight
-
-    var left = 0f
-    var top = 0f
-    var right = 0f
-    var bottom = 0f
-
-    // 2. Rotate the Normalized Coordinates
-    when (rotationDegrees) {
-        0 -> { // No rotation
-            left = normalizedLeft
-            top = normalizedTop
-            right = normalizedRight
-            bottom = normalizedBottom
-        }
-        90 -> { // Rotated 90 degrees clockwise (Image is taller)
-            left = 1f - normalizedBottom
-            top = normalizedLeft
-            right = 1f - normalizedTop
-            bottom = normalizedRight
-        }
-        180 -> { // Rotated 180 degrees
-            left = 1f - normalizedRight
-            top = 1f - normalizedBottom
-            right = 1f - normalizedLeft
-            bottom = 1f - normalizedTop
-        }
-        270 -> { // Rotated 270 degrees clockwise (Image is taller)
-            left = normalizedTop
-            top = 1f - normalizedRight
-            right = normalizedBottom
-            bottom = 1f - normalizedLeft
-        }
-    }
+    val left = det.x
+    val top = det.y
+    val right = det.x + det.width
+    val bottom = det.y + det.height
 
-    // 3. Scale the Rotated Normalized Coordinates to the Canvas Size
+    // Scale the normalized coordinates to the Canvas size
     val finalLeft = left * targetWidth
     val finalTop = top * targetHeight
     val finalWidth = (right - left) * targetWidth
@@ -103,7 +63,7 @@ fun transformCoordinates(
     val centerX = finalLeft + (finalWidth / 2)
     val direction = getDirection(centerX, targetWidth)
 
-    // 4. Construct the label with the class name
+    // Construct the label with the class name
     val labelName = getLabel(det.classId)
 
     return TransformedBox(
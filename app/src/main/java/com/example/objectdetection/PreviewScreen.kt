@@ -17,6 +17,7 @@ import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.Color
 import androidx.compose.ui.platform.LocalContext
 import androidx.compose.ui.unit.dp
+import androidx.core.content.ContextCompat
 import androidx.compose.ui.geometry.Offset
 import androidx.compose.ui.geometry.Size
 import androidx.compose.ui.graphics.drawscope.Stroke
@@ -26,9 +27,7 @@ import com.example.objectdetection.SocketManager
 import com.example.objectdetection.TrackedObject
 import kotlin.math.abs
 import kotlin.math.pow
-import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
-import kotlinx.coroutines.withContext
 import java.io.PrintWriter
 import java.net.Socket
 
@@ -48,20 +47,40 @@ fun PreviewScreen(
     initialSelectedItem: String,
     selectedCamera: Camera
 ) {
-    var detections by remember { mutableStateOf<List<DetectionResult>>(emptyList()) }
     var selectedItem by remember { mutableStateOf(initialSelectedItem) }
     val context = LocalContext.current
+    // Pipelined results are copied into preallocated buffers on the worker thread and swapped in
+    // on the main thread by one reused Runnable, so a frame creates no result objects
+    val latest = remember { LatestDetections() }
+    val mainExecutor = remember { ContextCompat.getMainExecutor(context) }
+    val showLatest = remember { Runnable { latest.swap() } }
+    val onDetections = remember {
+        PackedDetectionListener { results, _, _ ->
+            latest.publish(results)
+            mainExecutor.execute(showLatest)
+        }
+    }
     val tts = remember {
         TextToSpeech(context, null)
     }
     var highlightAll by remember { mutableStateOf(false) }
     var triggerSpeak by remember { mutableStateOf(false) }
-    var rotationDegrees by remember { mutableStateOf(0) }
     var trackedObjects by remember { mutableStateOf<List<TrackedObject>>(emptyList()) }
     val screenWidth = LocalContext.current.resources.displayMetrics.widthPixels
     val screenHeight = LocalContext.current.resources.displayMetrics.heightPixels
     val coroutineScope = rememberCoroutineScope()
 
+    // Search mode only ever reports household and dangerous items, so skip every other class natively.
+    // It is used indoors facing mostly static scenes, so unchanged frames skip inference too.
+    DisposableEffect(isPreview, dangerousItems) {
+        detector.setClassFilter(if (isPreview) emptyList() else HOUSE_CLASSES + dangerousItems)
+        detector.setMotionGate(!isPreview)
+        onDispose {
+            detector.setClassFilter(emptyList())
+            detector.setMotionGate(false)
+        }
+    }
+
     LaunchedEffect(isPreview) {
         ArduinoConnector.messages.collect { message ->
             when (message) {
@@ -94,12 +113,9 @@ fun PreviewScreen(
 
     LaunchedEffect(triggerSpeak) {
         if (triggerSpeak) {
-            val transformedBoxes = detections.map {
+            val transformedBoxes = latest.front.toList().map {
                 transformCoordinates(
                     det = it,
-                    srcWidth = 640,
-                    srcHeight = 640,
-                    rotationDegrees = rotationDegrees,
                     targetWidth = screenWidth.toFloat(),
                     targetHeight = screenHeight.toFloat()
                 )
@@ -129,13 +145,10 @@ fun PreviewScreen(
         }
     }
 
-    LaunchedEffect(detections, selectedItem) {
-        val allTransformedBoxes = detections.map {
+    LaunchedEffect(latest.version, selectedItem) {
+        val allTransformedBoxes = latest.front.toList().map {
             transformCoordinates(
                 det = it,
-                srcWidth = 640,
-                srcHeight = 640,
-                rotationDegrees = rotationDegrees,
                 targetWidth = screenWidth.toFloat(),
                 targetHeight = screenHeight.toFloat()
             ) to it
@@ -201,40 +214,36 @@ fun PreviewScreen(
                 CameraPreview(
                     detector = detector,
                     selectedObject = selectedItem,
-                    onDetections = { dets, rotation ->
-                        detections = dets
-                        rotationDegrees = rotation
-                    }
+                    onDetections = onDetections
                 )
             }
             Camera.ESP32 -> {
-                CameraScreen(onFrame = { bitmap ->
-                    coroutineScope.launch(Dispatchers.Default) {
-                        val result = detector.detect(bitmap)
-                        withContext(Dispatchers.Main) {
-                            detections = result
-                        }
+                // JPEGs are decoded natively, downscaled in the IDCT, on the stream thread and
+                // inferred on the pipeline's threads; BitmapFactory only decodes for display,
+                // unless the native decoder rejects the stream (e.g. progressive JPEG)
+                DisposableEffect(detector) {
+                    detector.startPipeline(DetectionBuffer(), onDetections)
+                    onDispose {
+                        detector.stopPipeline()
                     }
-                })
+                }
+                CameraScreen(
+                    onJpeg = { jpeg, timestampNs -> detector.submit(jpeg, timestampNs) },
+                    onFrame = { bitmap -> detector.submit(bitmap) }
+                )
             }
         }
         Canvas(modifier = Modifier.fillMaxSize()) {
-            detections.forEach { det ->
-                val label = getLabel(det.classId)
+            // Straight from the packed records: same scaling as transformCoordinates, no boxes or labels built
+            val dets = latest.front
+            for (i in 0 until dets.size) {
+                val label = getLabel(dets.classId(i))
                 val shouldHighlight = highlightAll || label == selectedItem || dangerousItems.contains(label)
                 if (shouldHighlight) {
-                    val transformedBox = transformCoordinates(
-                        det = det,
-                        srcWidth = 640,
-                        srcHeight = 640,
-                        rotationDegrees = rotationDegrees,
-                        targetWidth = size.width,
-                        targetHeight = size.height
-                    )
                     drawRect(
                         color = if (dangerousItems.contains(label)) DangerRed else Color.Green,
-                        topLeft = Offset(transformedBox.left, transformedBox.top),
-                        size = Size(transformedBox.width, transformedBox.height),
+                        topLeft = Offset(dets.x(i) * size.width, dets.y(i) * size.height),
+                        size = Size(dets.width(i) * size.width, dets.height(i) * size.height),
                         style = Stroke(width = 3.dp.toPx())
                     )
                 }
@@ -2,25 +2,203 @@ package com.example.objectdetection
 
 import android.content.res.AssetManager
 import android.graphics.Bitmap
+import android.os.SystemClock
+import androidx.camera.core.ImageProxy
+import java.nio.ByteBuffer
+import kotlin.math.abs
+
+// Receives pipelined results on a native worker thread, newest frame only
+fun interface DetectionListener {
+    fun onDetections(results: Array<DetectionResult>, frameId: Long, timestampNs: Long)
+}
 
 class YOLODetector {
     private var nativePtr: Long = 0
 
     external fun initDetector(): Long
     external fun loadModel(nativePtr: Long, assetManager: AssetManager, paramPath: String, binPath: String): Boolean
-    external fun detectFromBitmap(nativePtr: Long, bitmap: Bitmap): Array<DetectionResult>
+    external fun detectFromBitmap(nativePtr: Long, bitmap: Bitmap, timestampNs: Long): Array<DetectionResult>
+    external fun detectFromPlanes(
+        nativePtr: Long, y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+        yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, width: Int, height: Int, rotationDegrees: Int,
+        timestampNs: Long
+    ): Array<DetectionResult>
+    external fun detectFromJpeg(
+        nativePtr: Long, jpeg: ByteBuffer, offset: Int, length: Int, rotationDegrees: Int, timestampNs: Long
+    ): Array<DetectionResult>?
+    external fun detectIntoBuffer(nativePtr: Long, bitmap: Bitmap, timestampNs: Long, out: ByteBuffer): Int
+    external fun detectPlanesIntoBuffer(
+        nativePtr: Long, y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+        yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, width: Int, height: Int, rotationDegrees: Int,
+        timestampNs: Long, out: ByteBuffer
+    ): Int
+    external fun detectJpegIntoBuffer(
+        nativePtr: Long, jpeg: ByteBuffer, offset: Int, length: Int, rotationDegrees: Int, timestampNs: Long,
+        out: ByteBuffer
+    ): Int
+    external fun predictTo(nativePtr: Long, timestampNs: Long): Array<DetectionResult>
+    external fun setLetterbox(nativePtr: Long, enabled: Boolean, rect: Boolean)
+    external fun setClassFilter(nativePtr: Long, classIds: IntArray)
+    external fun setKeyframeInterval(nativePtr: Long, maxFrames: Int)
+    external fun setMotionGate(nativePtr: Long, enabled: Boolean, maxStaleMs: Int)
+    external fun startPipeline(nativePtr: Long, listener: DetectionListener)
+    private external fun startPipelinePacked(nativePtr: Long, out: ByteBuffer, callback: PackedResultsCallback)
+    external fun submitBitmap(nativePtr: Long, bitmap: Bitmap, timestampNs: Long): Boolean
+    external fun submitPlanes(
+        nativePtr: Long, y: ByteBuffer, u: ByteBuffer, v: ByteBuffer,
+        yRowStride: Int, uvRowStride: Int, uvPixelStride: Int, width: Int, height: Int, rotationDegrees: Int,
+        timestampNs: Long
+    ): Boolean
+    external fun submitJpeg(
+        nativePtr: Long, jpeg: ByteBuffer, offset: Int, length: Int, rotationDegrees: Int, timestampNs: Long
+    ): Boolean
+    external fun stopPipeline(nativePtr: Long)
+    external fun getAllocatorStats(nativePtr: Long): LongArray
+    external fun getJpegStats(nativePtr: Long): LongArray
     external fun releaseDetector(nativePtr: Long)
 
-    fun initialize(assetManager: AssetManager): Boolean {
+    // modelName is the asset prefix, e.g. "yolo26n" loads yolo26n.ncnn.param / yolo26n.ncnn.bin.
+    // Dense (YOLOv8/11) and end-to-end (YOLO26) heads are detected natively at load time.
+    fun initialize(assetManager: AssetManager, modelName: String = "model"): Boolean {
         nativePtr = initDetector()
-        return loadModel(nativePtr, assetManager, "model.ncnn.param", "model.ncnn.bin")
+        return loadModel(nativePtr, assetManager, "$modelName.ncnn.param", "$modelName.ncnn.bin")
+    }
+
+    // timestampNs is the capture time on the System.nanoTime() clock, the one every timestamp
+    // here uses (ImageProxy timestamps are converted to it); tracking integrates motion over it
+    fun detect(bitmap: Bitmap, timestampNs: Long = System.nanoTime()): List<DetectionResult> {
+        return detectFromBitmap(nativePtr, bitmap, timestampNs).toList()
+    }
+
+    // YUV_420_888 camera frame, converted natively from its planes (I420 or NV21/NV12 layout) and
+    // turned upright by its rotationDegrees while it is scaled; the image may be closed as soon as
+    // this returns
+    fun detect(image: ImageProxy, timestampNs: Long = captureTimeNs(image)): List<DetectionResult> {
+        val planes = image.planes
+        return detectFromPlanes(
+            nativePtr, planes[0].buffer, planes[1].buffer, planes[2].buffer,
+            planes[0].rowStride, planes[1].rowStride, planes[1].pixelStride, image.width, image.height,
+            image.imageInfo.rotationDegrees, timestampNs
+        ).toList()
     }
 
-    fun detect(bitmap: Bitmap): List<DetectionResult> {
-        return detectFromBitmap(nativePtr,bitmap).toList()
+    // JPEG frame in a direct buffer (e.g. from MjpegStream.next()), position to limit. Decoded
+    // natively at the smallest scale that still covers the network input, with no Bitmap in
+    // between; null if it is not a baseline JPEG the native decoder handles (decode it with
+    // BitmapFactory and use detect(bitmap) then)
+    fun detect(jpeg: ByteBuffer, timestampNs: Long = System.nanoTime(), rotationDegrees: Int = 0): List<DetectionResult>? {
+        return detectFromJpeg(nativePtr, jpeg, jpeg.position(), jpeg.remaining(), rotationDegrees, timestampNs)?.toList()
+    }
+
+    // Allocation-free variants: results are written into out, which is reused across frames
+    fun detect(bitmap: Bitmap, out: DetectionBuffer, timestampNs: Long = System.nanoTime()): Int {
+        out.count = detectIntoBuffer(nativePtr, bitmap, timestampNs, out.buffer)
+        return out.size
+    }
+
+    fun detect(image: ImageProxy, out: DetectionBuffer, timestampNs: Long = captureTimeNs(image)): Int {
+        val planes = image.planes
+        out.count = detectPlanesIntoBuffer(
+            nativePtr, planes[0].buffer, planes[1].buffer, planes[2].buffer,
+            planes[0].rowStride, planes[1].rowStride, planes[1].pixelStride, image.width, image.height,
+            image.imageInfo.rotationDegrees, timestampNs, out.buffer
+        )
+        return out.size
+    }
+
+    // -1 (out untouched) for JPEGs the native decoder does not handle, as detect(jpeg) returns null
+    fun detect(jpeg: ByteBuffer, out: DetectionBuffer, timestampNs: Long = System.nanoTime(), rotationDegrees: Int = 0): Int {
+        val count = detectJpegIntoBuffer(
+            nativePtr, jpeg, jpeg.position(), jpeg.remaining(), rotationDegrees, timestampNs, out.buffer
+        )
+        if (count < 0) return -1
+        out.count = count
+        return out.size
+    }
+
+    // Tracked boxes extrapolated to timestampNs (same clock as the frames), e.g. the time the
+    // next overlay is drawn, so the boxes do not trail the scene by the inference latency
+    fun predictTo(timestampNs: Long = System.nanoTime()): List<DetectionResult> {
+        return predictTo(nativePtr, timestampNs).toList()
+    }
+
+    // rect = true needs a model exported at the rectangular (or a dynamic) input shape
+    fun setLetterbox(enabled: Boolean, rect: Boolean = false) {
+        setLetterbox(nativePtr, enabled, rect)
+    }
+
+    // Only these labels are decoded natively; an empty list turns the filter off
+    fun setClassFilter(labels: List<String>) {
+        val ids = labels.map { YOLO_CLASSES.indexOf(it) }.filter { it >= 0 }.distinct()
+        setClassFilter(nativePtr, ids.toIntArray())
+    }
+
+    // Keyframe mode: the network runs on at most every maxFrames-th frame and tracked boxes are
+    // extrapolated natively on the frames in between; the interval adapts to inference latency
+    // and scene motion. 1 (the default) runs inference on every frame.
+    fun setKeyframeInterval(maxFrames: Int) {
+        setKeyframeInterval(nativePtr, maxFrames)
+    }
+
+    // Motion gate: while the camera sees an unchanged scene, inference is skipped and the last
+    // tracked boxes are returned; inference still runs at least every maxStaleMs
+    fun setMotionGate(enabled: Boolean, maxStaleMs: Int = 1000) {
+        setMotionGate(nativePtr, enabled, maxStaleMs)
+    }
+
+    // Pipelined mode: submit() only preprocesses and returns; inference, NMS and tracking run on
+    // native threads and the newest result is handed to the listener. Stale frames are dropped.
+    fun startPipeline(listener: DetectionListener) {
+        startPipeline(nativePtr, listener)
+    }
+
+    // Same, but every frame's results are written into the one buffer and no result objects are
+    // created; the listener must finish reading before it returns
+    fun startPipeline(results: DetectionBuffer, listener: PackedDetectionListener) {
+        startPipelinePacked(nativePtr, results.buffer) { count, frameId, timestampNs ->
+            results.count = count
+            listener.onDetections(results, frameId, timestampNs)
+        }
+    }
+
+    fun submit(bitmap: Bitmap, timestampNs: Long = System.nanoTime()): Boolean {
+        return submitBitmap(nativePtr, bitmap, timestampNs)
+    }
+
+    // Preprocesses the planes before returning, so the image may be closed right after
+    fun submit(image: ImageProxy, timestampNs: Long = captureTimeNs(image)): Boolean {
+        val planes = image.planes
+        return submitPlanes(
+            nativePtr, planes[0].buffer, planes[1].buffer, planes[2].buffer,
+            planes[0].rowStride, planes[1].rowStride, planes[1].pixelStride, image.width, image.height,
+            image.imageInfo.rotationDegrees, timestampNs
+        )
+    }
+
+    // Decodes and preprocesses before returning, so the buffer may be reused right after;
+    // false for JPEGs the native decoder does not handle, as detect(jpeg)
+    fun submit(jpeg: ByteBuffer, timestampNs: Long, rotationDegrees: Int = 0): Boolean {
+        return submitJpeg(nativePtr, jpeg, jpeg.position(), jpeg.remaining(), rotationDegrees, timestampNs)
+    }
+
+    fun stopPipeline() {
+        stopPipeline(nativePtr)
+    }
+
+    // Native blob/workspace pool counters: [requests, systemAllocs, systemFrees, bytesHeld].
+    // systemAllocs should stay flat once the first frames have run.
+    fun allocatorStats(): LongArray {
+        return getAllocatorStats(nativePtr)
+    }
+
+    // Native JPEG path counters: [frames, failures, skipped, lastUs, totalUs, lastScale].
+    // skipped frames were extrapolated without decoding; lastScale is the IDCT downscale (1-8).
+    fun jpegStats(): LongArray {
+        return getJpegStats(nativePtr)
     }
 
     fun release() {
+        stopPipeline(nativePtr)
         releaseDetector(nativePtr)
     }
 
@@ -28,6 +206,17 @@ class YOLODetector {
         init {
             System.loadLibrary("yolo11ncnn")
         }
+
+        // Capture time of a camera frame on the System.nanoTime() clock. The sensor stamps frames
+        // with elapsedRealtimeNanos() on devices whose timestamp source is REALTIME and with the
+        // monotonic clock otherwise; the two drift apart by the time spent in deep sleep. The
+        // stamp is taken to be on whichever clock it is closer to.
+        fun captureTimeNs(image: ImageProxy): Long {
+            val sensorNs = image.imageInfo.timestamp
+            val now = System.nanoTime()
+            val realtime = SystemClock.elapsedRealtimeNanos()
+            return if (abs(realtime - sensorNs) < abs(now - sensorNs)) sensorNs - (realtime - now) else sensorNs
+        }
     }
 
 }